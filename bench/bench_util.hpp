@@ -0,0 +1,99 @@
+#ifndef SMART_PTR_KIT_BENCH_UTIL_HPP
+#define SMART_PTR_KIT_BENCH_UTIL_HPP
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace bench {
+
+class timer {
+public:
+    timer() : m_start(std::chrono::steady_clock::now()) {}
+
+    double elapsed_ms() const {
+        auto d = std::chrono::steady_clock::now() - m_start;
+        return std::chrono::duration<double, std::milli>(d).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+// Returns the value following --name on the command line, or fallback
+inline long arg(int argc, char** argv, const char* name, long fallback) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (argv[i][0] == '-' && argv[i][1] == '-' && std::strcmp(argv[i] + 2, name) == 0) {
+            return std::strtol(argv[i + 1], nullptr, 10);
+        }
+    }
+    return fallback;
+}
+
+// Returns the word following --name on the command line, or fallback
+inline std::string text_arg(int argc, char** argv, const char* name, const char* fallback) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (argv[i][0] == '-' && argv[i][1] == '-' && std::strcmp(argv[i] + 2, name) == 0) {
+            return argv[i + 1];
+        }
+    }
+    return fallback;
+}
+
+// Parses a kernel cpulist such as "0-3,8-11"
+inline std::vector<int> parse_cpu_list(const std::string& list) {
+    std::vector<int> cpus;
+    std::size_t pos = 0;
+    while (pos < list.size()) {
+        std::size_t end = list.find(',', pos);
+        if (end == std::string::npos) end = list.size();
+        std::string range = list.substr(pos, end - pos);
+        std::size_t dash = range.find('-');
+        if (!range.empty()) {
+            int first = std::atoi(range.c_str());
+            int last = dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+            for (int c = first; c <= last; ++c) cpus.push_back(c);
+        }
+        pos = end + 1;
+    }
+    return cpus;
+}
+
+// CPUs belonging to a NUMA node, like `numactl --cpunodebind`; empty if unknown
+inline std::vector<int> node_cpus(int node) {
+    std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string list;
+    if (!in || !std::getline(in, list)) return {};
+    return parse_cpu_list(list);
+}
+
+// Pins the calling thread to one CPU; returns false if unsupported
+inline bool pin_to_cpu(int cpu) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+// Keeps the optimizer from discarding a computed value
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+} // namespace bench
+
+#endif // SMART_PTR_KIT_BENCH_UTIL_HPP
@@ -0,0 +1,62 @@
+// Deep-clones DAGs of doubling size and reports the cost per node, which
+// should stay flat if cloning is linear in graph size.
+//
+// Usage: deep_clone_bench [--nodes N] [--steps N] [--fanout N]
+
+#include <cstdio>
+#include <vector>
+
+#include "bench_util.hpp"
+#include "deep_clone.hpp"
+
+namespace {
+
+struct Node {
+    long value = 0;
+    std::vector<sptr::shared_ptr<Node>> edges;
+    sptr::weak_ptr<Node> parent;
+};
+
+template <typename Visitor>
+void sptr_visit_children(Node& n, Visitor& visit) {
+    for (auto& e : n.edges) visit(e);
+    visit(n.parent);
+}
+
+sptr::shared_ptr<Node> build(long nodes, long fanout) {
+    // Node i points at up to fanout earlier nodes, so most are shared
+    std::vector<sptr::shared_ptr<Node>> all;
+    all.reserve(static_cast<std::size_t>(nodes));
+    for (long i = 0; i < nodes; ++i) {
+        auto n = sptr::make_shared<Node>();
+        n->value = i;
+        for (long f = 1; f <= fanout && f <= i; ++f) {
+            auto& target = all[static_cast<std::size_t>(i - f * f) % all.size()];
+            n->edges.push_back(target);
+            target->parent = n;
+        }
+        all.push_back(n);
+    }
+    auto root = sptr::make_shared<Node>();
+    root->edges = all;
+    return root;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    long nodes = bench::arg(argc, argv, "nodes", 50000);
+    long steps = bench::arg(argc, argv, "steps", 5);
+    long fanout = bench::arg(argc, argv, "fanout", 4);
+
+    std::printf("%10s %12s %12s\n", "nodes", "clone ms", "ns/node");
+    for (long s = 0; s < steps; ++s, nodes *= 2) {
+        auto root = build(nodes, fanout);
+        bench::timer t;
+        auto copy = sptr::deep_clone(root);
+        double ms = t.elapsed_ms();
+        bench::do_not_optimize(copy.get());
+        std::printf("%10ld %12.2f %12.1f\n", nodes, ms, ms * 1e6 / static_cast<double>(nodes));
+    }
+    return 0;
+}
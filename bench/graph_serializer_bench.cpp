@@ -0,0 +1,65 @@
+// Serializes and restores a DAG with heavy sharing and reports throughput.
+//
+// Usage: graph_serializer_bench [--nodes N] [--payload BYTES] [--fanout N]
+
+#include <cstdio>
+#include <sstream>
+#include <vector>
+
+#include "bench_util.hpp"
+#include "graph_serializer.hpp"
+
+namespace {
+
+struct Node {
+    std::vector<char> payload;
+    std::vector<sptr::shared_ptr<Node>> edges;
+};
+
+void sptr_save(sptr::graph_writer& w, const Node& n) {
+    w.write(n.payload);
+    w.write(n.edges);
+}
+
+void sptr_load(sptr::graph_reader& r, Node& n) {
+    r.read(n.payload);
+    r.read(n.edges);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    long nodes = bench::arg(argc, argv, "nodes", 200000);
+    long payload = bench::arg(argc, argv, "payload", 256);
+    long fanout = bench::arg(argc, argv, "fanout", 4);
+
+    // Node i points at up to fanout earlier nodes, so most are shared
+    std::vector<sptr::shared_ptr<Node>> all;
+    all.reserve(static_cast<std::size_t>(nodes));
+    for (long i = 0; i < nodes; ++i) {
+        auto n = sptr::make_shared<Node>();
+        n->payload.assign(static_cast<std::size_t>(payload), static_cast<char>(i));
+        for (long f = 1; f <= fanout && f <= i; ++f) {
+            n->edges.push_back(all[static_cast<std::size_t>(i - f * f) % all.size()]);
+        }
+        all.push_back(n);
+    }
+    auto root = sptr::make_shared<Node>();
+    root->edges = all;
+
+    std::stringstream buffer;
+    bench::timer save_timer;
+    sptr::save_graph(buffer, root);
+    double save_ms = save_timer.elapsed_ms();
+    double mb = static_cast<double>(buffer.str().size()) / (1024.0 * 1024.0);
+
+    bench::timer load_timer;
+    auto copy = sptr::load_graph<Node>(buffer);
+    double load_ms = load_timer.elapsed_ms();
+    bench::do_not_optimize(copy.get());
+
+    std::printf("nodes=%ld payload=%ld fanout=%ld stream=%.1f MiB\n", nodes, payload, fanout, mb);
+    std::printf("save  %10.2f ms  %8.1f MiB/s\n", save_ms, mb / (save_ms / 1000.0));
+    std::printf("load  %10.2f ms  %8.1f MiB/s\n", load_ms, mb / (load_ms / 1000.0));
+    return 0;
+}
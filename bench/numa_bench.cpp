@@ -0,0 +1,76 @@
+// Compares make_shared against node-local make_shared_on_node with threads
+// pinned numactl-style to the CPUs of one node.
+//
+// Usage: numa_bench [--threads N] [--cpunodebind NODE] [--membind NODE]
+//                   [--objects N] [--copies N]
+// --membind -1 (default) allocates on the node of the calling thread.
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "bench_util.hpp"
+#include "numa_alloc.hpp"
+
+namespace {
+
+struct Payload {
+    long values[6] = {};
+};
+
+template <typename Make>
+double run(int threads, const std::vector<int>& cpus, long objects, long copies, Make make) {
+    bench::timer t;
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&, i] {
+            if (!cpus.empty()) bench::pin_to_cpu(cpus[static_cast<std::size_t>(i) % cpus.size()]);
+            std::vector<sptr::shared_ptr<Payload>> live;
+            live.reserve(static_cast<std::size_t>(objects));
+            for (long n = 0; n < objects; ++n) {
+                live.push_back(make());
+            }
+            // Refcount traffic against the control blocks just placed
+            for (long c = 0; c < copies; ++c) {
+                for (auto& p : live) {
+                    sptr::shared_ptr<Payload> copy = p;
+                    bench::do_not_optimize(copy.get());
+                }
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    return t.elapsed_ms();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int threads = static_cast<int>(bench::arg(argc, argv, "threads", 4));
+    int cpu_node = static_cast<int>(bench::arg(argc, argv, "cpunodebind", 0));
+    int mem_node = static_cast<int>(bench::arg(argc, argv, "membind", sptr::numa_local_node));
+    long objects = bench::arg(argc, argv, "objects", 200000);
+    long copies = bench::arg(argc, argv, "copies", 10);
+
+    std::vector<int> cpus = bench::node_cpus(cpu_node);
+    std::printf("nodes=%d threads=%d cpunodebind=%d membind=%d pinned_cpus=%zu\n",
+                sptr::numa_node_count(), threads, cpu_node, mem_node, cpus.size());
+
+    double baseline = run(threads, cpus, objects, copies, [] {
+        return sptr::make_shared<Payload>();
+    });
+    double on_node = run(threads, cpus, objects, copies, [mem_node] {
+        return sptr::make_shared_on_node<Payload>(mem_node);
+    });
+
+    std::printf("make_shared          %10.2f ms\n", baseline);
+    std::printf("make_shared_on_node  %10.2f ms\n", on_node);
+
+    for (int node = 0; node < sptr::numa_node_count(); ++node) {
+        auto stats = sptr::numa_stats(node);
+        std::printf("node %d: reserved=%zu live=%zu allocs=%zu frees=%zu bound=%d\n",
+                    node, stats.bytes_reserved, stats.bytes_live, stats.allocations,
+                    stats.deallocations, stats.bound ? 1 : 0);
+    }
+    return 0;
+}
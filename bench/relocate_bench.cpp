@@ -0,0 +1,58 @@
+// Compares std::vector and relocating_vector of shared_ptr on growth
+// (push_back without reserve) and on erasing from the front.
+//
+// Usage: relocate_bench [--elements N] [--erases N]
+
+#include <cstdio>
+#include <vector>
+
+#include "bench_util.hpp"
+#include "relocate.hpp"
+#include "shared_ptr.hpp"
+
+namespace {
+
+template <typename Vector>
+double grow(long elements, const sptr::shared_ptr<int>& value) {
+    bench::timer t;
+    Vector v;
+    for (long i = 0; i < elements; ++i) {
+        v.push_back(value);
+    }
+    double ms = t.elapsed_ms();
+    bench::do_not_optimize(v.data());
+    return ms;
+}
+
+template <typename Vector>
+double erase_front(long elements, long erases, const sptr::shared_ptr<int>& value) {
+    Vector v;
+    for (long i = 0; i < elements; ++i) {
+        v.push_back(value);
+    }
+    bench::timer t;
+    for (long i = 0; i < erases && !v.empty(); ++i) {
+        v.erase(v.begin());
+    }
+    double ms = t.elapsed_ms();
+    bench::do_not_optimize(v.data());
+    return ms;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    long elements = bench::arg(argc, argv, "elements", 4000000);
+    long erases = bench::arg(argc, argv, "erases", 50);
+    auto value = sptr::make_shared<int>(42);
+
+    using std_vector = std::vector<sptr::shared_ptr<int>>;
+    using reloc_vector = sptr::relocating_vector<sptr::shared_ptr<int>>;
+
+    std::printf("elements=%ld erases=%ld\n", elements, erases);
+    std::printf("grow   std::vector        %10.2f ms\n", grow<std_vector>(elements, value));
+    std::printf("grow   relocating_vector  %10.2f ms\n", grow<reloc_vector>(elements, value));
+    std::printf("erase  std::vector        %10.2f ms\n", erase_front<std_vector>(elements, erases, value));
+    std::printf("erase  relocating_vector  %10.2f ms\n", erase_front<reloc_vector>(elements, erases, value));
+    return 0;
+}
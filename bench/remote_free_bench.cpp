@@ -0,0 +1,103 @@
+// One producer creates objects, N consumers release them, so every release
+// is a cross-thread free. Compares global make_shared with the per-thread
+// pooled heaps and their batched remote-free lists.
+//
+// Usage: remote_free_bench [--consumers N] [--objects N]
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "bench_util.hpp"
+#include "pool_alloc.hpp"
+
+namespace {
+
+struct Message {
+    long payload[4] = {};
+};
+
+// Single-producer/single-consumer ring so the queue itself adds no contention
+class spsc_ring {
+public:
+    explicit spsc_ring(std::size_t capacity) : m_slots(capacity) {}
+
+    bool push(sptr::shared_ptr<Message>&& msg) {
+        std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == m_slots.size()) return false;
+        m_slots[tail % m_slots.size()] = std::move(msg);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(sptr::shared_ptr<Message>& out) {
+        std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) return false;
+        out = std::move(m_slots[head % m_slots.size()]);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::vector<sptr::shared_ptr<Message>> m_slots;
+    alignas(64) std::atomic<std::size_t> m_head{0};
+    alignas(64) std::atomic<std::size_t> m_tail{0};
+};
+
+template <typename Make>
+double run(int consumers, long objects, Make make) {
+    std::vector<std::unique_ptr<spsc_ring>> rings;
+    for (int i = 0; i < consumers; ++i) {
+        rings.push_back(std::make_unique<spsc_ring>(1024));
+    }
+    std::atomic<bool> done{false};
+
+    bench::timer t;
+    std::vector<std::thread> workers;
+    for (int i = 0; i < consumers; ++i) {
+        workers.emplace_back([&, i] {
+            sptr::shared_ptr<Message> msg;
+            for (;;) {
+                if (rings[i]->pop(msg)) {
+                    msg.reset();  // the remote free under test
+                } else if (done.load(std::memory_order_acquire)) {
+                    if (!rings[i]->pop(msg)) break;
+                    msg.reset();
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+            sptr::flush_remote_frees();
+        });
+    }
+    for (long n = 0; n < objects; ++n) {
+        auto msg = make();
+        spsc_ring& ring = *rings[static_cast<std::size_t>(n % consumers)];
+        while (!ring.push(std::move(msg))) {
+            std::this_thread::yield();
+        }
+    }
+    done.store(true, std::memory_order_release);
+    for (auto& w : workers) w.join();
+    return t.elapsed_ms();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int consumers = static_cast<int>(bench::arg(argc, argv, "consumers", 3));
+    long objects = bench::arg(argc, argv, "objects", 2000000);
+
+    double baseline = run(consumers, objects, [] { return sptr::make_shared<Message>(); });
+    double pooled = run(consumers, objects, [] { return sptr::make_shared_pooled<Message>(); });
+
+    auto stats = sptr::pool_counters();
+    std::printf("1 producer / %d consumers, %ld objects\n", consumers, objects);
+    std::printf("make_shared         %10.2f ms\n", baseline);
+    std::printf("make_shared_pooled  %10.2f ms\n", pooled);
+    std::printf("remote_frees=%zu batches=%zu drained=%zu local_frees=%zu\n",
+                stats.remote_frees, stats.remote_batches, stats.drained, stats.local_frees);
+    return 0;
+}
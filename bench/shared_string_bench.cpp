@@ -0,0 +1,95 @@
+// Copies and slices strings through std::string, shared_ptr<std::string>
+// and shared_string, single-threaded and from several threads at once.
+//
+// Usage: shared_string_bench [--length N] [--copies N] [--threads N]
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_util.hpp"
+#include "shared_string.hpp"
+
+namespace {
+
+// Runs body(copies) on `threads` threads and returns the wall time
+template <typename Body>
+double run(long threads, long copies, Body body) {
+    bench::timer t;
+    std::vector<std::thread> workers;
+    for (long i = 0; i < threads; ++i) {
+        workers.emplace_back([&body, copies] { body(copies); });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    return t.elapsed_ms();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    long length = bench::arg(argc, argv, "length", 64);
+    long copies = bench::arg(argc, argv, "copies", 5000000);
+    long threads = bench::arg(argc, argv, "threads", 4);
+
+    std::string source(static_cast<std::size_t>(length), 'x');
+    for (long i = 0; i < length; ++i) source[static_cast<std::size_t>(i)] = static_cast<char>('a' + i % 26);
+    std::size_t cut = source.size() / 4;
+
+    const std::string plain = source;
+    const sptr::shared_ptr<std::string> boxed = sptr::make_shared<std::string>(source);
+    const sptr::shared_string shared(source);
+
+    auto ns = [&](double ms, long n) { return ms * 1e6 / static_cast<double>(n); };
+    std::printf("length=%ld copies=%ld threads=%ld sizeof: string=%zu shared_ptr=%zu shared_string=%zu\n",
+                length, copies, threads, sizeof(std::string), sizeof(boxed), sizeof(shared));
+
+    for (long t : {1L, threads}) {
+        long total = copies * t;
+        double string_ms = run(t, copies, [&](long n) {
+            for (long i = 0; i < n; ++i) {
+                std::string copy = plain;
+                bench::do_not_optimize(copy);
+            }
+        });
+        double boxed_ms = run(t, copies, [&](long n) {
+            for (long i = 0; i < n; ++i) {
+                sptr::shared_ptr<std::string> copy = boxed;
+                bench::do_not_optimize(copy);
+            }
+        });
+        double shared_ms = run(t, copies, [&](long n) {
+            for (long i = 0; i < n; ++i) {
+                sptr::shared_string copy = shared;
+                bench::do_not_optimize(copy);
+            }
+        });
+        std::printf("copy  threads=%-3ld std::string %7.2f ns  shared_ptr<string> %7.2f ns  shared_string %7.2f ns\n",
+                    t, ns(string_ms, total), ns(boxed_ms, total), ns(shared_ms, total));
+    }
+
+    // Slicing off the first quarter: shared_ptr<string> has to copy too
+    double string_sub = run(1, copies, [&](long n) {
+        for (long i = 0; i < n; ++i) {
+            std::string part = plain.substr(cut);
+            bench::do_not_optimize(part);
+        }
+    });
+    double boxed_sub = run(1, copies, [&](long n) {
+        for (long i = 0; i < n; ++i) {
+            auto part = sptr::make_shared<std::string>(boxed->substr(cut));
+            bench::do_not_optimize(part);
+        }
+    });
+    double shared_sub = run(1, copies, [&](long n) {
+        for (long i = 0; i < n; ++i) {
+            sptr::shared_string part = shared.substr(cut);
+            bench::do_not_optimize(part);
+        }
+    });
+    std::printf("substr            std::string %7.2f ns  shared_ptr<string> %7.2f ns  shared_string %7.2f ns\n",
+                ns(string_sub, copies), ns(boxed_sub, copies), ns(shared_sub, copies));
+    return 0;
+}
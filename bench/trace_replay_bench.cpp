@@ -0,0 +1,273 @@
+// Replays a trace recorded by a -DSMART_PTR_KIT_TRACE=ON build (see
+// trace.hpp) against a chosen pointer family and allocator, so one captured
+// workload can be compared across configurations.
+//
+// The replay is single-threaded, in timestamp order: it reproduces the
+// sequence of counts and lifetimes, not the original contention. Objects are
+// rounded up to power-of-two sizes from 16 bytes to 64 KiB. Operations on
+// blocks made before tracing started, or otherwise out of step with the
+// replay, are skipped and counted as mismatches.
+//
+// Run it from a build without tracing; a tracing build would record the
+// replay itself.
+//
+// Usage: trace_replay_bench --trace FILE [--types sptr|std] [--alloc default|pool|huge|numa]
+//                           [--repeat N]
+
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+#include "bench_util.hpp"
+#include "huge_page_alloc.hpp"
+#include "numa_alloc.hpp"
+#include "pool_alloc.hpp"
+#include "shared_ptr.hpp"
+#include "trace.hpp"
+#include "weak_ptr.hpp"
+
+namespace {
+
+enum class alloc_policy { standard, pool, huge, numa };
+
+constexpr std::size_t bucket_count = 13;
+
+struct object_base {
+    std::uint32_t size;
+};
+
+template <std::size_t N>
+struct object : object_base {
+    object() {
+        size = N;
+        bytes[0] = 1;
+        bytes[sizeof(bytes) - 1] = 1;
+    }
+
+    unsigned char bytes[N - sizeof(object_base)];
+};
+
+std::size_t bucket_of(std::uint32_t bytes) {
+    std::size_t b = 0;
+    while (b + 1 < bucket_count && (std::size_t(16) << b) < bytes) ++b;
+    return b;
+}
+
+struct sptr_types {
+    template <typename T>
+    using shared = sptr::shared_ptr<T>;
+    template <typename T>
+    using weak = sptr::weak_ptr<T>;
+
+    template <typename T>
+    static shared<T> make() {
+        return sptr::make_shared<T>();
+    }
+
+    template <typename T, typename Alloc>
+    static shared<T> allocate(const Alloc& alloc) {
+        return sptr::allocate_shared<T>(alloc);
+    }
+};
+
+struct std_types {
+    template <typename T>
+    using shared = std::shared_ptr<T>;
+    template <typename T>
+    using weak = std::weak_ptr<T>;
+
+    template <typename T>
+    static shared<T> make() {
+        return std::make_shared<T>();
+    }
+
+    template <typename T, typename Alloc>
+    static shared<T> allocate(const Alloc& alloc) {
+        return std::allocate_shared<T>(alloc);
+    }
+};
+
+template <typename Types>
+using object_ptr = typename Types::template shared<object_base>;
+
+template <typename Types, std::size_t N>
+object_ptr<Types> create_sized(alloc_policy alloc) {
+    using T = object<N>;
+    switch (alloc) {
+    case alloc_policy::pool: return Types::template allocate<T>(sptr::pool_allocator<T>());
+    case alloc_policy::huge: return Types::template allocate<T>(sptr::huge_page_allocator<T>());
+    case alloc_policy::numa: return Types::template allocate<T>(sptr::numa_allocator<T>());
+    default: return Types::template make<T>();
+    }
+}
+
+template <typename Types, std::size_t... I>
+auto create_table(std::index_sequence<I...>) {
+    using fn = object_ptr<Types> (*)(alloc_policy);
+    return std::array<fn, sizeof...(I)>{{&create_sized<Types, std::size_t(16) << I>...}};
+}
+
+// A trace record with its block resolved to a dense slot: a new slot per
+// make, since a freed block's address is reused by later allocations
+struct step {
+    std::uint32_t slot;
+    std::uint32_t size;
+    sptr::trace_op op;
+};
+
+struct resolved_trace {
+    std::vector<step> steps;
+    // Slots the trace ever locks; only these keep a weak reference, which
+    // would otherwise hold every make_shared allocation to the end
+    std::vector<bool> locked;
+};
+
+resolved_trace resolve(const std::vector<sptr::trace_record>& records) {
+    std::unordered_map<std::uint64_t, std::uint32_t> live;
+    resolved_trace t;
+    t.steps.reserve(records.size());
+    for (const auto& r : records) {
+        auto it = live.find(r.block);
+        if (r.op == sptr::trace_op::make || it == live.end()) {
+            auto slot = static_cast<std::uint32_t>(t.locked.size());
+            t.locked.push_back(false);
+            if (it == live.end()) it = live.emplace(r.block, slot).first;
+            else it->second = slot;
+        }
+        if (r.op == sptr::trace_op::lock || r.op == sptr::trace_op::lock_failed) t.locked[it->second] = true;
+        t.steps.push_back(step{it->second, r.size, r.op});
+    }
+    return t;
+}
+
+// The replay's view of one block: the strong references it holds and a weak
+// one for lock()
+template <typename Types>
+struct slot_state {
+    std::vector<object_ptr<Types>> strong;
+    typename Types::template weak<object_base> weak;
+};
+
+struct result {
+    double ms;
+    std::size_t mismatches;
+};
+
+template <typename Types>
+result replay(const resolved_trace& trace, alloc_policy alloc) {
+    static const auto table = create_table<Types>(std::make_index_sequence<bucket_count>());
+    std::vector<slot_state<Types>> state(trace.locked.size());
+    std::size_t mismatches = 0;
+
+    bench::timer t;
+    for (const step& s : trace.steps) {
+        slot_state<Types>& b = state[s.slot];
+        switch (s.op) {
+        case sptr::trace_op::make:
+            b.strong.push_back(table[bucket_of(s.size)](alloc));
+            if (trace.locked[s.slot]) b.weak = b.strong.back();
+            break;
+        case sptr::trace_op::copy:
+            if (b.strong.empty()) {
+                ++mismatches;
+                break;
+            }
+            b.strong.push_back(b.strong.back());
+            break;
+        case sptr::trace_op::move: {
+            if (b.strong.empty()) {
+                ++mismatches;
+                break;
+            }
+            object_ptr<Types> moved = std::move(b.strong.back());
+            b.strong.back() = std::move(moved);
+            break;
+        }
+        case sptr::trace_op::release:
+            if (b.strong.empty()) {
+                ++mismatches;
+                break;
+            }
+            b.strong.pop_back();
+            break;
+        case sptr::trace_op::lock:
+        case sptr::trace_op::lock_failed: {
+            object_ptr<Types> locked = b.weak.lock();
+            if (static_cast<bool>(locked) != (s.op == sptr::trace_op::lock)) ++mismatches;
+            if (locked) b.strong.push_back(std::move(locked));
+            break;
+        }
+        case sptr::trace_op::dispose:
+            // The release before it dropped the last reference
+            if (!b.strong.empty()) {
+                ++mismatches;
+                b.strong.clear();
+            }
+            break;
+        }
+    }
+    double ms = t.elapsed_ms();
+    return result{ms, mismatches};
+}
+
+#if defined(__linux__)
+long peak_rss_kb() {
+    struct rusage usage;
+    return getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : -1;
+}
+#else
+long peak_rss_kb() {
+    return -1;
+}
+#endif
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string path = bench::text_arg(argc, argv, "trace", "sptr_trace.bin");
+    std::string types = bench::text_arg(argc, argv, "types", "sptr");
+    std::string alloc_name = bench::text_arg(argc, argv, "alloc", "default");
+    long repeat = bench::arg(argc, argv, "repeat", 1);
+
+    alloc_policy alloc = alloc_policy::standard;
+    if (alloc_name == "pool") alloc = alloc_policy::pool;
+    else if (alloc_name == "huge") alloc = alloc_policy::huge;
+    else if (alloc_name == "numa") alloc = alloc_policy::numa;
+    else if (alloc_name != "default") {
+        std::fprintf(stderr, "trace_replay_bench: unknown allocator %s\n", alloc_name.c_str());
+        return 2;
+    }
+    if (types != "sptr" && types != "std") {
+        std::fprintf(stderr, "trace_replay_bench: unknown types %s\n", types.c_str());
+        return 2;
+    }
+
+    std::vector<sptr::trace_record> records;
+    try {
+        records = sptr::load_trace(path);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "trace_replay_bench: %s\n", e.what());
+        return 1;
+    }
+    resolved_trace trace = resolve(records);
+    std::printf("trace=%s records=%zu blocks=%zu types=%s alloc=%s\n", path.c_str(), records.size(),
+                trace.locked.size(), types.c_str(), alloc_name.c_str());
+
+    for (long i = 0; i < repeat; ++i) {
+        result r = types == "std" ? replay<std_types>(trace, alloc) : replay<sptr_types>(trace, alloc);
+        double ops_per_sec = r.ms > 0 ? static_cast<double>(trace.steps.size()) * 1000.0 / r.ms : 0.0;
+        std::printf("  run %ld: %10.3f s  %12.0f ops/s  peak_rss=%ld KiB  mismatches=%zu\n", i + 1, r.ms / 1000.0,
+                    ops_per_sec, peak_rss_kb(), r.mismatches);
+    }
+    return 0;
+}
@@ -0,0 +1,66 @@
+// Locks every entry of a large, shuffled weak_ptr array with a plain lock()
+// loop and with lock_all / for_each_alive, whose prefetching should hide
+// most of the control-block misses.
+//
+// Usage: weak_scan_bench [--entries N] [--expired-pct P]
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "bench_util.hpp"
+#include "weak_scan.hpp"
+
+int main(int argc, char** argv) {
+    long entries = bench::arg(argc, argv, "entries", 10000000);
+    long expired_pct = bench::arg(argc, argv, "expired-pct", 10);
+
+    std::vector<sptr::shared_ptr<long>> owners;
+    owners.reserve(static_cast<std::size_t>(entries));
+    for (long i = 0; i < entries; ++i) {
+        owners.push_back(sptr::make_shared<long>(i));
+    }
+    // Shuffle so consecutive entries hit unrelated control blocks
+    std::vector<sptr::weak_ptr<long>> weak(owners.begin(), owners.end());
+    std::mt19937_64 rng(42);
+    std::shuffle(weak.begin(), weak.end(), rng);
+    for (long i = 0; i < entries; ++i) {
+        if (static_cast<long>(rng() % 100) < expired_pct) owners[static_cast<std::size_t>(i)].reset();
+    }
+
+    std::vector<sptr::shared_ptr<long>> out;
+    out.reserve(static_cast<std::size_t>(entries));
+
+    bench::timer plain_timer;
+    for (auto& w : weak) {
+        if (auto p = w.lock()) out.push_back(std::move(p));
+    }
+    double plain_ms = plain_timer.elapsed_ms();
+    std::size_t alive = out.size();
+    out.clear();
+
+    bench::timer bulk_timer;
+    sptr::lock_all(weak, std::back_inserter(out));
+    double bulk_ms = bulk_timer.elapsed_ms();
+    out.clear();
+
+    long sum = 0;
+    bench::timer visit_timer;
+    sptr::for_each_alive(weak, [&](long& v) { sum += v; });
+    double visit_ms = visit_timer.elapsed_ms();
+    bench::do_not_optimize(sum);
+
+    bench::timer compact_timer;
+    sptr::for_each_alive(weak, [&](long& v) { sum += v; }, sptr::compact_expired);
+    double compact_ms = compact_timer.elapsed_ms();
+    bench::do_not_optimize(sum);
+
+    auto ns = [&](double ms) { return ms * 1e6 / static_cast<double>(entries); };
+    std::printf("entries=%ld alive=%zu\n", entries, alive);
+    std::printf("lock() loop              %10.2f ms %6.2f ns/entry\n", plain_ms, ns(plain_ms));
+    std::printf("lock_all                 %10.2f ms %6.2f ns/entry\n", bulk_ms, ns(bulk_ms));
+    std::printf("for_each_alive           %10.2f ms %6.2f ns/entry\n", visit_ms, ns(visit_ms));
+    std::printf("for_each_alive + compact %10.2f ms %6.2f ns/entry\n", compact_ms, ns(compact_ms));
+    return 0;
+}
@@ -0,0 +1,41 @@
+#ifndef SMART_PTR_KIT_BUMP_ARENA_HPP
+#define SMART_PTR_KIT_BUMP_ARENA_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace sptr {
+
+namespace detail {
+    // Bump allocator over malloc()ed chunks, for regions whose objects all
+    // die together: nothing is freed until the arena itself goes. Not
+    // thread-safe; deep_clone and ownership_group build on it.
+    class bump_arena {
+    public:
+        bump_arena() = default;
+        ~bump_arena();
+
+        bump_arena(const bump_arena&) = delete;
+        bump_arena& operator=(const bump_arena&) = delete;
+
+        // Failure goes through the out-of-memory policy
+        void* allocate(std::size_t size, std::size_t align);
+
+        // Bytes taken from malloc() so far
+        std::size_t bytes_reserved() const noexcept {
+            return m_reserved;
+        }
+
+    private:
+        static constexpr std::size_t chunk_size = std::size_t(64) << 10;
+
+        std::vector<void*> m_chunks;
+        char* m_cursor = nullptr;
+        char* m_limit = nullptr;
+        std::size_t m_reserved = 0;
+    };
+}
+
+} // namespace sptr
+
+#endif // SMART_PTR_KIT_BUMP_ARENA_HPP
@@ -0,0 +1,197 @@
+#ifndef SMART_PTR_KIT_DEEP_CLONE_HPP
+#define SMART_PTR_KIT_DEEP_CLONE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "bump_arena.hpp"
+#include "oom_policy.hpp"
+#include "shared_ptr.hpp"
+#include "weak_ptr.hpp"
+
+namespace sptr {
+
+// deep_clone(root) copies every object strongly reachable from root exactly
+// once, however many edges share it, and rewires the copies to each other.
+//
+// Types opt in with an ADL hook that hands every pointer member to the
+// visitor; the hook runs on the freshly copy-constructed clone:
+//
+//     template <typename Visitor>
+//     void sptr_visit_children(Node& n, Visitor& visit) {
+//         for (auto& child : n.children) visit(child);
+//         visit(n.parent);  // weak_ptr
+//     }
+//
+// Objects are copied with their static type's copy constructor, so edges
+// must point at whole objects of that type (no aliasing or base pointers).
+// weak_ptr edges are fixed up after all strong edges: they point at the
+// clone when their target was cloned, and keep pointing at the original
+// otherwise. The walk uses a work queue, not recursion, and runs in time
+// linear in the number of objects plus edges.
+
+namespace detail {
+    // Monotonic arena shared by all clones of one deep_clone call. Memory is
+    // handed back in one go once the last clone's control block is destroyed.
+    class clone_arena {
+    public:
+        static clone_arena* create();
+
+        void* allocate(std::size_t size, std::size_t align);
+        // One per allocate(); the arena frees itself when the count drops to 0
+        void release() noexcept;
+        // Drops the reference held by the cloning pass itself
+        void close() noexcept {
+            release();
+        }
+
+    private:
+        clone_arena() = default;
+        ~clone_arena() = default;
+
+        bump_arena m_arena;
+        std::atomic<std::size_t> m_refs{1};
+    };
+
+    template <typename T>
+    class clone_arena_allocator {
+    public:
+        using value_type = T;
+
+        explicit clone_arena_allocator(clone_arena* arena) noexcept : m_arena(arena) {}
+
+        template <typename U>
+        clone_arena_allocator(const clone_arena_allocator<U>& other) noexcept
+            : m_arena(other.arena()) {}
+
+        T* allocate(std::size_t n) {
+            return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T*, std::size_t) noexcept {
+            m_arena->release();
+        }
+
+        clone_arena* arena() const noexcept {
+            return m_arena;
+        }
+
+    private:
+        clone_arena* m_arena;
+    };
+
+    class clone_context {
+    public:
+        explicit clone_context(clone_arena* arena) : m_arena(arena) {}
+
+        // Drops the identity map's references; clones nothing else points to
+        // (e.g. after a throwing copy constructor) die here
+        ~clone_context() {
+            for (control_block* ctrl : m_owned) {
+                ctrl->release();
+            }
+        }
+
+        clone_context(const clone_context&) = delete;
+        clone_context& operator=(const clone_context&) = delete;
+
+        template <typename U>
+        void operator()(shared_ptr<U>& edge) {
+            control_block* ctrl = shared_access::control(edge);
+            if (!ctrl || !edge) return;
+            auto it = m_clones.find(ctrl);
+            if (it == m_clones.end()) {
+                it = m_clones.emplace(ctrl, clone_one(*edge)).first;
+            }
+            edge = shared_access::share<U>(static_cast<U*>(it->second.object), it->second.ctrl);
+        }
+
+        template <typename U>
+        void operator()(weak_ptr<U>& edge) {
+            // Resolved once every strongly reachable object has been cloned
+            m_weak_edges.push_back(weak_edge{&edge, &fix_weak<U>});
+        }
+
+        template <typename T>
+        shared_ptr<T> run(const shared_ptr<T>& root) {
+            shared_ptr<T> result = root;
+            (*this)(result);
+            while (!m_queue.empty()) {
+                queued next = m_queue.front();
+                m_queue.pop_front();
+                next.visit(*this, next.object);
+            }
+            for (const weak_edge& w : m_weak_edges) {
+                w.fix(*this, w.edge);
+            }
+            return result;
+        }
+
+    private:
+        struct clone {
+            void* object;
+            control_block* ctrl;
+        };
+
+        struct queued {
+            void* object;
+            void (*visit)(clone_context&, void*);
+        };
+
+        struct weak_edge {
+            void* edge;
+            void (*fix)(clone_context&, void*);
+        };
+
+        template <typename U>
+        clone clone_one(const U& original) {
+            shared_ptr<U> copy = allocate_shared<U>(clone_arena_allocator<U>(m_arena), original);
+            control_block* ctrl = shared_access::control(copy);
+            // The identity map keeps the clone alive until the edges own it
+            ctrl->add_reference();
+            m_owned.push_back(ctrl);
+            m_queue.push_back(queued{copy.get(), &visit_clone<U>});
+            return clone{copy.get(), ctrl};
+        }
+
+        template <typename U>
+        static void visit_clone(clone_context& ctx, void* object) {
+            sptr_visit_children(*static_cast<U*>(object), ctx);
+        }
+
+        template <typename U>
+        static void fix_weak(clone_context& ctx, void* edge_ptr) {
+            weak_ptr<U>& edge = *static_cast<weak_ptr<U>*>(edge_ptr);
+            auto it = ctx.m_clones.find(shared_access::control(edge));
+            if (it != ctx.m_clones.end()) {
+                edge = shared_access::share<U>(static_cast<U*>(it->second.object), it->second.ctrl);
+            }
+        }
+
+        clone_arena* m_arena;
+        std::unordered_map<const control_block*, clone> m_clones;
+        std::deque<queued> m_queue;
+        std::vector<weak_edge> m_weak_edges;
+        std::vector<control_block*> m_owned;
+    };
+}
+
+template <typename T>
+shared_ptr<T> deep_clone(const shared_ptr<T>& root) {
+    detail::clone_arena* arena = detail::clone_arena::create();
+    SMART_PTR_KIT_TRY {
+        shared_ptr<T> result = detail::clone_context(arena).run(root);
+        arena->close();
+        return result;
+    } SMART_PTR_KIT_CATCH_ALL {
+        arena->close();
+        SMART_PTR_KIT_RETHROW;
+    }
+}
+
+} // namespace sptr
+
+#endif // SMART_PTR_KIT_DEEP_CLONE_HPP
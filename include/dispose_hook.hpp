@@ -0,0 +1,91 @@
+#ifndef SMART_PTR_KIT_DISPOSE_HOOK_HPP
+#define SMART_PTR_KIT_DISPOSE_HOOK_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "shared_ptr.hpp"
+
+namespace sptr {
+
+// A callback that runs once when the object owned by a shared_ptr dies,
+// right before its destructor (use_count() is already 0, so weak_ptrs to it
+// no longer lock). Lets indexes and caches drop their entry for an object
+// in O(1) instead of polling expired() across a table.
+//
+// The hook is the list node: the control block only holds the list head, so
+// registering never allocates unless the callback is larger than
+// inline_size bytes. Destroying or reset()ing the hook unregisters it; if the
+// callback is running on another thread at that moment, this waits for it
+// to finish. A callback may destroy its own hook. Callbacks must not throw.
+//
+// Hooks are neither copyable nor movable; create them in place:
+//
+//     sptr::dispose_hook hook = sptr::on_dispose(p, [&] { index.erase(key); });
+class dispose_hook {
+public:
+    static constexpr std::size_t inline_size = 3 * sizeof(void*);
+
+    dispose_hook() noexcept = default;
+
+    template <typename T, typename F>
+    dispose_hook(const shared_ptr<T>& owner, F callback) {
+        using callable = std::decay_t<F>;
+        if constexpr (sizeof(callable) <= inline_size && alignof(callable) <= alignof(std::max_align_t)) {
+            new(&m_storage) callable(std::move(callback));
+            m_invoke = [](dispose_hook& h) { (*reinterpret_cast<callable*>(&h.m_storage))(); };
+            m_drop = [](dispose_hook& h) noexcept { reinterpret_cast<callable*>(&h.m_storage)->~callable(); };
+        } else {
+            new(&m_storage) callable*(new callable(std::move(callback)));
+            m_invoke = [](dispose_hook& h) { (**reinterpret_cast<callable**>(&h.m_storage))(); };
+            m_drop = [](dispose_hook& h) noexcept { delete *reinterpret_cast<callable**>(&h.m_storage); };
+        }
+        link(detail::shared_access::control(owner));
+    }
+
+    ~dispose_hook() {
+        reset();
+        if (m_drop) m_drop(*this);
+    }
+
+    dispose_hook(const dispose_hook&) = delete;
+    dispose_hook& operator=(const dispose_hook&) = delete;
+
+    // Unregisters the callback; it will not run after this returns
+    void reset() noexcept;
+
+    // Registered and not yet run
+    bool armed() const noexcept;
+
+private:
+    friend void detail::run_dispose_hooks(detail::control_block& ctrl) noexcept;
+
+    enum state : int { idle, linked, running };
+
+    void link(detail::control_block* ctrl) noexcept;
+    void unlink() noexcept;
+
+    detail::control_block* m_ctrl = nullptr;
+    dispose_hook* m_prev = nullptr;
+    dispose_hook* m_next = nullptr;
+    std::atomic<int> m_state{idle};
+    std::thread::id m_runner;
+    // Set while running; tells the runner the hook went away under it
+    bool* m_gone = nullptr;
+    void (*m_invoke)(dispose_hook&) = nullptr;
+    void (*m_drop)(dispose_hook&) noexcept = nullptr;
+    alignas(std::max_align_t) unsigned char m_storage[inline_size];
+};
+
+template <typename T, typename F>
+dispose_hook on_dispose(const shared_ptr<T>& owner, F callback) {
+    return dispose_hook(owner, std::move(callback));
+}
+
+} // namespace sptr
+
+#endif // SMART_PTR_KIT_DISPOSE_HOOK_HPP
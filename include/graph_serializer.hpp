@@ -0,0 +1,248 @@
+#ifndef SMART_PTR_KIT_GRAPH_SERIALIZER_HPP
+#define SMART_PTR_KIT_GRAPH_SERIALIZER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "pool_alloc.hpp"
+#include "shared_ptr.hpp"
+#include "weak_ptr.hpp"
+
+namespace sptr {
+
+// Streaming binary (de)serializer for graphs of shared_ptr-linked objects.
+//
+// Each control block reachable from the root gets an id the first time it is
+// mentioned, and its object is written exactly once. Objects are written
+// breadth-first from a work queue rather than by recursion, so long chains do
+// not grow the stack. weak_ptr edges are restored when their target is part
+// of the graph and come back expired otherwise.
+//
+// Types opt in through two ADL hooks, and must be default constructible:
+//
+//     void sptr_save(sptr::graph_writer& w, const Node& n);
+//     void sptr_load(sptr::graph_reader& r, Node& n);
+//
+// Pointers are serialized with their static type; polymorphic pointees are
+// not supported. An object is identified by its control block, address and
+// type together, so aliasing pointers (to a member, or into an
+// ownership_group) come back as objects of their own rather than sharing the
+// block they were carved from. Pointers with no control block at all, such
+// as persistent_heap::share() results, cannot be written. Both ends buffer;
+// the reader may consume bytes past the end of the graph from its stream.
+
+class graph_format_error : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+class graph_writer {
+public:
+    explicit graph_writer(std::ostream& out, std::size_t buffer_size = std::size_t(1) << 20);
+    ~graph_writer();
+
+    graph_writer(const graph_writer&) = delete;
+    graph_writer& operator=(const graph_writer&) = delete;
+
+    template <typename T>
+    std::enable_if_t<std::is_trivially_copyable_v<T>> write(const T& value) {
+        write_bytes(&value, sizeof(T));
+    }
+
+    void write(const std::string& value);
+
+    template <typename T>
+    void write(const std::vector<T>& values) {
+        write_varint(values.size());
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            write_bytes(values.data(), values.size() * sizeof(T));
+        } else {
+            for (const T& v : values) write(v);
+        }
+    }
+
+    template <typename T>
+    void write(const shared_ptr<T>& p) {
+        write_reference(p.get(), detail::shared_access::control(p), &save_object<T>);
+    }
+
+    template <typename T>
+    void write(const weak_ptr<T>& p) {
+        // Lock so the target cannot die before its queued payload is written
+        shared_ptr<T> target = p.lock();
+        write_reference(target.get(), detail::shared_access::control(target), &save_object<T>);
+    }
+
+    void write_bytes(const void* data, std::size_t size);
+    void write_varint(std::uint64_t value);
+
+    // Writes everything still queued plus the end marker, then flushes
+    void finish();
+
+    std::size_t objects_written() const noexcept {
+        return m_next_id;
+    }
+
+private:
+    using save_fn = void (*)(graph_writer&, const void*);
+
+    // What makes two edges the same object: the same block, address and type
+    struct object_key {
+        const detail::control_block* ctrl;
+        const void* object;
+        save_fn save;
+
+        bool operator==(const object_key& other) const noexcept {
+            return ctrl == other.ctrl && object == other.object && save == other.save;
+        }
+    };
+
+    struct object_key_hash {
+        std::size_t operator()(const object_key& key) const noexcept {
+            std::size_t h = std::hash<const void*>()(key.ctrl);
+            h = h * 31 + std::hash<const void*>()(key.object);
+            return h * 31 + std::hash<save_fn>()(key.save);
+        }
+    };
+
+    struct pending {
+        const void* object;
+        detail::control_block* ctrl;  // holds a reference until written
+        save_fn save;
+    };
+
+    template <typename T>
+    static void save_object(graph_writer& w, const void* object) {
+        sptr_save(w, *static_cast<const T*>(object));
+    }
+
+    void write_reference(const void* object, detail::control_block* ctrl, save_fn save);
+    void flush_buffer();
+
+    std::ostream& m_out;
+    std::vector<char> m_buffer;
+    std::size_t m_used = 0;
+    std::unordered_map<object_key, std::uint64_t, object_key_hash> m_ids;
+    std::deque<pending> m_queue;
+    std::uint64_t m_next_id = 0;
+    bool m_finished = false;
+};
+
+class graph_reader {
+public:
+    explicit graph_reader(std::istream& in, std::size_t buffer_size = std::size_t(1) << 20);
+    ~graph_reader();
+
+    graph_reader(const graph_reader&) = delete;
+    graph_reader& operator=(const graph_reader&) = delete;
+
+    template <typename T>
+    std::enable_if_t<std::is_trivially_copyable_v<T>> read(T& value) {
+        read_bytes(&value, sizeof(T));
+    }
+
+    void read(std::string& value);
+
+    template <typename T>
+    void read(std::vector<T>& values) {
+        values.resize(checked_count(read_varint(), sizeof(T)));
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            read_bytes(values.data(), values.size() * sizeof(T));
+        } else {
+            for (T& v : values) read(v);
+        }
+    }
+
+    template <typename T>
+    void read(shared_ptr<T>& p) {
+        slot* s = read_reference(&create_object<T>, &load_object<T>);
+        p = s ? detail::shared_access::share<T>(static_cast<T*>(s->object), s->ctrl) : shared_ptr<T>();
+    }
+
+    template <typename T>
+    void read(weak_ptr<T>& p) {
+        shared_ptr<T> strong;
+        read(strong);
+        p = strong;
+    }
+
+    void read_bytes(void* data, std::size_t size);
+    std::uint64_t read_varint();
+
+    // Loads every object still owed, checks the end marker and drops the
+    // reader's own references (objects only weakly reachable die here)
+    void finish();
+
+    std::size_t objects_read() const noexcept {
+        return m_slots.size();
+    }
+
+private:
+    using load_fn = void (*)(graph_reader&, void*);
+
+    struct slot {
+        void* object;
+        detail::control_block* ctrl;  // the reader's own reference
+        load_fn load;
+    };
+
+    using create_fn = slot (*)();
+
+    // Restored objects come from the pooled per-thread heaps, which carve
+    // control blocks out of whole pages instead of one malloc each
+    template <typename T>
+    static slot create_object() {
+        shared_ptr<T> p = make_shared_pooled<T>();
+        detail::control_block* ctrl = detail::shared_access::control(p);
+        ctrl->add_reference();
+        return slot{p.get(), ctrl, nullptr};
+    }
+
+    template <typename T>
+    static void load_object(graph_reader& r, void* object) {
+        sptr_load(r, *static_cast<T*>(object));
+    }
+
+    slot* read_reference(create_fn create, load_fn load);
+    std::size_t checked_count(std::uint64_t count, std::size_t element_size);
+    void refill();
+    void release_slots() noexcept;
+
+    std::istream& m_in;
+    std::vector<char> m_buffer;
+    std::size_t m_pos = 0;
+    std::size_t m_end = 0;
+    std::vector<slot> m_slots;
+    std::size_t m_next_to_load = 0;
+    bool m_finished = false;
+};
+
+// Convenience wrappers for a single-rooted graph
+template <typename T>
+void save_graph(std::ostream& out, const shared_ptr<T>& root) {
+    graph_writer writer(out);
+    writer.write(root);
+    writer.finish();
+}
+
+template <typename T>
+shared_ptr<T> load_graph(std::istream& in) {
+    graph_reader reader(in);
+    shared_ptr<T> root;
+    reader.read(root);
+    reader.finish();
+    return root;
+}
+
+} // namespace sptr
+
+#endif // SMART_PTR_KIT_GRAPH_SERIALIZER_HPP
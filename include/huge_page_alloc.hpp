@@ -0,0 +1,140 @@
+#ifndef SMART_PTR_KIT_HUGE_PAGE_ALLOC_HPP
+#define SMART_PTR_KIT_HUGE_PAGE_ALLOC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+#include "oom_policy.hpp"
+#include "shared_ptr.hpp"
+#include "unique_ptr.hpp"
+
+namespace sptr {
+
+struct huge_page_config {
+    // Requests of at least this many bytes are backed by 2 MiB pages
+    std::size_t threshold = std::size_t(2) << 20;
+    // Try MAP_HUGETLB (needs pages reserved in vm.nr_hugepages) before
+    // falling back to transparent huge pages
+    bool use_hugetlb = true;
+    // madvise(MADV_HUGEPAGE) the control-block slabs of the node arenas
+    bool advise_slabs = true;
+};
+
+void set_huge_page_config(const huge_page_config& config) noexcept;
+huge_page_config get_huge_page_config() noexcept;
+
+// Live byte counts by backing, plus how often MAP_HUGETLB had to fall back.
+// MAP_HUGETLB mappings are huge pages for certain; the "advised" counts only
+// say the kernel took MADV_HUGEPAGE with THP enabled, and it may still leave
+// parts on 4 KiB pages (AnonHugePages in /proc/self/smaps has the truth).
+struct huge_page_stats {
+    std::size_t hugetlb_bytes = 0;       // explicit MAP_HUGETLB mappings
+    std::size_t thp_advised_bytes = 0;   // large mappings advised MADV_HUGEPAGE
+    std::size_t slab_advised_bytes = 0;  // arena slabs advised MADV_HUGEPAGE
+    std::size_t fallback_bytes = 0;      // large mappings left on 4 KiB pages
+    std::size_t small_bytes = 0;         // below threshold, from operator new
+    std::size_t hugetlb_failures = 0;
+};
+
+huge_page_stats huge_page_counters() noexcept;
+
+namespace detail {
+    // Every block carries a small header in front of it, so deallocation needs
+    // only the pointer. Throws std::bad_alloc on failure.
+    void* huge_allocate(std::size_t size, std::size_t align);
+    void huge_deallocate(void* p) noexcept;
+
+    // Spare header word; make_unique_huge keeps the element count here
+    std::size_t& huge_user_word(void* p) noexcept;
+
+    // Applies the slab policy to an arena chunk; returns whether advice was taken
+    bool advise_huge_slab(void* p, std::size_t size) noexcept;
+}
+
+// Stateless allocator that switches to huge pages above the threshold; use
+// with allocate_shared, e.g. allocate_shared<T[]>(huge_page_allocator<T>(), n)
+template <typename T>
+class huge_page_allocator {
+public:
+    using value_type = T;
+
+    huge_page_allocator() noexcept = default;
+
+    template <typename U>
+    huge_page_allocator(const huge_page_allocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        if (n > SIZE_MAX / sizeof(T)) SMART_PTR_KIT_OUT_OF_MEMORY(SIZE_MAX);
+        return static_cast<T*>(detail::huge_allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t) noexcept {
+        detail::huge_deallocate(p);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const huge_page_allocator<T>&, const huge_page_allocator<U>&) noexcept {
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const huge_page_allocator<T>&, const huge_page_allocator<U>&) noexcept {
+    return false;
+}
+
+template <typename T>
+struct huge_page_delete;
+
+template <typename T>
+struct huge_page_delete<T[]> {
+    void operator()(T* p) const noexcept {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            std::size_t n = detail::huge_user_word(p);
+            for (std::size_t i = n; i > 0; --i) {
+                p[i - 1].~T();
+            }
+        }
+        detail::huge_deallocate(p);
+    }
+};
+
+// make_unique<T[]> whose buffer is huge-page backed once it crosses the
+// threshold. default_init skips value-initialization, so untouched pages of a
+// large trivially-constructible buffer are never faulted in.
+template <typename T>
+std::enable_if_t<detail::is_unbounded_array_v<T>, unique_ptr<T, huge_page_delete<T>>>
+make_unique_huge(std::size_t n, bool default_init = false) {
+    using element = std::remove_extent_t<T>;
+    if (n > SIZE_MAX / sizeof(element)) SMART_PTR_KIT_OUT_OF_MEMORY(SIZE_MAX);
+    element* p = static_cast<element*>(detail::huge_allocate(n * sizeof(element), alignof(element)));
+    std::size_t i = 0;
+    SMART_PTR_KIT_TRY {
+        for (; i < n; ++i) {
+            if (default_init) {
+                new(p + i) element;
+            } else {
+                new(p + i) element();
+            }
+        }
+    } SMART_PTR_KIT_CATCH_ALL {
+        for (; i > 0; --i) {
+            p[i - 1].~element();
+        }
+        detail::huge_deallocate(p);
+        SMART_PTR_KIT_RETHROW;
+    }
+    detail::huge_user_word(p) = n;
+    return unique_ptr<T, huge_page_delete<T>>(p);
+}
+
+template <typename T>
+std::enable_if_t<detail::is_unbounded_array_v<T>, shared_ptr<T>> make_shared_huge(std::size_t n) {
+    return allocate_shared<T>(huge_page_allocator<std::remove_extent_t<T>>(), n);
+}
+
+} // namespace sptr
+
+#endif // SMART_PTR_KIT_HUGE_PAGE_ALLOC_HPP
@@ -0,0 +1,131 @@
+#ifndef SMART_PTR_KIT_LAZY_SHARED_HPP
+#define SMART_PTR_KIT_LAZY_SHARED_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "oom_policy.hpp"
+#include "shared_ptr.hpp"
+
+namespace sptr {
+
+// A shared object built on first use, for expensive singletons such as
+// dictionaries and models. The first caller of get() runs the factory and
+// builds the object with make_shared; callers arriving meanwhile sleep on a
+// futex until it is published. From then on get() is one acquire load: no
+// lock and no reference count traffic.
+//
+// The factory returns either a T, which is moved into make_shared<T>, or a
+// ready shared_ptr<T>. If it throws, the exception reaches the caller that
+// ran it and the next get() tries again; a null shared_ptr counts as a
+// failure and throws std::logic_error. The factory is dropped once it has
+// succeeded.
+template <typename T>
+class lazy_shared {
+public:
+    using element_type = T;
+
+    // Default-constructs the T on first use
+    lazy_shared() : m_factory([] { return make_shared<T>(); }) {}
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, lazy_shared>>>
+    explicit lazy_shared(F&& factory) : m_factory(wrap(std::forward<F>(factory))) {}
+
+    lazy_shared(const lazy_shared&) = delete;
+    lazy_shared& operator=(const lazy_shared&) = delete;
+
+    T& get() {
+        T* p = m_ptr.load(std::memory_order_acquire);
+        if (p) {
+            return *p;
+        }
+        return *initialize();
+    }
+
+    T& operator*() {
+        return get();
+    }
+
+    T* operator->() {
+        return &get();
+    }
+
+    // Owning copy of the object, building it if needed
+    shared_ptr<T> get_shared() {
+        get();
+        return m_owner;
+    }
+
+    // Built already; never blocks and never builds
+    bool ready() const noexcept {
+        return m_ptr.load(std::memory_order_acquire) != nullptr;
+    }
+
+private:
+    enum : std::uint32_t { empty, building, building_waited, done };
+
+    template <typename F>
+    static std::function<shared_ptr<T>()> wrap(F&& factory) {
+        using result = std::decay_t<std::invoke_result_t<F&>>;
+        if constexpr (std::is_same_v<result, shared_ptr<T>>) {
+            return std::forward<F>(factory);
+        } else {
+            static_assert(std::is_constructible_v<T, result>,
+                          "lazy_shared factory must return a T or a shared_ptr<T>");
+            return [f = std::forward<F>(factory)]() mutable { return make_shared<T>(f()); };
+        }
+    }
+
+    T* initialize() {
+        for (;;) {
+            std::uint32_t state = empty;
+            if (m_state.compare_exchange_strong(state, building, std::memory_order_acquire)) {
+                break;
+            }
+            if (state == done) {
+                return m_ptr.load(std::memory_order_acquire);
+            }
+            // Someone else is building: announce ourselves and sleep
+            if (state == building &&
+                !m_state.compare_exchange_strong(state, building_waited, std::memory_order_acquire)) {
+                continue;
+            }
+            detail::futex_wait(m_state, building_waited);
+        }
+
+        SMART_PTR_KIT_TRY {
+            m_owner = m_factory();
+        } SMART_PTR_KIT_CATCH_ALL {
+            publish(empty);
+            SMART_PTR_KIT_RETHROW;
+        }
+        if (!m_owner) {
+            publish(empty);
+            SMART_PTR_KIT_THROW(std::logic_error("sptr: lazy_shared factory returned a null pointer"));
+        }
+        m_factory = nullptr;
+        T* p = m_owner.get();
+        m_ptr.store(p, std::memory_order_release);
+        publish(done);
+        return p;
+    }
+
+    void publish(std::uint32_t state) noexcept {
+        if (m_state.exchange(state, std::memory_order_release) == building_waited) {
+            detail::futex_wake_all(m_state);
+        }
+    }
+
+    std::atomic<T*> m_ptr{nullptr};
+    std::atomic<std::uint32_t> m_state{empty};
+    shared_ptr<T> m_owner;
+    std::function<shared_ptr<T>()> m_factory;
+};
+
+} // namespace sptr
+
+#endif // SMART_PTR_KIT_LAZY_SHARED_HPP
@@ -0,0 +1,185 @@
+#ifndef SMART_PTR_KIT_MEMORY_DOMAIN_HPP
+#define SMART_PTR_KIT_MEMORY_DOMAIN_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <string>
+#include <utility>
+
+#include "oom_policy.hpp"
+#include "shared_ptr.hpp"
+#include "unique_ptr.hpp"
+
+namespace sptr {
+
+// Thrown when an allocation would push a domain past its hard limit
+class domain_limit_exceeded : public std::bad_alloc {
+public:
+    const char* what() const noexcept override {
+        return "sptr: memory domain hard limit exceeded";
+    }
+};
+
+// An accounting bucket (e.g. one per tenant) that smart-pointer allocations
+// are charged to. Threads are assigned round-robin, on first use, to one of
+// shard_count shards; a shard is shared by every thread mapped to it. The
+// central counter holds all bytes reserved by the shards, and each shard
+// hands out its unused reservation locally, going back to the centre about
+// once per quantum. Reserving from the centre is a CAS against the hard
+// limit, so the limit is exact: when it is close, idle reservations are
+// pulled back before an allocation is refused. live_bytes() is a single
+// load that over-estimates by the shards' unused reservations (under
+// 2 * quantum each).
+//
+// A domain must outlive every allocation charged to it.
+class memory_domain {
+public:
+    using limit_callback = std::function<void(memory_domain&, std::size_t live_bytes)>;
+
+    static constexpr std::size_t shard_count = 16;
+    static constexpr long quantum = 16 * 1024;
+    static constexpr std::size_t no_limit = 0;
+
+    explicit memory_domain(std::string name = std::string());
+
+    memory_domain(const memory_domain&) = delete;
+    memory_domain& operator=(const memory_domain&) = delete;
+
+    // Called once each time live bytes cross the soft limit from below. It
+    // runs inside allocation and deallocation paths that cannot fail, so
+    // anything it throws is caught and dropped there.
+    void set_soft_limit(std::size_t bytes, limit_callback on_exceeded);
+    // Allocations that would exceed this fail with domain_limit_exceeded
+    void set_hard_limit(std::size_t bytes) noexcept;
+
+    std::size_t soft_limit() const noexcept;
+    std::size_t hard_limit() const noexcept;
+
+    // Cheap estimate, at most shard_count * 2 * quantum too high
+    std::size_t live_bytes() const noexcept;
+    // Exact sum over all shards
+    std::size_t live_bytes_exact() const noexcept;
+    // Allocations refused because of the hard limit
+    std::size_t rejected() const noexcept;
+
+    const std::string& name() const noexcept {
+        return m_name;
+    }
+
+    // Returns false (and charges nothing) if the hard limit would be exceeded
+    bool try_charge(std::size_t bytes) noexcept;
+    void credit(std::size_t bytes) noexcept;
+
+private:
+    struct alignas(64) shard {
+        // Reserved from m_central but not yet charged
+        std::atomic<long> budget{0};
+    };
+
+    bool reserve(long bytes) noexcept;
+    void drain_shards() noexcept;
+    void check_soft_limit(long live) noexcept;
+
+    std::string m_name;
+    std::array<shard, shard_count> m_shards;
+    alignas(64) std::atomic<long> m_central{0};
+    std::atomic<std::size_t> m_soft_limit{no_limit};
+    std::atomic<std::size_t> m_hard_limit{no_limit};
+    std::atomic<bool> m_soft_exceeded{false};
+    std::atomic<std::size_t> m_rejected{0};
+    std::mutex m_callback_mutex;
+    limit_callback m_on_soft_limit;
+};
+
+// Allocator that charges every allocation to a domain before taking it from
+// the global heap, and credits it back on deallocation
+template <typename T>
+class domain_allocator {
+public:
+    using value_type = T;
+
+    explicit domain_allocator(memory_domain& domain) noexcept : m_domain(&domain) {}
+
+    template <typename U>
+    domain_allocator(const domain_allocator<U>& other) noexcept : m_domain(&other.domain()) {}
+
+    T* allocate(std::size_t n) {
+        if (n > SIZE_MAX / sizeof(T)) SMART_PTR_KIT_OUT_OF_MEMORY(SIZE_MAX);
+        std::size_t bytes = n * sizeof(T);
+        if (!m_domain->try_charge(bytes)) {
+            SMART_PTR_KIT_THROW(domain_limit_exceeded());
+        }
+        void* p = ::operator new(bytes, std::align_val_t(alignof(T)), std::nothrow);
+        if (!p) {
+            m_domain->credit(bytes);
+            SMART_PTR_KIT_OUT_OF_MEMORY(bytes);
+        }
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        ::operator delete(p, std::align_val_t(alignof(T)));
+        m_domain->credit(n * sizeof(T));
+    }
+
+    memory_domain& domain() const noexcept {
+        return *m_domain;
+    }
+
+private:
+    memory_domain* m_domain;
+};
+
+template <typename T, typename U>
+bool operator==(const domain_allocator<T>& a, const domain_allocator<U>& b) noexcept {
+    return &a.domain() == &b.domain();
+}
+
+template <typename T, typename U>
+bool operator!=(const domain_allocator<T>& a, const domain_allocator<U>& b) noexcept {
+    return !(a == b);
+}
+
+template <typename T>
+class domain_delete {
+public:
+    domain_delete() noexcept : m_domain(nullptr) {}
+    explicit domain_delete(memory_domain& domain) noexcept : m_domain(&domain) {}
+
+    void operator()(T* p) const noexcept {
+        domain_allocator<T> alloc(*m_domain);
+        p->~T();
+        alloc.deallocate(p, 1);
+    }
+
+private:
+    memory_domain* m_domain;
+};
+
+// Charges control block + object to domain; credited again on destroy()
+template <typename T, typename... Args>
+shared_ptr<T> make_shared_in(memory_domain& domain, Args&&... args) {
+    return allocate_shared<T>(domain_allocator<T>(domain), std::forward<Args>(args)...);
+}
+
+template <typename T, typename... Args>
+unique_ptr<T, domain_delete<T>> make_unique_in(memory_domain& domain, Args&&... args) {
+    domain_allocator<T> alloc(domain);
+    T* p = alloc.allocate(1);
+    SMART_PTR_KIT_TRY {
+        new(p) T(std::forward<Args>(args)...);
+    } SMART_PTR_KIT_CATCH_ALL {
+        alloc.deallocate(p, 1);
+        SMART_PTR_KIT_RETHROW;
+    }
+    return unique_ptr<T, domain_delete<T>>(p, domain_delete<T>(domain));
+}
+
+} // namespace sptr
+
+#endif // SMART_PTR_KIT_MEMORY_DOMAIN_HPP
@@ -0,0 +1,127 @@
+#ifndef SMART_PTR_KIT_NUMA_ALLOC_HPP
+#define SMART_PTR_KIT_NUMA_ALLOC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+#include "oom_policy.hpp"
+#include "shared_ptr.hpp"
+#include "unique_ptr.hpp"
+
+namespace sptr {
+
+// Node id meaning "whatever node the calling thread is running on"
+inline constexpr int numa_local_node = -1;
+
+// Number of configured NUMA nodes (1 on non-NUMA or non-Linux hosts)
+int numa_node_count() noexcept;
+
+// Node of the CPU the calling thread is currently running on
+int current_numa_node() noexcept;
+
+// Node the kernel reports for the page holding p, or -1 if unknown
+int numa_node_of(const void* p) noexcept;
+
+struct numa_node_stats {
+    std::size_t bytes_reserved = 0;  // mapped from the OS for this node's arena
+    std::size_t bytes_live = 0;      // handed out and not yet returned
+    std::size_t allocations = 0;
+    std::size_t deallocations = 0;
+    bool bound = false;              // arena memory was successfully mbind()-ed
+};
+
+// Snapshot of one node arena's counters
+numa_node_stats numa_stats(int node);
+
+namespace detail {
+    // Allocates from the arena of the given node (numa_local_node resolves to
+    // the caller's node). Throws std::bad_alloc on failure and
+    // std::invalid_argument for an unknown node.
+    void* numa_allocate(std::size_t size, std::size_t align, int node);
+
+    // size and align must match the numa_allocate call
+    void numa_deallocate(void* p, std::size_t size, std::size_t align) noexcept;
+}
+
+// Allocator handing out memory from a per-node arena; usable with
+// allocate_shared and standard containers
+template <typename T>
+class numa_allocator {
+public:
+    using value_type = T;
+
+    explicit numa_allocator(int node = numa_local_node) noexcept : m_node(node) {}
+
+    template <typename U>
+    numa_allocator(const numa_allocator<U>& other) noexcept : m_node(other.node()) {}
+
+    T* allocate(std::size_t n) {
+        if (n > SIZE_MAX / sizeof(T)) SMART_PTR_KIT_OUT_OF_MEMORY(SIZE_MAX);
+        return static_cast<T*>(detail::numa_allocate(n * sizeof(T), alignof(T), m_node));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        detail::numa_deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    int node() const noexcept {
+        return m_node;
+    }
+
+private:
+    int m_node;
+};
+
+template <typename T, typename U>
+bool operator==(const numa_allocator<T>& a, const numa_allocator<U>& b) noexcept {
+    return a.node() == b.node();
+}
+
+template <typename T, typename U>
+bool operator!=(const numa_allocator<T>& a, const numa_allocator<U>& b) noexcept {
+    return !(a == b);
+}
+
+// Deleter for objects created by make_unique_on_node. Stateless: the arena
+// recovers the owning node from the address.
+template <typename T>
+struct numa_delete {
+    void operator()(T* p) const noexcept {
+        p->~T();
+        detail::numa_deallocate(p, sizeof(T), alignof(T));
+    }
+};
+
+// make_shared with the control block and object placed on the given node
+template <typename T, typename... Args>
+shared_ptr<T> make_shared_on_node(int node, Args&&... args) {
+    return allocate_shared<T>(numa_allocator<T>(node), std::forward<Args>(args)...);
+}
+
+template <typename T, typename... Args>
+unique_ptr<T, numa_delete<T>> make_unique_on_node(int node, Args&&... args) {
+    void* mem = detail::numa_allocate(sizeof(T), alignof(T), node);
+    SMART_PTR_KIT_TRY {
+        return unique_ptr<T, numa_delete<T>>(new(mem) T(std::forward<Args>(args)...));
+    } SMART_PTR_KIT_CATCH_ALL {
+        detail::numa_deallocate(mem, sizeof(T), alignof(T));
+        SMART_PTR_KIT_RETHROW;
+    }
+}
+
+// "Local to calling thread" policy
+template <typename T, typename... Args>
+shared_ptr<T> make_shared_local(Args&&... args) {
+    return make_shared_on_node<T>(numa_local_node, std::forward<Args>(args)...);
+}
+
+template <typename T, typename... Args>
+unique_ptr<T, numa_delete<T>> make_unique_local(Args&&... args) {
+    return make_unique_on_node<T>(numa_local_node, std::forward<Args>(args)...);
+}
+
+} // namespace sptr
+
+#endif // SMART_PTR_KIT_NUMA_ALLOC_HPP
@@ -0,0 +1,182 @@
+#ifndef SMART_PTR_KIT_OBSERVER_LIST_HPP
+#define SMART_PTR_KIT_OBSERVER_LIST_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include "shared_ptr.hpp"
+#include "weak_ptr.hpp"
+#include "weak_scan.hpp"
+
+namespace sptr {
+
+// Subscriber list for signal/slot fan-out. Holds weak references, so a
+// subscriber unsubscribes simply by dying.
+//
+// The subscribers live in an immutable snapshot array. for_each() pins the
+// current snapshot by bumping one of two reader counters, then scans it
+// with the prefetching lock_all machinery: no mutex, no allocation, and no
+// waiting on writers. add()/remove() copy the array under a writer mutex,
+// publish the copy and retire the old one. A reader counted under either
+// parity may still hold a retired snapshot, so it is freed only once each
+// counter has been seen drained after the epoch moved off it (a non-waiting
+// double flip; whatever is still pending is retried by the next write).
+// Writers never wait for readers, so callbacks may add and remove
+// subscribers (the change is seen by the next notification).
+//
+// Expired entries are dropped whenever a writer copies the array. for_each()
+// also compacts eagerly when most of what it scanned had expired, but only
+// if no writer is active (try_lock); that is the one case it allocates.
+template <typename T>
+class observer_list {
+public:
+    observer_list() : m_current(new snapshot()) {}
+
+    ~observer_list() {
+        delete m_current.load(std::memory_order_relaxed);
+        for (retired& r : m_retired) delete r.snap;
+    }
+
+    observer_list(const observer_list&) = delete;
+    observer_list& operator=(const observer_list&) = delete;
+
+    void add(const shared_ptr<T>& subscriber) {
+        std::lock_guard<std::mutex> lock(m_writer);
+        rebuild([&](std::vector<weak_ptr<T>>& entries) { entries.emplace_back(subscriber); });
+    }
+
+    // Removes every entry referring to subscriber's object
+    bool remove(const shared_ptr<T>& subscriber) {
+        detail::control_block* target = detail::shared_access::control(subscriber);
+        bool found = false;
+        std::lock_guard<std::mutex> lock(m_writer);
+        rebuild([&](std::vector<weak_ptr<T>>& entries) {
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i < entries.size(); ++i) {
+                if (detail::shared_access::control(entries[i]) == target) {
+                    found = true;
+                    continue;
+                }
+                if (kept != i) entries[kept] = std::move(entries[i]);
+                ++kept;
+            }
+            entries.resize(kept);
+        });
+        return found;
+    }
+
+    // Calls f(T&) for every live subscriber; returns how many were called
+    template <typename F>
+    std::size_t for_each(F f) {
+        unsigned parity = enter();
+        const snapshot* snap = m_current.load(std::memory_order_seq_cst);
+        std::size_t alive = for_each_alive(snap->entries, f);
+        std::size_t expired = snap->entries.size() - alive;
+        leave(parity);
+        if (expired > compact_min && expired > alive) {
+            std::unique_lock<std::mutex> lock(m_writer, std::try_to_lock);
+            if (lock.owns_lock()) {
+                rebuild([](std::vector<weak_ptr<T>>&) {});
+            }
+        }
+        return alive;
+    }
+
+    // Drops expired entries now
+    void compact() {
+        std::lock_guard<std::mutex> lock(m_writer);
+        rebuild([](std::vector<weak_ptr<T>>&) {});
+    }
+
+    // Entries in the current snapshot, expired ones included
+    std::size_t size() const {
+        std::lock_guard<std::mutex> lock(m_writer);
+        return m_current.load(std::memory_order_relaxed)->entries.size();
+    }
+
+private:
+    struct snapshot {
+        std::vector<weak_ptr<T>> entries;
+    };
+
+    struct retired {
+        snapshot* snap;
+        // Parities not yet seen drained since snap was unpublished
+        unsigned pending;
+    };
+
+    // Below this many expired entries a notification never compacts
+    static constexpr std::size_t compact_min = 16;
+
+    // Registers a reader on the current epoch parity. The recheck ensures
+    // the counter was raised before any writer that flips past this epoch
+    // starts checking it.
+    unsigned enter() noexcept {
+        for (;;) {
+            unsigned parity = m_epoch.load(std::memory_order_seq_cst) & 1;
+            m_readers[parity].count.fetch_add(1, std::memory_order_seq_cst);
+            if ((m_epoch.load(std::memory_order_seq_cst) & 1) == parity) {
+                return parity;
+            }
+            m_readers[parity].count.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    void leave(unsigned parity) noexcept {
+        m_readers[parity].count.fetch_sub(1, std::memory_order_release);
+    }
+
+    // Caller holds m_writer. Copies the live entries, lets edit modify the
+    // copy, publishes it and retires the old snapshot.
+    template <typename Edit>
+    void rebuild(Edit edit) {
+        snapshot* old = m_current.load(std::memory_order_relaxed);
+        auto* next = new snapshot();
+        next->entries.reserve(old->entries.size() + 1);
+        for (const weak_ptr<T>& w : old->entries) {
+            if (!w.expired()) next->entries.push_back(w);
+        }
+        edit(next->entries);
+
+        m_current.store(next, std::memory_order_seq_cst);
+        m_retired.push_back(retired{old, 3u});
+        reclaim();
+    }
+
+    // Flips the epoch so one parity goes idle and frees what it was guarding.
+    // A reader that registers on the idle parity after the check sees the
+    // flip, backs off and re-registers, so it never loads a retired
+    // snapshot. Two flips cover both parities.
+    void reclaim() noexcept {
+        for (int flip = 0; flip < 2 && !m_retired.empty(); ++flip) {
+            unsigned idle = m_epoch.fetch_add(1, std::memory_order_seq_cst) & 1;
+            if (m_readers[idle].count.load(std::memory_order_seq_cst) != 0) continue;
+            std::size_t kept = 0;
+            for (retired& r : m_retired) {
+                r.pending &= ~(1u << idle);
+                if (r.pending == 0) {
+                    delete r.snap;
+                } else {
+                    m_retired[kept++] = r;
+                }
+            }
+            m_retired.resize(kept);
+        }
+    }
+
+    struct alignas(64) reader_count {
+        std::atomic<std::size_t> count{0};
+    };
+
+    std::atomic<snapshot*> m_current;
+    std::atomic<unsigned> m_epoch{0};
+    reader_count m_readers[2];
+    mutable std::mutex m_writer;
+    std::vector<retired> m_retired;
+};
+
+} // namespace sptr
+
+#endif // SMART_PTR_KIT_OBSERVER_LIST_HPP
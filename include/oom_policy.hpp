@@ -0,0 +1,60 @@
+#ifndef SMART_PTR_KIT_OOM_POLICY_HPP
+#define SMART_PTR_KIT_OOM_POLICY_HPP
+
+#include <cstddef>
+#include <new>
+
+namespace sptr {
+
+// How the library fails. With exceptions, allocation failure throws
+// std::bad_alloc and other errors throw their documented exception types.
+// Under -fno-exceptions the same failures print a message and abort, so the
+// headers and sources compile in either mode; callers that must survive an
+// allocation failure use the try_ factories (try_make_shared,
+// try_make_unique), which return an empty pointer instead.
+//
+// The out-of-memory handler runs before either default action, with the
+// number of bytes that could not be allocated. It may log, release caches,
+// exit, or (with exceptions) throw an exception of its own; if it returns,
+// the default action follows. The try_ factories do not call it.
+using oom_handler = void (*)(std::size_t bytes);
+
+// Installs handler (null for none) and returns the previous one
+oom_handler set_oom_handler(oom_handler handler) noexcept;
+oom_handler get_oom_handler() noexcept;
+
+namespace detail {
+    // Runs the handler, then throws std::bad_alloc / aborts. Both live in
+    // the library so that translation units built with and without
+    // exceptions never share an inline definition.
+    [[noreturn]] void throw_out_of_memory(std::size_t bytes);
+    [[noreturn]] void abort_out_of_memory(std::size_t bytes) noexcept;
+
+    // Prints what (the message of an exception that cannot be thrown) and aborts
+    [[noreturn]] void abort_with(const char* what) noexcept;
+}
+
+} // namespace sptr
+
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+#define SMART_PTR_KIT_HAS_EXCEPTIONS 1
+#else
+#define SMART_PTR_KIT_HAS_EXCEPTIONS 0
+#endif
+
+// Cleanup-and-rethrow blocks; without exceptions the cleanup is dead code
+#if SMART_PTR_KIT_HAS_EXCEPTIONS
+#define SMART_PTR_KIT_TRY try
+#define SMART_PTR_KIT_CATCH_ALL catch (...)
+#define SMART_PTR_KIT_RETHROW throw
+#define SMART_PTR_KIT_THROW(error) throw error
+#define SMART_PTR_KIT_OUT_OF_MEMORY(bytes) ::sptr::detail::throw_out_of_memory(bytes)
+#else
+#define SMART_PTR_KIT_TRY if (true)
+#define SMART_PTR_KIT_CATCH_ALL else
+#define SMART_PTR_KIT_RETHROW ((void)0)
+#define SMART_PTR_KIT_THROW(error) ::sptr::detail::abort_with((error).what())
+#define SMART_PTR_KIT_OUT_OF_MEMORY(bytes) ::sptr::detail::abort_out_of_memory(bytes)
+#endif
+
+#endif // SMART_PTR_KIT_OOM_POLICY_HPP
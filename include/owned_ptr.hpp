@@ -0,0 +1,234 @@
+#ifndef SMART_PTR_KIT_OWNED_PTR_HPP
+#define SMART_PTR_KIT_OWNED_PTR_HPP
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "oom_policy.hpp"
+#include "shared_ptr.hpp"
+
+namespace sptr {
+
+// Single-owner pointer that can still be observed weakly: the unique_ptr
+// of objects that would otherwise be shared_ptrs only to get weak_ptrs.
+//
+// It sits on an ordinary control block whose strong count is the owner's
+// single reference. Moving the owner never touches the count; the only
+// strong-count operations are the final release and observers' lock().
+//
+// Ownership is unique only while no borrow is live. A borrow is a strong
+// reference, so one taken before owner.reset() (or the owner's destructor)
+// keeps the object alive past it, and the object is then destroyed on
+// whichever thread ends the last borrow. Code that needs destruction to
+// happen in the owner's thread must not let borrows escape their scope or
+// cross threads; there is no owner-only flag that could reject them.
+template <typename T>
+class owned_ptr;
+
+// Non-owning observer of an owned_ptr, kept on the block's weak count
+template <typename T>
+class observer_ref;
+
+// Result of observer_ref::lock(): keeps the object alive for the scope of
+// the borrow. If the owner lets go meanwhile, the borrow becomes the
+// object's last owner: it is destroyed when the last borrow ends, on that
+// thread, and observers keep seeing it alive until then.
+template <typename T>
+class borrow {
+public:
+    borrow(borrow&& other) noexcept : m_ptr(other.m_ptr), m_ctrl(other.m_ctrl) {
+        other.m_ptr = nullptr;
+        other.m_ctrl = nullptr;
+    }
+
+    borrow(const borrow&) = delete;
+    borrow& operator=(const borrow&) = delete;
+    borrow& operator=(borrow&&) = delete;
+
+    ~borrow() {
+        if (m_ctrl) m_ctrl->release();
+    }
+
+    T* get() const noexcept {
+        return m_ptr;
+    }
+
+    T& operator*() const noexcept {
+        return *m_ptr;
+    }
+
+    T* operator->() const noexcept {
+        return m_ptr;
+    }
+
+    explicit operator bool() const noexcept {
+        return m_ptr != nullptr;
+    }
+
+private:
+    friend class observer_ref<T>;
+
+    borrow(T* ptr, detail::control_block* ctrl) noexcept : m_ptr(ptr), m_ctrl(ctrl) {}
+
+    T* m_ptr;
+    detail::control_block* m_ctrl;
+};
+
+template <typename T>
+class owned_ptr {
+public:
+    using element_type = T;
+
+    constexpr owned_ptr() noexcept : m_ptr(nullptr), m_ctrl(nullptr) {}
+    constexpr owned_ptr(std::nullptr_t) noexcept : m_ptr(nullptr), m_ctrl(nullptr) {}
+
+    template <typename Y, typename = std::enable_if_t<std::is_convertible_v<Y*, T*>>>
+    explicit owned_ptr(Y* ptr) {
+        m_ctrl = new (std::nothrow) detail::ptr_control_block<Y>(ptr);
+        if (!m_ctrl) {
+            delete ptr;
+            SMART_PTR_KIT_OUT_OF_MEMORY(sizeof(detail::ptr_control_block<Y>));
+        }
+        m_ptr = ptr;
+    }
+
+    owned_ptr(owned_ptr&& other) noexcept : m_ptr(other.m_ptr), m_ctrl(other.m_ctrl) {
+        other.m_ptr = nullptr;
+        other.m_ctrl = nullptr;
+    }
+
+    template <typename Y, typename = std::enable_if_t<std::is_convertible_v<Y*, T*>>>
+    owned_ptr(owned_ptr<Y>&& other) noexcept : m_ptr(other.m_ptr), m_ctrl(other.m_ctrl) {
+        other.m_ptr = nullptr;
+        other.m_ctrl = nullptr;
+    }
+
+    owned_ptr& operator=(owned_ptr&& other) noexcept {
+        owned_ptr(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    owned_ptr(const owned_ptr&) = delete;
+    owned_ptr& operator=(const owned_ptr&) = delete;
+
+    ~owned_ptr() {
+        if (m_ctrl) m_ctrl->release();
+    }
+
+    void reset() noexcept {
+        owned_ptr().swap(*this);
+    }
+
+    void swap(owned_ptr& other) noexcept {
+        std::swap(m_ptr, other.m_ptr);
+        std::swap(m_ctrl, other.m_ctrl);
+    }
+
+    T* get() const noexcept {
+        return m_ptr;
+    }
+
+    T& operator*() const noexcept {
+        return *m_ptr;
+    }
+
+    T* operator->() const noexcept {
+        return m_ptr;
+    }
+
+    explicit operator bool() const noexcept {
+        return m_ptr != nullptr;
+    }
+
+    observer_ref<T> observe() const noexcept {
+        return observer_ref<T>(m_ptr, m_ctrl);
+    }
+
+private:
+    template <typename U>
+    friend class owned_ptr;
+
+    template <typename U, typename... Args>
+    friend owned_ptr<U> make_owned(Args&&... args);
+
+    owned_ptr(T* ptr, detail::control_block* ctrl) noexcept : m_ptr(ptr), m_ctrl(ctrl) {}
+
+    T* m_ptr;
+    detail::control_block* m_ctrl;
+};
+
+template <typename T>
+class observer_ref {
+public:
+    constexpr observer_ref() noexcept : m_ptr(nullptr), m_ctrl(nullptr) {}
+
+    observer_ref(const owned_ptr<T>& owner) noexcept : observer_ref(owner.observe()) {}
+
+    observer_ref(const observer_ref& other) noexcept : m_ptr(other.m_ptr), m_ctrl(other.m_ctrl) {
+        if (m_ctrl) m_ctrl->add_weak_reference();
+    }
+
+    observer_ref(observer_ref&& other) noexcept : m_ptr(other.m_ptr), m_ctrl(other.m_ctrl) {
+        other.m_ptr = nullptr;
+        other.m_ctrl = nullptr;
+    }
+
+    observer_ref& operator=(const observer_ref& other) noexcept {
+        observer_ref(other).swap(*this);
+        return *this;
+    }
+
+    observer_ref& operator=(observer_ref&& other) noexcept {
+        observer_ref(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    ~observer_ref() {
+        if (m_ctrl) m_ctrl->weak_release();
+    }
+
+    void reset() noexcept {
+        observer_ref().swap(*this);
+    }
+
+    void swap(observer_ref& other) noexcept {
+        std::swap(m_ptr, other.m_ptr);
+        std::swap(m_ctrl, other.m_ctrl);
+    }
+
+    bool expired() const noexcept {
+        return !m_ctrl || m_ctrl->use_count() == 0;
+    }
+
+    // Empty borrow if the owner is gone
+    borrow<T> lock() const noexcept {
+        if (m_ctrl && m_ctrl->try_add_reference()) {
+            return borrow<T>(m_ptr, m_ctrl);
+        }
+        return borrow<T>(nullptr, nullptr);
+    }
+
+private:
+    friend class owned_ptr<T>;
+
+    observer_ref(T* ptr, detail::control_block* ctrl) noexcept : m_ptr(ptr), m_ctrl(ctrl) {
+        if (m_ctrl) m_ctrl->add_weak_reference();
+    }
+
+    T* m_ptr;
+    detail::control_block* m_ctrl;
+};
+
+// Object and control block in one allocation, like make_shared
+template <typename T, typename... Args>
+owned_ptr<T> make_owned(Args&&... args) {
+    auto cb = new (std::nothrow) detail::inplace_control_block<T>(std::forward<Args>(args)...);
+    if (!cb) SMART_PTR_KIT_OUT_OF_MEMORY(sizeof(detail::inplace_control_block<T>));
+    return owned_ptr<T>(cb->get(), cb);
+}
+
+} // namespace sptr
+
+#endif // SMART_PTR_KIT_OWNED_PTR_HPP
@@ -0,0 +1,224 @@
+#ifndef SMART_PTR_KIT_OWNERSHIP_GROUP_HPP
+#define SMART_PTR_KIT_OWNERSHIP_GROUP_HPP
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "bump_arena.hpp"
+#include "oom_policy.hpp"
+#include "shared_ptr.hpp"
+
+namespace sptr {
+
+namespace detail {
+    // One control block for a whole region: objects are bump-allocated from
+    // the group's chunks and destroyed together, in reverse creation order,
+    // when the group's single count drops to zero
+    class group_block : public control_block {
+    public:
+        group_block() = default;
+
+        void* allocate(std::size_t size, std::size_t align);
+        void add_destructor(void (*destroy)(void*), void* object);
+
+        void dispose() noexcept override;
+        void destroy() noexcept override;
+
+        std::size_t objects() const noexcept {
+            return m_objects;
+        }
+
+        std::size_t bytes_reserved() const noexcept {
+            return m_arena.bytes_reserved();
+        }
+
+    private:
+        struct destructor {
+            void (*destroy)(void*);
+            void* object;
+        };
+
+        bump_arena m_arena;
+        std::vector<destructor> m_destructors;
+        std::size_t m_objects = 0;
+    };
+}
+
+class ownership_group;
+
+// Pointer to a member of an ownership_group. Copying it touches only the
+// group's count; any member keeps the whole group alive. Converts to an
+// aliasing shared_ptr<T> sharing that same count.
+template <typename T>
+class group_ptr {
+public:
+    using element_type = T;
+
+    constexpr group_ptr() noexcept : m_ptr(nullptr), m_group(nullptr) {}
+
+    group_ptr(const group_ptr& other) noexcept : m_ptr(other.m_ptr), m_group(other.m_group) {
+        if (m_group) m_group->add_reference();
+    }
+
+    template <typename Y, typename = std::enable_if_t<std::is_convertible_v<Y*, T*>>>
+    group_ptr(const group_ptr<Y>& other) noexcept : m_ptr(other.m_ptr), m_group(other.m_group) {
+        if (m_group) m_group->add_reference();
+    }
+
+    group_ptr(group_ptr&& other) noexcept : m_ptr(other.m_ptr), m_group(other.m_group) {
+        other.m_ptr = nullptr;
+        other.m_group = nullptr;
+    }
+
+    ~group_ptr() {
+        if (m_group) m_group->release();
+    }
+
+    group_ptr& operator=(const group_ptr& other) noexcept {
+        group_ptr(other).swap(*this);
+        return *this;
+    }
+
+    group_ptr& operator=(group_ptr&& other) noexcept {
+        group_ptr(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    void reset() noexcept {
+        group_ptr().swap(*this);
+    }
+
+    void swap(group_ptr& other) noexcept {
+        std::swap(m_ptr, other.m_ptr);
+        std::swap(m_group, other.m_group);
+    }
+
+    T* get() const noexcept {
+        return m_ptr;
+    }
+
+    T& operator*() const noexcept {
+        return *m_ptr;
+    }
+
+    T* operator->() const noexcept {
+        return m_ptr;
+    }
+
+    explicit operator bool() const noexcept {
+        return m_ptr != nullptr;
+    }
+
+    // Owners of the whole group, not of this member
+    long use_count() const noexcept {
+        return m_group ? m_group->use_count() : 0;
+    }
+
+    shared_ptr<T> to_shared() const noexcept {
+        return detail::shared_access::share<T>(m_ptr, m_group);
+    }
+
+    operator shared_ptr<T>() const noexcept {
+        return to_shared();
+    }
+
+private:
+    template <typename U>
+    friend class group_ptr;
+    friend class ownership_group;
+
+    group_ptr(T* ptr, detail::group_block* group) noexcept : m_ptr(ptr), m_group(group) {
+        if (m_group) m_group->add_reference();
+    }
+
+    T* m_ptr;
+    detail::group_block* m_group;
+};
+
+// A region of objects (parse tree, query plan) that live and die together.
+// The group handle is itself one owner; the objects are destroyed and their
+// memory freed once the handle and every group_ptr/shared_ptr into the group
+// are gone.
+//
+// Members should link to each other with raw pointers: a group_ptr stored
+// inside the group owns the group and keeps it alive forever. make() is not
+// thread-safe; pointers handed out from the group are. A moved-from group is
+// empty and starts a new region on its next make() or create().
+class ownership_group {
+public:
+    ownership_group() : m_block(new_block()) {}
+
+    ~ownership_group() {
+        if (m_block) m_block->release();
+    }
+
+    ownership_group(ownership_group&& other) noexcept : m_block(other.m_block) {
+        other.m_block = nullptr;
+    }
+
+    ownership_group& operator=(ownership_group&& other) noexcept {
+        std::swap(m_block, other.m_block);
+        return *this;
+    }
+
+    ownership_group(const ownership_group&) = delete;
+    ownership_group& operator=(const ownership_group&) = delete;
+
+    template <typename T, typename... Args>
+    group_ptr<T> make(Args&&... args) {
+        T* object = create<T>(std::forward<Args>(args)...);
+        return group_ptr<T>(object, m_block);
+    }
+
+    // Constructs a member and returns a plain pointer, for links between
+    // members; it stays valid as long as the group does
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        if (!m_block) m_block = new_block();
+        void* mem = m_block->allocate(sizeof(T), alignof(T));
+        T* object = new(mem) T(std::forward<Args>(args)...);
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            SMART_PTR_KIT_TRY {
+                m_block->add_destructor([](void* p) { static_cast<T*>(p)->~T(); }, object);
+            } SMART_PTR_KIT_CATCH_ALL {
+                object->~T();
+                SMART_PTR_KIT_RETHROW;
+            }
+        }
+        return object;
+    }
+
+    // A group_ptr to an object that was create()d in this group
+    template <typename T>
+    group_ptr<T> share(T* member) const noexcept {
+        return m_block ? group_ptr<T>(member, m_block) : group_ptr<T>();
+    }
+
+    std::size_t objects() const noexcept {
+        return m_block ? m_block->objects() : 0;
+    }
+
+    std::size_t bytes_reserved() const noexcept {
+        return m_block ? m_block->bytes_reserved() : 0;
+    }
+
+    long use_count() const noexcept {
+        return m_block ? m_block->use_count() : 0;
+    }
+
+private:
+    static detail::group_block* new_block() {
+        auto* block = new (std::nothrow) detail::group_block();
+        if (!block) SMART_PTR_KIT_OUT_OF_MEMORY(sizeof(detail::group_block));
+        return block;
+    }
+
+    detail::group_block* m_block;
+};
+
+} // namespace sptr
+
+#endif // SMART_PTR_KIT_OWNERSHIP_GROUP_HPP
@@ -0,0 +1,179 @@
+#ifndef SMART_PTR_KIT_PERSISTENT_HEAP_HPP
+#define SMART_PTR_KIT_PERSISTENT_HEAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "shared_ptr.hpp"
+
+namespace sptr {
+
+// Self-relative pointer: stores the distance from its own address to the
+// target, so a graph linked with offset_ptr stays valid wherever the bytes
+// holding it are mapped. Copying recomputes the offset for the new location.
+template <typename T>
+class offset_ptr {
+public:
+    using element_type = T;
+
+    offset_ptr() noexcept : m_offset(null_offset) {}
+    offset_ptr(std::nullptr_t) noexcept : m_offset(null_offset) {}
+    offset_ptr(T* ptr) noexcept : m_offset(to_offset(ptr)) {}
+    offset_ptr(const offset_ptr& other) noexcept : m_offset(to_offset(other.get())) {}
+
+    offset_ptr& operator=(const offset_ptr& other) noexcept {
+        m_offset = to_offset(other.get());
+        return *this;
+    }
+
+    offset_ptr& operator=(T* ptr) noexcept {
+        m_offset = to_offset(ptr);
+        return *this;
+    }
+
+    T* get() const noexcept {
+        if (m_offset == null_offset) return nullptr;
+        return reinterpret_cast<T*>(reinterpret_cast<std::intptr_t>(this) + m_offset);
+    }
+
+    T& operator*() const noexcept {
+        return *get();
+    }
+
+    T* operator->() const noexcept {
+        return get();
+    }
+
+    explicit operator bool() const noexcept {
+        return m_offset != null_offset;
+    }
+
+private:
+    // 1 can never be a real target: it would point into this object
+    static constexpr std::intptr_t null_offset = 1;
+
+    std::intptr_t to_offset(T* ptr) const noexcept {
+        if (!ptr) return null_offset;
+        return reinterpret_cast<std::intptr_t>(ptr) - reinterpret_cast<std::intptr_t>(this);
+    }
+
+    std::intptr_t m_offset;
+};
+
+class persistent_heap_error : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// Arena of immutable objects that can be written to a file and mmap()ed back
+// in O(page-in) time instead of being rebuilt. Objects must be trivially
+// destructible and link to each other only through offset_ptr. The file
+// carries a format version, a caller-chosen schema version and a checksum,
+// all verified by open().
+//
+// open() validates the header, the root and (by default) the checksum, but
+// offset_ptr::get() itself is unchecked. Graphs from files that skipped the
+// checksum, or that were not written by a trusted save(), should be walked
+// through checked(), which bounds-checks each hop.
+//
+// shared_ptrs handed out by share() have no control block: copying them
+// touches no count at all, use_count() is 0, and weak_ptrs made from them
+// are empty. They must not outlive the heap.
+class persistent_heap {
+public:
+    static constexpr std::uint32_t format_version = 1;
+    static constexpr std::size_t max_alignment = 64;
+
+    // Builder: an empty, writable heap able to hold capacity bytes
+    explicit persistent_heap(std::size_t capacity, std::uint64_t schema_version = 0);
+
+    // Maps a saved heap read-only. Throws persistent_heap_error if the file
+    // is truncated or corrupt, or its format/schema version does not match.
+    // Skipping the checksum avoids touching every page up front.
+    static persistent_heap open(const std::string& path, std::uint64_t schema_version = 0,
+                                bool verify_checksum = true);
+
+    persistent_heap(persistent_heap&& other) noexcept;
+    persistent_heap& operator=(persistent_heap&& other) noexcept;
+    persistent_heap(const persistent_heap&) = delete;
+    persistent_heap& operator=(const persistent_heap&) = delete;
+    ~persistent_heap();
+
+    template <typename T, typename... Args>
+    T* construct(Args&&... args) {
+        static_assert(std::is_trivially_destructible_v<T>,
+                      "persistent objects are never destroyed");
+        static_assert(alignof(T) <= max_alignment, "over-aligned persistent object");
+        void* mem = allocate(sizeof(T), alignof(T));
+        return new(mem) T(std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    void set_root(const T* obj) {
+        set_root_offset(offset_of(obj, sizeof(T)));
+    }
+
+    // Throws persistent_heap_error if a T at the root offset would not fit
+    // inside the used part of the heap
+    template <typename T>
+    const T* root() const {
+        std::size_t offset = root_offset();
+        if (offset == 0) return nullptr;
+        return static_cast<const T*>(checked_object(m_base + offset, sizeof(T), alignof(T)));
+    }
+
+    // ptr's target, after checking that a whole T there lies inside the heap
+    template <typename T>
+    const T* checked(const offset_ptr<T>& ptr) const {
+        if (!ptr) return nullptr;
+        return static_cast<const T*>(checked_object(ptr.get(), sizeof(T), alignof(T)));
+    }
+
+    // Non-owning shared_ptr to an object inside the heap (see above)
+    template <typename T>
+    shared_ptr<const T> share(const T* obj) const {
+        if (!obj) return shared_ptr<const T>();
+        offset_of(obj, sizeof(T));
+        return shared_ptr<const T>(shared_ptr<const T>(), obj);
+    }
+
+    template <typename T>
+    shared_ptr<const T> root_shared() const {
+        return share(root<T>());
+    }
+
+    // Writes the used part of the heap; the file is exactly what open() maps
+    void save(const std::string& path) const;
+
+    // Whether [p, p + size) lies inside the used part of the heap
+    bool contains(const void* p, std::size_t size = 1) const noexcept;
+
+    bool read_only() const noexcept {
+        return m_read_only;
+    }
+
+    std::size_t size() const noexcept;
+    std::uint64_t schema_version() const noexcept;
+
+private:
+    persistent_heap() noexcept = default;
+
+    void* allocate(std::size_t size, std::size_t align);
+    std::size_t offset_of(const void* p, std::size_t size) const;
+    const void* checked_object(const void* p, std::size_t size, std::size_t align) const;
+    std::size_t root_offset() const noexcept;
+    void set_root_offset(std::size_t offset);
+    void release() noexcept;
+
+    char* m_base = nullptr;
+    std::size_t m_mapped = 0;
+    bool m_read_only = false;
+};
+
+} // namespace sptr
+
+#endif // SMART_PTR_KIT_PERSISTENT_HEAP_HPP
@@ -0,0 +1,88 @@
+#ifndef SMART_PTR_KIT_POOL_ALLOC_HPP
+#define SMART_PTR_KIT_POOL_ALLOC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "oom_policy.hpp"
+#include "shared_ptr.hpp"
+
+namespace sptr {
+
+// Per-thread size-class heaps for control blocks, in the style of mimalloc.
+// A block freed by its owning thread goes straight back on its page's free
+// list. A block freed by any other thread is a "remote free": it is queued in
+// the freeing thread's pending batch and pushed to the owner's lock-free
+// return list with a single CAS per batch. The owner drains that list the
+// next time the page it allocates from has no free blocks.
+//
+// Only blocks allocated through pool_allocator (make_shared_pooled,
+// allocate_shared with it, containers) live here; plain make_shared keeps
+// using the global operator new. Blocks sit in 64 KiB pages, and a page goes
+// back to the system once every block on it is free, except the page each
+// size class is currently allocating from, which stays until its thread
+// exits. Remote frees keep their page until the owner drains them, so a
+// heap whose thread is gone holds those pages until another thread adopts it.
+
+struct pool_stats {
+    std::size_t heaps = 0;           // thread heaps ever created (reused after thread exit)
+    std::size_t allocations = 0;
+    std::size_t local_frees = 0;
+    std::size_t remote_frees = 0;    // blocks returned to another thread's heap
+    std::size_t remote_batches = 0;  // CAS pushes carrying those blocks
+    std::size_t drained = 0;         // remote blocks reclaimed by their owners
+    std::size_t pages = 0;           // 64 KiB pages currently held
+};
+
+pool_stats pool_counters() noexcept;
+
+// Hands this thread's pending remote frees to their owners now. Batches are
+// also flushed when full, when the target heap changes and at thread exit.
+void flush_remote_frees() noexcept;
+
+namespace detail {
+    void* pool_allocate(std::size_t size, std::size_t align);
+    // size and align must match the pool_allocate call
+    void pool_deallocate(void* p, std::size_t size, std::size_t align) noexcept;
+}
+
+template <typename T>
+class pool_allocator {
+public:
+    using value_type = T;
+
+    pool_allocator() noexcept = default;
+
+    template <typename U>
+    pool_allocator(const pool_allocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        if (n > SIZE_MAX / sizeof(T)) SMART_PTR_KIT_OUT_OF_MEMORY(SIZE_MAX);
+        return static_cast<T*>(detail::pool_allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        detail::pool_deallocate(p, n * sizeof(T), alignof(T));
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const pool_allocator<T>&, const pool_allocator<U>&) noexcept {
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const pool_allocator<T>&, const pool_allocator<U>&) noexcept {
+    return false;
+}
+
+// make_shared whose control block comes from the calling thread's heap
+template <typename T, typename... Args>
+shared_ptr<T> make_shared_pooled(Args&&... args) {
+    return allocate_shared<T>(pool_allocator<T>(), std::forward<Args>(args)...);
+}
+
+} // namespace sptr
+
+#endif // SMART_PTR_KIT_POOL_ALLOC_HPP
@@ -0,0 +1,235 @@
+#ifndef SMART_PTR_KIT_RELOCATE_HPP
+#define SMART_PTR_KIT_RELOCATE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "oom_policy.hpp"
+#include "trivially_relocatable.hpp"
+
+namespace sptr {
+
+// The smart pointers, unique_array and shared_string specialize
+// is_trivially_relocatable in their own headers. offset_ptr does not
+// qualify, since its value depends on where it lives.
+
+// Moves [first, last) into the uninitialized storage at d_first and ends the
+// lifetime of the sources. Trivially relocatable types become one memmove,
+// so the ranges may overlap when d_first <= first. Returns the end of the
+// destination range.
+template <typename T>
+T* uninitialized_relocate(T* first, T* last, T* d_first) noexcept {
+    static_assert(is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible_v<T>,
+                  "relocation must not throw");
+    if constexpr (is_trivially_relocatable_v<T>) {
+        std::size_t n = static_cast<std::size_t>(last - first);
+        if (n != 0) {
+            std::memmove(static_cast<void*>(d_first), static_cast<const void*>(first), n * sizeof(T));
+        }
+        return d_first + n;
+    } else {
+        for (; first != last; ++first, ++d_first) {
+            new(d_first) T(std::move(*first));
+            first->~T();
+        }
+        return d_first;
+    }
+}
+
+template <typename T>
+T* uninitialized_relocate_n(T* first, std::size_t n, T* d_first) noexcept {
+    return uninitialized_relocate(first, first + n, d_first);
+}
+
+// Single-object form
+template <typename T>
+T* relocate_at(T* source, T* dest) noexcept {
+    uninitialized_relocate(source, source + 1, dest);
+    return dest;
+}
+
+// Minimal vector that grows and erases by relocation: for trivially
+// relocatable elements growth is a realloc() and erase a memmove, with no
+// per-element move constructor, destructor or refcount traffic.
+template <typename T>
+class relocating_vector {
+    static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned element type");
+
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    relocating_vector() noexcept = default;
+
+    relocating_vector(relocating_vector&& other) noexcept
+        : m_data(other.m_data), m_size(other.m_size), m_capacity(other.m_capacity) {
+        other.m_data = nullptr;
+        other.m_size = 0;
+        other.m_capacity = 0;
+    }
+
+    relocating_vector& operator=(relocating_vector&& other) noexcept {
+        relocating_vector(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    relocating_vector(const relocating_vector&) = delete;
+    relocating_vector& operator=(const relocating_vector&) = delete;
+
+    ~relocating_vector() {
+        clear();
+        std::free(m_data);
+    }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (m_size == m_capacity) {
+            // Construct first: args may refer to an element about to move
+            T value(std::forward<Args>(args)...);
+            grow(next_capacity());
+            new(m_data + m_size) T(std::move(value));
+        } else {
+            new(m_data + m_size) T(std::forward<Args>(args)...);
+        }
+        return m_data[m_size++];
+    }
+
+    void push_back(const T& value) {
+        emplace_back(value);
+    }
+
+    void push_back(T&& value) {
+        emplace_back(std::move(value));
+    }
+
+    void pop_back() noexcept {
+        m_data[--m_size].~T();
+    }
+
+    iterator erase(const_iterator pos) noexcept {
+        return erase(pos, pos + 1);
+    }
+
+    iterator erase(const_iterator first, const_iterator last) noexcept {
+        T* begin = m_data + (first - m_data);
+        T* end = m_data + (last - m_data);
+        for (T* p = begin; p != end; ++p) {
+            p->~T();
+        }
+        uninitialized_relocate(end, m_data + m_size, begin);
+        m_size -= static_cast<std::size_t>(end - begin);
+        return begin;
+    }
+
+    void reserve(std::size_t capacity) {
+        if (capacity > m_capacity) grow(capacity);
+    }
+
+    void clear() noexcept {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (std::size_t i = m_size; i > 0; --i) {
+                m_data[i - 1].~T();
+            }
+        }
+        m_size = 0;
+    }
+
+    void swap(relocating_vector& other) noexcept {
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+        std::swap(m_capacity, other.m_capacity);
+    }
+
+    T& operator[](std::size_t i) noexcept {
+        return m_data[i];
+    }
+
+    const T& operator[](std::size_t i) const noexcept {
+        return m_data[i];
+    }
+
+    T& back() noexcept {
+        return m_data[m_size - 1];
+    }
+
+    T* data() noexcept {
+        return m_data;
+    }
+
+    const T* data() const noexcept {
+        return m_data;
+    }
+
+    iterator begin() noexcept {
+        return m_data;
+    }
+
+    iterator end() noexcept {
+        return m_data + m_size;
+    }
+
+    const_iterator begin() const noexcept {
+        return m_data;
+    }
+
+    const_iterator end() const noexcept {
+        return m_data + m_size;
+    }
+
+    std::size_t size() const noexcept {
+        return m_size;
+    }
+
+    std::size_t capacity() const noexcept {
+        return m_capacity;
+    }
+
+    // Largest element count whose byte size fits in a size_t
+    static constexpr std::size_t max_size() noexcept {
+        return SIZE_MAX / sizeof(T);
+    }
+
+    bool empty() const noexcept {
+        return m_size == 0;
+    }
+
+private:
+    // Doubling, clamped at max_size(); a vector already that big cannot grow
+    std::size_t next_capacity() const {
+        if (m_capacity == 0) return 4;
+        if (m_capacity == max_size()) SMART_PTR_KIT_OUT_OF_MEMORY(SIZE_MAX);
+        return m_capacity > max_size() / 2 ? max_size() : m_capacity * 2;
+    }
+
+    void grow(std::size_t capacity) {
+        if (capacity > max_size()) SMART_PTR_KIT_OUT_OF_MEMORY(SIZE_MAX);
+        T* data;
+        if constexpr (is_trivially_relocatable_v<T>) {
+            // realloc may extend in place, and relocates the bytes otherwise
+            data = static_cast<T*>(std::realloc(static_cast<void*>(m_data), capacity * sizeof(T)));
+            if (!data) SMART_PTR_KIT_OUT_OF_MEMORY(capacity * sizeof(T));
+        } else {
+            data = static_cast<T*>(std::malloc(capacity * sizeof(T)));
+            if (!data) SMART_PTR_KIT_OUT_OF_MEMORY(capacity * sizeof(T));
+            uninitialized_relocate(m_data, m_data + m_size, data);
+            std::free(m_data);
+        }
+        m_data = data;
+        m_capacity = capacity;
+    }
+
+    T* m_data = nullptr;
+    std::size_t m_size = 0;
+    std::size_t m_capacity = 0;
+};
+
+} // namespace sptr
+
+#endif // SMART_PTR_KIT_RELOCATE_HPP
@@ -0,0 +1,128 @@
+#ifndef SMART_PTR_KIT_SCOPED_SHARED_HPP
+#define SMART_PTR_KIT_SCOPED_SHARED_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <utility>
+
+#include "shared_ptr.hpp"
+#include "weak_ptr.hpp"
+
+namespace sptr {
+
+// What ~scoped_shared does about references still outstanding
+enum class scope_exit {
+    wait,   // block until they are all returned
+    abort,  // report and abort: a leaked reference is a bug
+};
+
+namespace detail {
+    // Control block living inside a scoped_shared, object included. Nothing
+    // is freed: destroy() only records that the last reference is gone.
+    template <typename T>
+    class scoped_control_block : public control_block {
+    public:
+        template <typename... Args>
+        explicit scoped_control_block(Args&&... args) {
+            new(&m_storage) T(std::forward<Args>(args)...);
+        }
+
+        void dispose() noexcept override {
+            get()->~T();
+        }
+
+        void destroy() noexcept override {
+            m_released.store(true, std::memory_order_release);
+        }
+
+        T* get() const noexcept {
+            return const_cast<T*>(reinterpret_cast<const T*>(&m_storage));
+        }
+
+        bool released() const noexcept {
+            return m_released.load(std::memory_order_acquire);
+        }
+
+    private:
+        mutable typename std::aligned_storage<sizeof(T), alignof(T)>::type m_storage;
+        std::atomic<bool> m_released{false};
+    };
+}
+
+// An object and its control block on the stack, for fork/join scopes that
+// share it with workers through ordinary shared_ptr/weak_ptr signatures,
+// without a heap allocation. The scope holds one reference; at scope exit
+// every shared_ptr and weak_ptr handed out must have been returned before the
+// frame can go away, so the destructor waits for them (or aborts).
+//
+// Strong references are awaited on the futex behind wait_until_unique();
+// stragglers holding only weak_ptrs are polled, as those are expected to be
+// short-lived. A worker whose release() woke the scope may still be inside
+// that call when the frame goes away; release() never reads the block after
+// its decrement, so all it can do is a spurious futex wake on a dead address.
+template <typename T, scope_exit Exit = scope_exit::wait>
+class scoped_shared {
+public:
+    template <typename... Args>
+    explicit scoped_shared(Args&&... args) : m_block(std::forward<Args>(args)...) {}
+
+    ~scoped_shared() {
+        if (m_block.use_count() > 1) {
+            if (Exit == scope_exit::abort) {
+                fail("shared_ptr");
+            }
+            m_block.wait_for_use_count(1, std::chrono::nanoseconds::max());
+        }
+        m_block.release();
+        while (!m_block.released()) {
+            if (Exit == scope_exit::abort) {
+                fail("weak_ptr");
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    scoped_shared(const scoped_shared&) = delete;
+    scoped_shared& operator=(const scoped_shared&) = delete;
+
+    shared_ptr<T> share() noexcept {
+        return detail::shared_access::share<T>(m_block.get(), &m_block);
+    }
+
+    weak_ptr<T> weak() noexcept {
+        return weak_ptr<T>(share());
+    }
+
+    T* get() const noexcept {
+        return m_block.get();
+    }
+
+    T& operator*() const noexcept {
+        return *m_block.get();
+    }
+
+    T* operator->() const noexcept {
+        return m_block.get();
+    }
+
+    // Owners, the scope itself included
+    long use_count() const noexcept {
+        return m_block.use_count();
+    }
+
+private:
+    [[noreturn]] static void fail(const char* kind) noexcept {
+        std::fprintf(stderr, "sptr: scoped_shared left its scope with a %s still outstanding\n", kind);
+        std::abort();
+    }
+
+    detail::scoped_control_block<T> m_block;
+};
+
+} // namespace sptr
+
+#endif // SMART_PTR_KIT_SCOPED_SHARED_HPP
@@ -4,59 +4,205 @@
 #include <utility>
 #include <type_traits>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <new>
+
+#include "oom_policy.hpp"
+#include "trace.hpp"
+#include "trivially_relocatable.hpp"
 
 namespace sptr {
 
+template <typename T>
+class shared_ptr;
+
+template <typename T>
+class weak_ptr;
+
+class dispose_hook;
+
 namespace detail {
+    // std::is_unbounded_array_v is C++20
+    template <typename T>
+    inline constexpr bool is_unbounded_array_v = std::is_array_v<T> && std::extent_v<T> == 0;
+    
+    class control_block;
+    
+    // Runs and unlinks every dispose_hook registered on the block
+    void run_dispose_hooks(control_block& ctrl) noexcept;
+    
+    // Parks on a 32-bit word while it holds expected, until woken or the
+    // timeout passes (futex on Linux, a short sleep elsewhere). May return
+    // spuriously, so callers re-check their condition.
+    void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected,
+                    std::chrono::nanoseconds timeout = std::chrono::nanoseconds::max()) noexcept;
+    void futex_wake_all(std::atomic<std::uint32_t>& word) noexcept;
+    
+#if defined(SMART_PTR_KIT_OUT_OF_LINE_COUNTS)
+    // A block's two counters, kept in a dense side table instead of the block
+    // itself: after fork() a child's refcount traffic dirties only table pages
+    // rather than the pages holding the objects next to their blocks
+    struct count_slot {
+        std::atomic<long> use_count;
+        std::atomic<long> weak_count;
+    };
+    
+    count_slot* acquire_count_slot();
+    void release_count_slot(count_slot* slot) noexcept;
+    // Makes sure this thread's next acquire_count_slot() cannot fail;
+    // returns false if the table is out of memory
+    bool reserve_count_slot() noexcept;
+#endif
+    
     class control_block {
     public:
-        control_block() : m_use_count(1), m_weak_count(0) {}
+        // The strong owners collectively hold one weak reference, released
+        // after dispose(), so the block cannot be destroyed from inside
+        // dispose() (e.g. when the object holds a weak_ptr to itself)
+#if defined(SMART_PTR_KIT_OUT_OF_LINE_COUNTS)
+        control_block() : m_counts(acquire_count_slot()) {
+            m_counts->use_count.store(1, std::memory_order_relaxed);
+            m_counts->weak_count.store(1, std::memory_order_relaxed);
+        }
+#else
+        control_block() : m_use_count(1), m_weak_count(1) {}
+#endif
         
         void add_reference() noexcept {
-            ++m_use_count;
+            SMART_PTR_KIT_TRACE_EVENT(trace_op::copy, this);
+            ++use_counter();
+        }
+        
+        // Takes a strong reference unless the count already dropped to zero;
+        // the CAS keeps a concurrent last release() from being revived
+        bool try_add_reference() noexcept {
+            long count = use_counter().load(std::memory_order_relaxed);
+            while ((count & count_mask) != 0) {
+                if (use_counter().compare_exchange_weak(count, count + 1, std::memory_order_acq_rel,
+                                                        std::memory_order_relaxed)) {
+                    SMART_PTR_KIT_TRACE_EVENT(trace_op::lock, this);
+                    return true;
+                }
+            }
+            SMART_PTR_KIT_TRACE_EVENT(trace_op::lock_failed, this);
+            return false;
         }
         
         void add_weak_reference() noexcept {
-            ++m_weak_count;
+            ++weak_counter();
         }
         
         // Releases ownership and decrements reference count
         // If reference count becomes zero, the resource is destroyed
         // Returns whether the control block itself was destroyed
         bool release() noexcept {
+            SMART_PTR_KIT_TRACE_EVENT(trace_op::release, this);
+            // Take the counter's address while this still owns a reference:
+            // once the count drops, a waiter may free the block (or leave the
+            // scope holding it), and the wake below must not read it again
+            std::atomic<long>& counter = use_counter();
             // Atomically decrement the reference count, and if it reaches zero
-            if (--m_use_count == 0) {
+            long count = --counter;
+            if ((count & count_mask) == 0) {
+                SMART_PTR_KIT_TRACE_EVENT(trace_op::dispose, this);
+                // Hooks see the object one last time, before its destructor
+                if (m_hooks.load(std::memory_order_acquire)) {
+                    run_dispose_hooks(*this);
+                }
                 // Destroy the resource (call its destructor)
                 dispose();
-                // If no weak references exist, destroy the control block itself
-                if (m_weak_count == 0) {
+                // Expiry waiters may still hold weak references, so the block
+                // outlives the wake-up
+                if (count & waiters_bit) {
+                    wake_use_count_waiters(counter);
+                }
+                // Drop the strong owners' weak reference; the last one out
+                // destroys the control block itself
+                if (--weak_counter() == 0) {
                     destroy();
                     return true;
                 }
+            } else if (count & waiters_bit) {
+                wake_use_count_waiters(counter);
             }
             return false;
         }
         
         // Decrements the weak reference count
-        // Destroys the control block if no strong references exist and no weak references remain
+        // Destroys the control block once the object is gone and no weak references remain
         void weak_release() noexcept {
-            if (--m_weak_count == 0 && m_use_count == 0) {
+            if (--weak_counter() == 0) {
                 destroy();
             }
         }
         
         long use_count() const noexcept {
-            return m_use_count;
+            return use_counter().load() & count_mask;
         }
         
+        // Blocks until use_count() <= target or the timeout passes; returns
+        // whether the count got there. Parks on a futex over the counter,
+        // and only releases that observe the waiters bit pay for a wake-up.
+        bool wait_for_use_count(long target, std::chrono::nanoseconds timeout) noexcept;
+        
         virtual void dispose() noexcept = 0;
         virtual void destroy() noexcept = 0;
+#if defined(SMART_PTR_KIT_OUT_OF_LINE_COUNTS)
+        virtual ~control_block() {
+            release_count_slot(m_counts);
+        }
+#else
         virtual ~control_block() = default;
+#endif
         
     private:
+        friend class sptr::dispose_hook;
+        friend void run_dispose_hooks(control_block& ctrl) noexcept;
+        
+        // Set in the use count once anyone has waited on it; releases that see
+        // it issue a futex wake
+        static constexpr long waiters_bit = 1L << (sizeof(long) * 8 - 2);
+        static constexpr long count_mask = waiters_bit - 1;
+        
+        // Only issues the wake on the counter's address, never loads from it:
+        // a stale address costs at most a spurious wake-up elsewhere
+        static void wake_use_count_waiters(std::atomic<long>& counter) noexcept;
+        
+#if defined(SMART_PTR_KIT_OUT_OF_LINE_COUNTS)
+        std::atomic<long>& use_counter() noexcept {
+            return m_counts->use_count;
+        }
+        
+        const std::atomic<long>& use_counter() const noexcept {
+            return m_counts->use_count;
+        }
+        
+        std::atomic<long>& weak_counter() noexcept {
+            return m_counts->weak_count;
+        }
+        
+        // Written once, at construction: reading it never dirties the page
+        count_slot* const m_counts;
+#else
+        std::atomic<long>& use_counter() noexcept {
+            return m_use_count;
+        }
+        
+        const std::atomic<long>& use_counter() const noexcept {
+            return m_use_count;
+        }
+        
+        std::atomic<long>& weak_counter() noexcept {
+            return m_weak_count;
+        }
+        
         std::atomic<long> m_use_count;
         std::atomic<long> m_weak_count;
+#endif
+        // Head of the dispose_hook list; null for almost every block
+        std::atomic<dispose_hook*> m_hooks{nullptr};
     };
     
     template <typename T, typename Deleter = std::default_delete<T>>
@@ -114,11 +260,195 @@ namespace detail {
         // Aligned storage for T
         mutable typename std::aligned_storage<sizeof(T), alignof(T)>::type m_storage;
     };
+    
+    // Like inplace_control_block, but the block itself is obtained from (and
+    // returned to) a user-supplied allocator instead of global new/delete
+    template <typename T, typename Alloc>
+    class inplace_alloc_control_block : public control_block {
+    public:
+        using allocator_type = typename std::allocator_traits<Alloc>::template
+            rebind_alloc<inplace_alloc_control_block>;
+        
+        template <typename... Args>
+        explicit inplace_alloc_control_block(const allocator_type& alloc, Args&&... args)
+            : m_alloc(alloc) {
+            new(&m_storage) T(std::forward<Args>(args)...);
+        }
+        
+        void dispose() noexcept override {
+            get_object()->~T();
+        }
+        
+        void destroy() noexcept override {
+            // Copy the allocator out before the block (and m_alloc) goes away
+            allocator_type alloc(m_alloc);
+            this->~inplace_alloc_control_block();
+            std::allocator_traits<allocator_type>::deallocate(alloc, this, 1);
+        }
+        
+        T* get() const noexcept {
+            return get_object();
+        }
+        
+    private:
+        T* get_object() const noexcept {
+            return const_cast<T*>(reinterpret_cast<const T*>(&m_storage));
+        }
+        
+        allocator_type m_alloc;
+        mutable typename std::aligned_storage<sizeof(T), alignof(T)>::type m_storage;
+    };
+    
+    // Control block for make_shared<T[]>: the n elements live directly behind
+    // the block in the same allocation (a flexible-array layout)
+    template <typename T, typename Alloc>
+    class inplace_array_control_block : public control_block {
+    public:
+        // Allocation unit aligned for both the block and the elements
+        struct alignas(alignof(T) > alignof(control_block*) ? alignof(T) : alignof(control_block*))
+        unit {
+            unsigned char bytes[alignof(T) > alignof(control_block*) ? alignof(T) : alignof(control_block*)];
+        };
+        using allocator_type = typename std::allocator_traits<Alloc>::template rebind_alloc<unit>;
+        
+        static std::size_t units_for(std::size_t n) noexcept {
+            return (elements_offset() + n * sizeof(T) + sizeof(unit) - 1) / sizeof(unit);
+        }
+        
+        // Bytes needed for n elements, saturating at SIZE_MAX
+        static std::size_t bytes_for(std::size_t n) noexcept {
+            if (n > (SIZE_MAX - elements_offset() - sizeof(unit)) / sizeof(T)) return SIZE_MAX;
+            return units_for(n) * sizeof(unit);
+        }
+        
+        // Null if n is too large or the allocator returns null
+        template <typename... Args>
+        static inplace_array_control_block* create(const Alloc& alloc, std::size_t n, const Args&... args) {
+            if (bytes_for(n) == SIZE_MAX) return nullptr;
+            allocator_type a(alloc);
+            unit* mem = std::allocator_traits<allocator_type>::allocate(a, units_for(n));
+            if (!mem) return nullptr;
+            auto* cb = new(mem) inplace_array_control_block(a, n);
+            std::size_t i = 0;
+            SMART_PTR_KIT_TRY {
+                for (; i < n; ++i) {
+                    new(cb->get() + i) T(args...);
+                }
+            } SMART_PTR_KIT_CATCH_ALL {
+                cb->destroy_elements(i);
+                cb->destroy();
+                SMART_PTR_KIT_RETHROW;
+            }
+            return cb;
+        }
+        
+        void dispose() noexcept override {
+            destroy_elements(m_size);
+        }
+        
+        void destroy() noexcept override {
+            allocator_type alloc(m_alloc);
+            std::size_t units = units_for(m_size);
+            this->~inplace_array_control_block();
+            std::allocator_traits<allocator_type>::deallocate(alloc, reinterpret_cast<unit*>(this), units);
+        }
+        
+        T* get() const noexcept {
+            auto* base = reinterpret_cast<unsigned char*>(const_cast<inplace_array_control_block*>(this));
+            return reinterpret_cast<T*>(base + elements_offset());
+        }
+        
+        std::size_t size() const noexcept {
+            return m_size;
+        }
+        
+    private:
+        inplace_array_control_block(const allocator_type& alloc, std::size_t n)
+            : m_alloc(alloc), m_size(n) {}
+        
+        static constexpr std::size_t elements_offset() noexcept {
+            return (sizeof(inplace_array_control_block) + alignof(T) - 1) / alignof(T) * alignof(T);
+        }
+        
+        void destroy_elements(std::size_t count) noexcept {
+            T* elements = get();
+            for (std::size_t i = count; i > 0; --i) {
+                elements[i - 1].~T();
+            }
+        }
+        
+        allocator_type m_alloc;
+        std::size_t m_size;
+    };
+    
+    // std::allocator that returns null instead of throwing, for the default
+    // make_shared<T[]> block
+    template <typename T>
+    struct nothrow_allocator {
+        using value_type = T;
+        
+        nothrow_allocator() noexcept = default;
+        template <typename U>
+        nothrow_allocator(const nothrow_allocator<U>&) noexcept {}
+        
+        T* allocate(std::size_t n) noexcept {
+            if (n > SIZE_MAX / sizeof(T)) return nullptr;
+            if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+                return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T)), std::nothrow));
+            } else {
+                return static_cast<T*>(::operator new(n * sizeof(T), std::nothrow));
+            }
+        }
+        
+        void deallocate(T* p, std::size_t) noexcept {
+            if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+                ::operator delete(p, std::align_val_t(alignof(T)));
+            } else {
+                ::operator delete(p);
+            }
+        }
+        
+        template <typename U>
+        bool operator==(const nothrow_allocator<U>&) const noexcept { return true; }
+        template <typename U>
+        bool operator!=(const nothrow_allocator<U>&) const noexcept { return false; }
+    };
+    
+    // Grants the factory functions access to shared_ptr's private members
+    struct shared_access {
+        // Adopts a freshly created control block (whose count is already 1)
+        template <typename T>
+        static shared_ptr<T> adopt(std::remove_extent_t<T>* ptr, control_block* ctrl) noexcept {
+            shared_ptr<T> result;
+            result.m_ptr = ptr;
+            result.m_ctrl = ctrl;
+            return result;
+        }
+        
+        // Takes an additional reference on an existing control block
+        template <typename T>
+        static shared_ptr<T> share(std::remove_extent_t<T>* ptr, control_block* ctrl) noexcept {
+            return shared_ptr<T>(ptr, ctrl);
+        }
+        
+        template <typename T>
+        static control_block* control(const shared_ptr<T>& p) noexcept {
+            return p.m_ctrl;
+        }
+        
+        template <typename T>
+        static control_block* control(const weak_ptr<T>& p) noexcept {
+            return p.m_ctrl;
+        }
+        
+        // The stored pointer of a weak_ptr, valid only while it is not expired
+        template <typename T>
+        static T* pointer(const weak_ptr<T>& p) noexcept {
+            return p.m_ptr;
+        }
+    };
 }
 
-template <typename T>
-class weak_ptr;
-
 // like a Rc<T>, Arc<T>
 template <typename T>
 class shared_ptr {
@@ -130,9 +460,8 @@ class shared_ptr {
     template <typename U>
     friend class weak_ptr;
     
-    // Make make_shared friend
-    template <typename U, typename... Args>
-    friend shared_ptr<U> make_shared(Args&&...);
+    // Factories build results through detail::shared_access
+    friend struct detail::shared_access;
     
     // Make cast functions friends
     template <typename U, typename V>
@@ -147,20 +476,22 @@ class shared_ptr {
     template <typename U, typename V>
     friend shared_ptr<U> reinterpret_pointer_cast(const shared_ptr<V>&) noexcept;
 public:
-    using element_type = T;
+    // For shared_ptr<U[]> this is U; m_ptr points at the first element
+    using element_type = std::remove_extent_t<T>;
     
     constexpr shared_ptr() noexcept : m_ptr(nullptr), m_ctrl(nullptr) {}
     constexpr shared_ptr(std::nullptr_t) noexcept : m_ptr(nullptr), m_ctrl(nullptr) {}
     
     template <typename Y, typename = std::enable_if_t<std::is_convertible_v<Y*, T*>>>
     explicit shared_ptr(Y* ptr) {
-        try {
-            m_ctrl = new detail::ptr_control_block<Y>(ptr);
-            m_ptr = ptr;
-        } catch (...) {
+        m_ctrl = new (std::nothrow) detail::ptr_control_block<Y>(ptr);
+        if (!m_ctrl) {
+            // ptr is ours either way
             delete ptr;
-            throw;
+            SMART_PTR_KIT_OUT_OF_MEMORY(sizeof(detail::ptr_control_block<Y>));
         }
+        m_ptr = ptr;
+        SMART_PTR_KIT_TRACE_EVENT(trace_op::make, m_ctrl, sizeof(Y));
     }
     
     shared_ptr(const shared_ptr& other) noexcept
@@ -174,8 +505,16 @@ public:
         if (m_ctrl) m_ctrl->add_reference();
     }
     
+    // Aliasing constructor: shares ownership with other but points at ptr
+    template <typename Y>
+    shared_ptr(const shared_ptr<Y>& other, element_type* ptr) noexcept
+        : m_ptr(ptr), m_ctrl(other.m_ctrl) {
+        if (m_ctrl) m_ctrl->add_reference();
+    }
+    
     shared_ptr(shared_ptr&& other) noexcept
         : m_ptr(other.m_ptr), m_ctrl(other.m_ctrl) {
+        if (m_ctrl) SMART_PTR_KIT_TRACE_EVENT(trace_op::move, m_ctrl);
         other.m_ptr = nullptr;
         other.m_ctrl = nullptr;
     }
@@ -183,6 +522,7 @@ public:
     template <typename Y, typename = std::enable_if_t<std::is_convertible_v<Y*, T*>>>
     shared_ptr(shared_ptr<Y>&& other) noexcept
         : m_ptr(other.m_ptr), m_ctrl(other.m_ctrl) {
+        if (m_ctrl) SMART_PTR_KIT_TRACE_EVENT(trace_op::move, m_ctrl);
         other.m_ptr = nullptr;
         other.m_ctrl = nullptr;
     }
@@ -215,22 +555,35 @@ public:
         std::swap(m_ctrl, other.m_ctrl);
     }
     
-    T* get() const noexcept {
+    element_type* get() const noexcept {
         return m_ptr;
     }
     
-    T& operator*() const noexcept {
+    element_type& operator*() const noexcept {
         return *m_ptr;
     }
     
-    T* operator->() const noexcept {
+    element_type* operator->() const noexcept {
         return m_ptr;
     }
     
+    template <typename U = T, typename = std::enable_if_t<std::is_array_v<U>>>
+    element_type& operator[](std::ptrdiff_t i) const noexcept {
+        return m_ptr[i];
+    }
+    
     long use_count() const noexcept {
         return m_ctrl ? m_ctrl->use_count() : 0;
     }
     
+    // Waits until this is the only owner left (use_count() <= 1), e.g. before
+    // tearing down a swapped-out config; returns false on timeout
+    template <typename Rep = long long, typename Period = std::nano>
+    bool wait_until_unique(std::chrono::duration<Rep, Period> timeout = std::chrono::nanoseconds::max()) const noexcept {
+        if (!m_ctrl) return true;
+        return m_ctrl->wait_for_use_count(1, std::chrono::duration_cast<std::chrono::nanoseconds>(timeout));
+    }
+    
     explicit operator bool() const noexcept {
         return m_ptr != nullptr;
     }
@@ -242,23 +595,90 @@ private:
         if (m_ctrl) m_ctrl->add_reference();
     }
     
-    T* m_ptr;
+    element_type* m_ptr;
     detail::control_block* m_ctrl;
 };
 
+// Allocation failure goes through the out-of-memory policy (oom_policy.hpp):
+// the handler, then std::bad_alloc or, without exceptions, abort
 template <typename T, typename... Args>
-shared_ptr<T> make_shared(Args&&... args) {
-    try {
-        // Create a control block with the object in-place
-        auto cb = new detail::inplace_control_block<T>(std::forward<Args>(args)...);
-        shared_ptr<T> result;
-        // Use private constructor to set the pointer and control block
-        result.m_ptr = cb->get();
-        result.m_ctrl = cb;
-        return result;
-    } catch (...) {
-        throw;
+std::enable_if_t<!std::is_array_v<T>, shared_ptr<T>> make_shared(Args&&... args) {
+    // Create a control block with the object in-place
+    auto cb = new (std::nothrow) detail::inplace_control_block<T>(std::forward<Args>(args)...);
+    if (!cb) SMART_PTR_KIT_OUT_OF_MEMORY(sizeof(detail::inplace_control_block<T>));
+    SMART_PTR_KIT_TRACE_EVENT(trace_op::make, cb, sizeof(T));
+    return detail::shared_access::adopt<T>(cb->get(), cb);
+}
+
+// Like make_shared, but an allocation failure returns an empty pointer (and
+// does not run the out-of-memory handler). noexcept when T's constructor is.
+template <typename T, typename... Args>
+std::enable_if_t<!std::is_array_v<T>, shared_ptr<T>> try_make_shared(Args&&... args) noexcept(
+    std::is_nothrow_constructible_v<T, Args&&...>) {
+#if defined(SMART_PTR_KIT_OUT_OF_LINE_COUNTS)
+    // The block's count slot must not be an allocation that can fail
+    if (!detail::reserve_count_slot()) return shared_ptr<T>();
+#endif
+    auto cb = new (std::nothrow) detail::inplace_control_block<T>(std::forward<Args>(args)...);
+    if (!cb) return shared_ptr<T>();
+    SMART_PTR_KIT_TRACE_EVENT(trace_op::make, cb, sizeof(T));
+    return detail::shared_access::adopt<T>(cb->get(), cb);
+}
+
+// make_shared<U[]>(n): one allocation holding the control block and n
+// value-initialized elements
+template <typename T>
+std::enable_if_t<detail::is_unbounded_array_v<T>, shared_ptr<T>> make_shared(std::size_t n) {
+    using element = std::remove_extent_t<T>;
+    using block_type = detail::inplace_array_control_block<element, detail::nothrow_allocator<element>>;
+    auto cb = block_type::create(detail::nothrow_allocator<element>(), n);
+    if (!cb) SMART_PTR_KIT_OUT_OF_MEMORY(block_type::bytes_for(n));
+    SMART_PTR_KIT_TRACE_EVENT(trace_op::make, cb, n * sizeof(element));
+    return detail::shared_access::adopt<T>(cb->get(), cb);
+}
+
+template <typename T>
+std::enable_if_t<detail::is_unbounded_array_v<T>, shared_ptr<T>> try_make_shared(std::size_t n) noexcept(
+    std::is_nothrow_default_constructible_v<std::remove_extent_t<T>>) {
+    using element = std::remove_extent_t<T>;
+    using block_type = detail::inplace_array_control_block<element, detail::nothrow_allocator<element>>;
+#if defined(SMART_PTR_KIT_OUT_OF_LINE_COUNTS)
+    if (!detail::reserve_count_slot()) return shared_ptr<T>();
+#endif
+    auto cb = block_type::create(detail::nothrow_allocator<element>(), n);
+    if (!cb) return shared_ptr<T>();
+    SMART_PTR_KIT_TRACE_EVENT(trace_op::make, cb, n * sizeof(element));
+    return detail::shared_access::adopt<T>(cb->get(), cb);
+}
+
+// Same as make_shared, but the combined control block + object allocation
+// comes from alloc (rebound to the control block type)
+template <typename T, typename Alloc, typename... Args>
+std::enable_if_t<!std::is_array_v<T>, shared_ptr<T>> allocate_shared(const Alloc& alloc, Args&&... args) {
+    using block_type = detail::inplace_alloc_control_block<T, Alloc>;
+    using block_alloc = typename block_type::allocator_type;
+    using traits = std::allocator_traits<block_alloc>;
+    
+    block_alloc a(alloc);
+    block_type* cb = traits::allocate(a, 1);
+    if (!cb) SMART_PTR_KIT_OUT_OF_MEMORY(sizeof(block_type));
+    SMART_PTR_KIT_TRY {
+        new(cb) block_type(a, std::forward<Args>(args)...);
+    } SMART_PTR_KIT_CATCH_ALL {
+        traits::deallocate(a, cb, 1);
+        SMART_PTR_KIT_RETHROW;
     }
+    SMART_PTR_KIT_TRACE_EVENT(trace_op::make, cb, sizeof(T));
+    return detail::shared_access::adopt<T>(cb->get(), cb);
+}
+
+template <typename T, typename Alloc>
+std::enable_if_t<detail::is_unbounded_array_v<T>, shared_ptr<T>> allocate_shared(const Alloc& alloc, std::size_t n) {
+    using block_type = detail::inplace_array_control_block<std::remove_extent_t<T>, Alloc>;
+    auto cb = block_type::create(alloc, n);
+    if (!cb) SMART_PTR_KIT_OUT_OF_MEMORY(block_type::bytes_for(n));
+    SMART_PTR_KIT_TRACE_EVENT(trace_op::make, cb, n * sizeof(std::remove_extent_t<T>));
+    return detail::shared_access::adopt<T>(cb->get(), cb);
 }
 
 // Dynamic cast
@@ -307,6 +727,11 @@ shared_ptr<T> reinterpret_pointer_cast(const shared_ptr<U>& other) noexcept {
     return result;
 }
 
+// A moved-from shared_ptr is just two null pointers, and nothing refers
+// back to the shared_ptr's own address
+template <typename T>
+struct is_trivially_relocatable<shared_ptr<T>> : std::true_type {};
+
 } // namespace sptr
 
 #endif // SMART_PTR_KIT_SHARED_PTR_HPP
\ No newline at end of file
@@ -0,0 +1,249 @@
+#ifndef SMART_PTR_KIT_SHARED_STRING_HPP
+#define SMART_PTR_KIT_SHARED_STRING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "shared_ptr.hpp"
+
+namespace sptr {
+
+namespace detail {
+    // Header of a long shared_string: refcount (the control block), length
+    // and cached hash, with the characters directly behind it in the same
+    // allocation, as in make_shared<T[]>'s flexible layout
+    class string_block : public control_block {
+    public:
+        static string_block* create(const char* chars, std::size_t length);
+
+        void dispose() noexcept override {}
+        void destroy() noexcept override;
+
+        const char* chars() const noexcept {
+            return reinterpret_cast<const char*>(this + 1);
+        }
+
+        std::size_t length() const noexcept {
+            return m_length;
+        }
+
+        // Hash of the whole string, computed on first request. 0 means "not
+        // computed yet", so a string that really hashes to 0 just recomputes.
+        std::size_t hash() const noexcept {
+            std::size_t h = m_hash.load(std::memory_order_relaxed);
+            if (h == 0) {
+                h = std::hash<std::string_view>()(std::string_view(chars(), m_length));
+                m_hash.store(h, std::memory_order_relaxed);
+            }
+            return h;
+        }
+
+    private:
+        explicit string_block(std::size_t length) : m_length(length) {}
+
+        std::size_t m_length;
+        mutable std::atomic<std::size_t> m_hash{0};
+    };
+}
+
+// Immutable string that is cheap to copy across threads. Strings of up to
+// inline_capacity characters live inside the object itself; longer ones sit
+// in one refcounted allocation holding count, length, cached hash and the
+// characters, so a copy is a single atomic increment and substr() shares the
+// parent's storage instead of copying.
+//
+// The characters are not NUL-terminated in general (a shared substring ends
+// wherever it ends): use view() or str(), not a C string.
+class shared_string {
+public:
+    static constexpr std::size_t inline_capacity = 15;
+    static constexpr std::size_t npos = std::string_view::npos;
+
+    using value_type = char;
+    using size_type = std::size_t;
+    using const_iterator = const char*;
+    using iterator = const_iterator;
+
+    shared_string() noexcept : m_size(0) {
+        m_inline[0] = '\0';
+    }
+
+    shared_string(std::string_view s) : m_size(s.size()) {
+        if (m_size <= inline_capacity) {
+            store_inline(s);
+        } else {
+            m_heap.block = detail::string_block::create(s.data(), s.size());
+            m_heap.data = m_heap.block->chars();
+        }
+    }
+
+    shared_string(const char* s) : shared_string(std::string_view(s)) {}
+    shared_string(const std::string& s) : shared_string(std::string_view(s)) {}
+
+    shared_string(const shared_string& other) noexcept : m_size(other.m_size) {
+        if (is_inline()) {
+            std::memcpy(m_inline, other.m_inline, sizeof(m_inline));
+        } else {
+            m_heap = other.m_heap;
+            m_heap.block->add_reference();
+        }
+    }
+
+    shared_string(shared_string&& other) noexcept : m_size(other.m_size) {
+        std::memcpy(m_inline, other.m_inline, sizeof(m_inline));
+        other.m_size = 0;
+        other.m_inline[0] = '\0';
+    }
+
+    ~shared_string() {
+        if (!is_inline()) m_heap.block->release();
+    }
+
+    shared_string& operator=(const shared_string& other) noexcept {
+        shared_string(other).swap(*this);
+        return *this;
+    }
+
+    shared_string& operator=(shared_string&& other) noexcept {
+        shared_string(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    void swap(shared_string& other) noexcept {
+        // Both representations are plain bytes, block pointer included
+        char tmp[sizeof(m_inline)];
+        std::memcpy(tmp, m_inline, sizeof(tmp));
+        std::memcpy(m_inline, other.m_inline, sizeof(tmp));
+        std::memcpy(other.m_inline, tmp, sizeof(tmp));
+        std::swap(m_size, other.m_size);
+    }
+
+    const char* data() const noexcept {
+        return is_inline() ? m_inline : m_heap.data;
+    }
+
+    std::size_t size() const noexcept {
+        return m_size;
+    }
+
+    std::size_t length() const noexcept {
+        return m_size;
+    }
+
+    bool empty() const noexcept {
+        return m_size == 0;
+    }
+
+    const_iterator begin() const noexcept {
+        return data();
+    }
+
+    const_iterator end() const noexcept {
+        return data() + m_size;
+    }
+
+    char operator[](std::size_t i) const noexcept {
+        return data()[i];
+    }
+
+    std::string_view view() const noexcept {
+        return std::string_view(data(), m_size);
+    }
+
+    operator std::string_view() const noexcept {
+        return view();
+    }
+
+    std::string str() const {
+        return std::string(data(), m_size);
+    }
+
+    // Long substrings share this string's allocation; short ones are copied
+    // inline. Throws std::out_of_range if pos > size(), like std::string.
+    shared_string substr(std::size_t pos, std::size_t count = npos) const {
+        std::string_view part = view().substr(pos, count);
+        if (part.size() <= inline_capacity) {
+            return shared_string(part);
+        }
+        shared_string result;
+        result.m_size = part.size();
+        result.m_heap.data = part.data();
+        result.m_heap.block = m_heap.block;
+        m_heap.block->add_reference();
+        return result;
+    }
+
+    // Cached in the allocation when this is a whole long string
+    std::size_t hash() const noexcept {
+        if (!is_inline() && m_heap.data == m_heap.block->chars() && m_size == m_heap.block->length()) {
+            return m_heap.block->hash();
+        }
+        return std::hash<std::string_view>()(view());
+    }
+
+    // Strings sharing the allocation; 0 for inline strings
+    long use_count() const noexcept {
+        return is_inline() ? 0 : m_heap.block->use_count();
+    }
+
+    friend bool operator==(const shared_string& a, const shared_string& b) noexcept {
+        if (a.m_size != b.m_size) return false;
+        if (!a.is_inline() && a.m_heap.data == b.m_heap.data) return true;
+        return a.view() == b.view();
+    }
+
+    friend bool operator!=(const shared_string& a, const shared_string& b) noexcept {
+        return !(a == b);
+    }
+
+    friend bool operator<(const shared_string& a, const shared_string& b) noexcept {
+        return a.view() < b.view();
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const shared_string& s) {
+        return os << s.view();
+    }
+
+private:
+    bool is_inline() const noexcept {
+        return m_size <= inline_capacity;
+    }
+
+    void store_inline(std::string_view s) noexcept {
+        std::memcpy(m_inline, s.data(), s.size());
+        m_inline[s.size()] = '\0';
+    }
+
+    // The size picks the representation, so a shared_string is 24 bytes
+    // with no separate tag
+    std::size_t m_size;
+    union {
+        char m_inline[inline_capacity + 1];
+        struct {
+            const char* data;
+            detail::string_block* block;
+        } m_heap;
+    };
+};
+
+// Inline characters are addressed through the object, never a self pointer
+template <>
+struct is_trivially_relocatable<shared_string> : std::true_type {};
+
+} // namespace sptr
+
+namespace std {
+    template <>
+    struct hash<sptr::shared_string> {
+        size_t operator()(const sptr::shared_string& s) const noexcept {
+            return s.hash();
+        }
+    };
+}
+
+#endif // SMART_PTR_KIT_SHARED_STRING_HPP
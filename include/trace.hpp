@@ -0,0 +1,74 @@
+#ifndef SMART_PTR_KIT_TRACE_HPP
+#define SMART_PTR_KIT_TRACE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sptr {
+
+// Smart-pointer operation traces. A build configured with
+// -DSMART_PTR_KIT_TRACE=ON records every make, copy, move, release, lock
+// and dispose into per-thread buffers; full buffers are appended to the
+// trace file as they fill, so traces of long runs stream to disk instead of
+// accumulating in memory. bench/trace_replay_bench re-executes a trace against
+// other pointer and allocator configurations.
+//
+// The file is a trace_header followed by trace_records, grouped by buffer
+// rather than in global order: load_trace() sorts them by timestamp.
+
+enum class trace_op : std::uint8_t {
+    make,         // size = bytes of the object(s)
+    copy,         // a new strong reference
+    move,         // a strong reference changed hands, count untouched
+    release,      // a strong reference dropped
+    lock,         // weak_ptr::lock() (or another try_add_reference) succeeded
+    lock_failed,  // ... found the object already gone
+    dispose,      // the last strong reference dropped; the object dies
+};
+
+struct trace_record {
+    std::uint64_t timestamp_ns;  // steady clock
+    std::uint64_t block;         // control block address: an id, unique while the block lives
+    std::uint32_t size;
+    std::uint16_t thread;        // small per-process thread index
+    trace_op op;
+    std::uint8_t reserved;
+};
+
+static_assert(sizeof(trace_record) == 24, "trace records are 24 bytes on disk");
+
+struct trace_header {
+    char magic[8];  // "SPTRTRC1"
+    std::uint32_t record_size;
+    std::uint32_t reserved;
+};
+
+// Where the tracing build writes; defaults to $SMART_PTR_KIT_TRACE_FILE, or
+// sptr_trace.bin. Switching files flushes and closes the current one.
+void set_trace_file(const std::string& path);
+
+// Writes out the calling thread's pending records and flushes the file.
+// Other threads' buffers are written when they fill or their thread exits.
+// A no-op unless built with tracing.
+void flush_trace() noexcept;
+
+// Reads a trace file, sorted by timestamp. Throws std::runtime_error if the
+// file is missing or not a trace.
+std::vector<trace_record> load_trace(const std::string& path);
+
+namespace detail {
+    // Hot-path hook of the tracing build
+    void trace_event(trace_op op, const void* block, std::size_t size = 0) noexcept;
+}
+
+} // namespace sptr
+
+#if defined(SMART_PTR_KIT_TRACE)
+#define SMART_PTR_KIT_TRACE_EVENT(...) ::sptr::detail::trace_event(__VA_ARGS__)
+#else
+#define SMART_PTR_KIT_TRACE_EVENT(...) ((void)0)
+#endif
+
+#endif // SMART_PTR_KIT_TRACE_HPP
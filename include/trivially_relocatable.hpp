@@ -0,0 +1,20 @@
+#ifndef SMART_PTR_KIT_TRIVIALLY_RELOCATABLE_HPP
+#define SMART_PTR_KIT_TRIVIALLY_RELOCATABLE_HPP
+
+#include <type_traits>
+
+namespace sptr {
+
+// A type is trivially relocatable when moving an object to new storage and
+// destroying the source is equivalent to copying its bytes and forgetting
+// the source. Each type that qualifies without being trivially copyable
+// specializes this next to its own definition; relocate.hpp uses it.
+template <typename T>
+struct is_trivially_relocatable : std::bool_constant<std::is_trivially_copyable_v<T>> {};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+} // namespace sptr
+
+#endif // SMART_PTR_KIT_TRIVIALLY_RELOCATABLE_HPP
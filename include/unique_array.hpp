@@ -0,0 +1,183 @@
+#ifndef SMART_PTR_KIT_UNIQUE_ARRAY_HPP
+#define SMART_PTR_KIT_UNIQUE_ARRAY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+#include <span>
+#endif
+
+#include "oom_policy.hpp"
+#include "shared_ptr.hpp"
+
+namespace sptr {
+
+// Widest vector register we pad for (AVX-512); also the default alignment
+inline constexpr std::size_t simd_width = 64;
+
+namespace detail {
+    // Throws std::invalid_argument unless align is a power of two, and
+    // std::bad_alloc on failure
+    void* aligned_array_allocate(std::size_t bytes, std::size_t align);
+    void aligned_array_deallocate(void* p) noexcept;
+
+    // Largest n whose padded byte size does not overflow
+    template <typename T>
+    constexpr std::size_t max_padded_elements() noexcept {
+        return (SIZE_MAX - simd_width) / sizeof(T);
+    }
+
+    // Elements that fit once n elements are padded to a simd_width multiple;
+    // n must not exceed max_padded_elements<T>()
+    template <typename T>
+    constexpr std::size_t padded_count(std::size_t n) noexcept {
+        return (n * sizeof(T) + simd_width - 1) / simd_width * simd_width / sizeof(T);
+    }
+}
+
+template <typename T>
+class unique_array;
+
+// make_unique<T[]> with a known length and a buffer aligned to alignment
+// (at least alignof(T)). default_init skips value-initialization, so a
+// trivially constructible buffer is left unzeroed.
+template <typename T>
+std::enable_if_t<detail::is_unbounded_array_v<T>, unique_array<std::remove_extent_t<T>>>
+make_unique_aligned(std::size_t n, std::size_t alignment = simd_width, bool default_init = false);
+
+// Owning, sized, over-aligned array: a pointer and a length, nothing else.
+// The buffer is padded to a whole number of simd_width-byte vectors and the
+// padding elements are constructed too, so kernels may run full-width loads
+// and stores over [data(), data() + padded_size()) without a scalar tail.
+template <typename T>
+class unique_array {
+public:
+    using element_type = T;
+    using value_type = std::remove_cv_t<T>;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    constexpr unique_array() noexcept : m_data(nullptr), m_size(0) {}
+
+    ~unique_array() {
+        reset();
+    }
+
+    unique_array(unique_array&& other) noexcept
+        : m_data(other.m_data), m_size(other.m_size) {
+        other.m_data = nullptr;
+        other.m_size = 0;
+    }
+
+    unique_array& operator=(unique_array&& other) noexcept {
+        unique_array(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    unique_array(const unique_array&) = delete;
+    unique_array& operator=(const unique_array&) = delete;
+
+    T* data() const noexcept {
+        return m_data;
+    }
+
+    std::size_t size() const noexcept {
+        return m_size;
+    }
+
+    // Constructed elements including the vector padding
+    std::size_t padded_size() const noexcept {
+        return m_data ? detail::padded_count<T>(m_size) : 0;
+    }
+
+    bool empty() const noexcept {
+        return m_size == 0;
+    }
+
+    T& operator[](std::size_t i) const noexcept {
+        return m_data[i];
+    }
+
+    iterator begin() const noexcept {
+        return m_data;
+    }
+
+    iterator end() const noexcept {
+        return m_data + m_size;
+    }
+
+    void reset() noexcept {
+        if (!m_data) return;
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (std::size_t i = detail::padded_count<T>(m_size); i > 0; --i) {
+                m_data[i - 1].~T();
+            }
+        }
+        detail::aligned_array_deallocate(m_data);
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    void swap(unique_array& other) noexcept {
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+    }
+
+    explicit operator bool() const noexcept {
+        return m_data != nullptr;
+    }
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+    operator std::span<T>() const noexcept {
+        return std::span<T>(m_data, m_size);
+    }
+#endif
+
+private:
+    template <typename U>
+    friend std::enable_if_t<detail::is_unbounded_array_v<U>, unique_array<std::remove_extent_t<U>>>
+    make_unique_aligned(std::size_t n, std::size_t alignment, bool default_init);
+
+    unique_array(T* data, std::size_t size) noexcept : m_data(data), m_size(size) {}
+
+    T* m_data;
+    std::size_t m_size;
+};
+
+template <typename T>
+std::enable_if_t<detail::is_unbounded_array_v<T>, unique_array<std::remove_extent_t<T>>>
+make_unique_aligned(std::size_t n, std::size_t alignment, bool default_init) {
+    using element = std::remove_extent_t<T>;
+    if (alignment < alignof(element)) alignment = alignof(element);
+    if (n > detail::max_padded_elements<element>()) SMART_PTR_KIT_OUT_OF_MEMORY(SIZE_MAX);
+    std::size_t count = detail::padded_count<element>(n);
+    auto* p = static_cast<element*>(detail::aligned_array_allocate(count * sizeof(element), alignment));
+    std::size_t i = 0;
+    SMART_PTR_KIT_TRY {
+        for (; i < count; ++i) {
+            if (default_init) {
+                new(p + i) element;
+            } else {
+                new(p + i) element();
+            }
+        }
+    } SMART_PTR_KIT_CATCH_ALL {
+        for (; i > 0; --i) {
+            p[i - 1].~element();
+        }
+        detail::aligned_array_deallocate(p);
+        SMART_PTR_KIT_RETHROW;
+    }
+    return unique_array<element>(p, n);
+}
+
+template <typename T>
+struct is_trivially_relocatable<unique_array<T>> : std::true_type {};
+
+} // namespace sptr
+
+#endif // SMART_PTR_KIT_UNIQUE_ARRAY_HPP
@@ -4,12 +4,60 @@
 #include <utility>
 #include <type_traits>
 #include <memory>
+#include <new>
+
+#include "oom_policy.hpp"
+#include "trivially_relocatable.hpp"
 
 namespace sptr {
 
+namespace detail {
+    // Types with their own operator new keep it, and its failure behaviour
+    template <typename T, typename = void>
+    struct has_class_new : std::false_type {};
+    
+    template <typename T>
+    struct has_class_new<T, std::void_t<decltype(T::operator new(std::size_t(0)))>> : std::true_type {};
+    
+    // Holds a unique_ptr's deleter (or a deleter's allocator). Empty types
+    // such as default_delete become an empty base, so they take no space.
+    template <typename T, bool = std::is_empty_v<T> && !std::is_final_v<T>>
+    class compressed_storage {
+    public:
+        compressed_storage() = default;
+        explicit compressed_storage(T value) : m_value(std::move(value)) {}
+        
+        T& value() noexcept {
+            return m_value;
+        }
+        
+        const T& value() const noexcept {
+            return m_value;
+        }
+        
+    private:
+        T m_value{};
+    };
+    
+    template <typename T>
+    class compressed_storage<T, true> : private T {
+    public:
+        compressed_storage() = default;
+        explicit compressed_storage(T value) : T(std::move(value)) {}
+        
+        T& value() noexcept {
+            return *this;
+        }
+        
+        const T& value() const noexcept {
+            return *this;
+        }
+    };
+}
+
 template <typename T, typename Deleter = std::default_delete<T>>
 // like a box<T>
-class unique_ptr {
+class unique_ptr : private detail::compressed_storage<Deleter> {
 public:
     using pointer = T*;
     using element_type = T;
@@ -18,16 +66,19 @@ public:
     constexpr unique_ptr() noexcept : m_ptr(nullptr) {}
     constexpr unique_ptr(std::nullptr_t) noexcept : m_ptr(nullptr) {}
     explicit unique_ptr(pointer p) noexcept : m_ptr(p) {}
+    unique_ptr(pointer p, const deleter_type& d) noexcept : storage(d), m_ptr(p) {}
     
     ~unique_ptr() {
         reset();
     }
 
-    unique_ptr(unique_ptr&& other) noexcept : m_ptr(other.release()) {}
+    unique_ptr(unique_ptr&& other) noexcept
+        : storage(std::move(other.get_deleter())), m_ptr(other.release()) {}
 
     unique_ptr& operator=(unique_ptr&& other) noexcept {
         if (this != &other) {
             reset(other.release());
+            get_deleter() = std::move(other.get_deleter());
         }
         return *this;
     }
@@ -57,13 +108,13 @@ public:
         pointer old_ptr = m_ptr;
         m_ptr = p;
         if (old_ptr) {
-            m_deleter(old_ptr);
+            get_deleter()(old_ptr);
         }
     }
 
     void swap(unique_ptr& other) noexcept {
         std::swap(m_ptr, other.m_ptr);
-        std::swap(m_deleter, other.m_deleter);
+        std::swap(get_deleter(), other.get_deleter());
     }
 
     explicit operator bool() const noexcept {
@@ -71,21 +122,22 @@ public:
     }
     
     deleter_type& get_deleter() noexcept {
-        return m_deleter;
+        return storage::value();
     }
     
     const deleter_type& get_deleter() const noexcept {
-        return m_deleter;
+        return storage::value();
     }
 
 private:
+    using storage = detail::compressed_storage<Deleter>;
+
     pointer m_ptr;
-    deleter_type m_deleter{};
 };
 
 // Specialization for array types
 template <typename T, typename Deleter>
-class unique_ptr<T[], Deleter> {
+class unique_ptr<T[], Deleter> : private detail::compressed_storage<Deleter> {
 public:
     using pointer = T*;
     using element_type = T;
@@ -94,16 +146,19 @@ public:
     constexpr unique_ptr() noexcept : m_ptr(nullptr) {}
     constexpr unique_ptr(std::nullptr_t) noexcept : m_ptr(nullptr) {}
     explicit unique_ptr(pointer p) noexcept : m_ptr(p) {}
+    unique_ptr(pointer p, const deleter_type& d) noexcept : storage(d), m_ptr(p) {}
     
     ~unique_ptr() {
         reset();
     }
 
-    unique_ptr(unique_ptr&& other) noexcept : m_ptr(other.release()) {}
+    unique_ptr(unique_ptr&& other) noexcept
+        : storage(std::move(other.get_deleter())), m_ptr(other.release()) {}
 
     unique_ptr& operator=(unique_ptr&& other) noexcept {
         if (this != &other) {
             reset(other.release());
+            get_deleter() = std::move(other.get_deleter());
         }
         return *this;
     }
@@ -130,13 +185,13 @@ public:
         m_ptr = p;
         if (old_ptr) {
             // Use the deleter for arrays
-            m_deleter(old_ptr);
+            get_deleter()(old_ptr);
         }
     }
 
     void swap(unique_ptr& other) noexcept {
         std::swap(m_ptr, other.m_ptr);
-        std::swap(m_deleter, other.m_deleter);
+        std::swap(get_deleter(), other.get_deleter());
     }
 
     explicit operator bool() const noexcept {
@@ -144,21 +199,37 @@ public:
     }
     
     deleter_type& get_deleter() noexcept {
-        return m_deleter;
+        return storage::value();
     }
     
     const deleter_type& get_deleter() const noexcept {
-        return m_deleter;
+        return storage::value();
     }
 
 private:
+    using storage = detail::compressed_storage<Deleter>;
+
     pointer m_ptr;
-    deleter_type m_deleter{};
 };
 
+// Allocation failure goes through the out-of-memory policy (oom_policy.hpp)
 template <typename T, typename... Args>
 unique_ptr<T> make_unique(Args&&... args) {
-    return unique_ptr<T>(new T(std::forward<Args>(args)...));
+    if constexpr (detail::has_class_new<T>::value) {
+        return unique_ptr<T>(new T(std::forward<Args>(args)...));
+    } else {
+        T* p = new (std::nothrow) T(std::forward<Args>(args)...);
+        if (!p) SMART_PTR_KIT_OUT_OF_MEMORY(sizeof(T));
+        return unique_ptr<T>(p);
+    }
+}
+
+// Like make_unique, but an allocation failure returns an empty pointer.
+// noexcept when T's constructor is.
+template <typename T, typename... Args>
+unique_ptr<T> try_make_unique(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args&&...>) {
+    static_assert(!detail::has_class_new<T>::value, "T's own operator new decides how allocation fails");
+    return unique_ptr<T>(new (std::nothrow) T(std::forward<Args>(args)...));
 }
 
 // Specialization of make_unique for array types
@@ -172,6 +243,125 @@ template <typename T, typename... Args>
 typename std::enable_if<std::is_array<T>::value && std::extent<T>::value == 0, void>::type
 make_unique(Args&&...) = delete;
 
+// Deleter for objects obtained from an allocator: destroys and deallocates
+// through it. A stateless allocator is an empty base, so it adds nothing to
+// the unique_ptr; a stateful one is stored once, as is.
+template <typename Alloc>
+class allocator_delete : private detail::compressed_storage<Alloc> {
+    using storage = detail::compressed_storage<Alloc>;
+    using traits = std::allocator_traits<Alloc>;
+    
+public:
+    using allocator_type = Alloc;
+    using value_type = typename traits::value_type;
+    
+    static_assert(std::is_same_v<typename traits::pointer, value_type*>, "fancy pointers are not supported");
+    
+    allocator_delete() = default;
+    explicit allocator_delete(const Alloc& alloc) noexcept : storage(alloc) {}
+    
+    void operator()(value_type* p) const noexcept {
+        Alloc alloc(get_allocator());
+        traits::destroy(alloc, p);
+        traits::deallocate(alloc, p, 1);
+    }
+    
+    const Alloc& get_allocator() const noexcept {
+        return storage::value();
+    }
+};
+
+// Deleter for arrays from allocate_unique<T[]>: also carries the element
+// count, which Allocator::deallocate needs back
+template <typename Alloc>
+class allocator_array_delete : private detail::compressed_storage<Alloc> {
+    using storage = detail::compressed_storage<Alloc>;
+    using traits = std::allocator_traits<Alloc>;
+    
+public:
+    using allocator_type = Alloc;
+    using value_type = typename traits::value_type;
+    
+    static_assert(std::is_same_v<typename traits::pointer, value_type*>, "fancy pointers are not supported");
+    
+    allocator_array_delete() = default;
+    allocator_array_delete(const Alloc& alloc, std::size_t count) noexcept : storage(alloc), m_count(count) {}
+    
+    void operator()(value_type* p) const noexcept {
+        Alloc alloc(get_allocator());
+        for (std::size_t i = m_count; i > 0; --i) {
+            traits::destroy(alloc, p + i - 1);
+        }
+        traits::deallocate(alloc, p, m_count);
+    }
+    
+    const Alloc& get_allocator() const noexcept {
+        return storage::value();
+    }
+    
+    std::size_t size() const noexcept {
+        return m_count;
+    }
+    
+private:
+    std::size_t m_count = 0;
+};
+
+namespace detail {
+    template <typename Alloc, typename T>
+    using rebind_alloc_t = typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+}
+
+// make_unique with the memory from alloc (rebound to T), e.g. a pool or an
+// arena; the deleter gives it back to the same allocator
+template <typename T, typename Alloc, typename... Args>
+std::enable_if_t<!std::is_array_v<T>, unique_ptr<T, allocator_delete<detail::rebind_alloc_t<Alloc, T>>>>
+allocate_unique(const Alloc& alloc, Args&&... args) {
+    using A = detail::rebind_alloc_t<Alloc, T>;
+    using traits = std::allocator_traits<A>;
+    A a(alloc);
+    T* p = traits::allocate(a, 1);
+    if (!p) SMART_PTR_KIT_OUT_OF_MEMORY(sizeof(T));
+    SMART_PTR_KIT_TRY {
+        traits::construct(a, p, std::forward<Args>(args)...);
+    } SMART_PTR_KIT_CATCH_ALL {
+        traits::deallocate(a, p, 1);
+        SMART_PTR_KIT_RETHROW;
+    }
+    return unique_ptr<T, allocator_delete<A>>(p, allocator_delete<A>(a));
+}
+
+// allocate_unique<U[]>(alloc, n): n value-initialized elements
+template <typename T, typename Alloc>
+std::enable_if_t<std::is_array_v<T> && std::extent_v<T> == 0,
+                 unique_ptr<T, allocator_array_delete<detail::rebind_alloc_t<Alloc, std::remove_extent_t<T>>>>>
+allocate_unique(const Alloc& alloc, std::size_t n) {
+    using element = std::remove_extent_t<T>;
+    using A = detail::rebind_alloc_t<Alloc, element>;
+    using traits = std::allocator_traits<A>;
+    A a(alloc);
+    element* p = traits::allocate(a, n);
+    if (!p && n != 0) SMART_PTR_KIT_OUT_OF_MEMORY(n * sizeof(element));
+    std::size_t i = 0;
+    SMART_PTR_KIT_TRY {
+        for (; i < n; ++i) {
+            traits::construct(a, p + i);
+        }
+    } SMART_PTR_KIT_CATCH_ALL {
+        for (; i > 0; --i) {
+            traits::destroy(a, p + i - 1);
+        }
+        traits::deallocate(a, p, n);
+        SMART_PTR_KIT_RETHROW;
+    }
+    return unique_ptr<T, allocator_array_delete<A>>(p, allocator_array_delete<A>(a, n));
+}
+
+// As relocatable as its deleter; empty deleters such as std::default_delete
+// are trivially copyable
+template <typename T, typename Deleter>
+struct is_trivially_relocatable<unique_ptr<T, Deleter>> : is_trivially_relocatable<Deleter> {};
+
 } // namespace sptr
 
 #endif // SMART_PTR_KIT_UNIQUE_PTR_HPP
\ No newline at end of file
@@ -0,0 +1,80 @@
+#ifndef SMART_PTR_KIT_WEAK_BIND_HPP
+#define SMART_PTR_KIT_WEAK_BIND_HPP
+
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "shared_ptr.hpp"
+#include "weak_ptr.hpp"
+
+namespace sptr {
+
+// A member function bound to a weak_ptr: the completion handler that does
+// not keep its target alive. Calling it locks the target, runs the member if
+// the object is still there and otherwise does nothing.
+//
+// The binder is the member pointer plus the weak_ptr, 32 bytes with no
+// allocation. A call costs one CAS to take the reference and one decrement
+// to drop it; no shared_ptr is materialized. Void members report whether
+// they ran; others return std::optional of their result.
+template <typename MemFn, typename T>
+class weak_binder {
+public:
+    weak_binder(MemFn fn, weak_ptr<T> target) noexcept : m_fn(fn), m_target(std::move(target)) {}
+
+    template <typename... Args>
+    auto operator()(Args&&... args) const {
+        using result = std::invoke_result_t<MemFn, T&, Args...>;
+        detail::control_block* ctrl = detail::shared_access::control(m_target);
+        bool alive = ctrl && ctrl->try_add_reference();
+        if constexpr (std::is_void_v<result>) {
+            if (!alive) {
+                return false;
+            }
+            reference_guard guard{ctrl};
+            std::invoke(m_fn, *detail::shared_access::pointer(m_target), std::forward<Args>(args)...);
+            return true;
+        } else {
+            if (!alive) {
+                return std::optional<result>();
+            }
+            reference_guard guard{ctrl};
+            return std::optional<result>(
+                std::invoke(m_fn, *detail::shared_access::pointer(m_target), std::forward<Args>(args)...));
+        }
+    }
+
+    bool expired() const noexcept {
+        return m_target.expired();
+    }
+
+private:
+    // Drops the call's reference even if the member throws
+    struct reference_guard {
+        detail::control_block* ctrl;
+        ~reference_guard() {
+            ctrl->release();
+        }
+    };
+
+    MemFn m_fn;
+    weak_ptr<T> m_target;
+};
+
+template <typename MemFn, typename T>
+weak_binder<MemFn, T> weak_bind(MemFn fn, const shared_ptr<T>& target) noexcept {
+    static_assert(std::is_member_function_pointer_v<MemFn>, "weak_bind binds member functions");
+    return weak_binder<MemFn, T>(fn, weak_ptr<T>(target));
+}
+
+template <typename MemFn, typename T>
+weak_binder<MemFn, T> weak_bind(MemFn fn, weak_ptr<T> target) noexcept {
+    static_assert(std::is_member_function_pointer_v<MemFn>, "weak_bind binds member functions");
+    return weak_binder<MemFn, T>(fn, std::move(target));
+}
+
+} // namespace sptr
+
+#endif // SMART_PTR_KIT_WEAK_BIND_HPP
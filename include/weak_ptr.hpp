@@ -8,7 +8,11 @@ namespace sptr {
 // like a Weak<T>
 template <typename T>
 class weak_ptr {
+    friend struct detail::shared_access;
+    
 public:
+    using element_type = T;
+    
     constexpr weak_ptr() noexcept : m_ptr(nullptr), m_ctrl(nullptr) {}
     
     weak_ptr(const weak_ptr& other) noexcept
@@ -71,11 +75,20 @@ public:
         return use_count() == 0;
     }
     
+    // Waits until every owner has let go; returns false on timeout. The last
+    // owner may still be finishing the object's destructor when this returns.
+    template <typename Rep = long long, typename Period = std::nano>
+    bool wait_until_expired(std::chrono::duration<Rep, Period> timeout = std::chrono::nanoseconds::max()) const noexcept {
+        if (!m_ctrl) return true;
+        return m_ctrl->wait_for_use_count(0, std::chrono::duration_cast<std::chrono::nanoseconds>(timeout));
+    }
+    
     shared_ptr<T> lock() const noexcept {
-        if (expired()) {
-            return shared_ptr<T>();
+        // A plain expired() check would race with the last owner's release()
+        if (m_ctrl && m_ctrl->try_add_reference()) {
+            return detail::shared_access::adopt<T>(m_ptr, m_ctrl);
         }
-        return shared_ptr<T>(m_ptr, m_ctrl);
+        return shared_ptr<T>();
     }
     
 private:
@@ -83,6 +96,9 @@ private:
     detail::control_block* m_ctrl;
 };
 
+template <typename T>
+struct is_trivially_relocatable<weak_ptr<T>> : std::true_type {};
+
 } // namespace sptr
 
 #endif // SMART_PTR_KIT_WEAK_PTR_HPP
\ No newline at end of file
@@ -0,0 +1,98 @@
+#ifndef SMART_PTR_KIT_WEAK_SCAN_HPP
+#define SMART_PTR_KIT_WEAK_SCAN_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "shared_ptr.hpp"
+#include "weak_ptr.hpp"
+
+namespace sptr {
+
+// Bulk lock() over contiguous ranges of weak_ptr (std::vector, arrays,
+// relocating_vector). Locking each entry is a dependent miss on its control
+// block; these scans prefetch the block a fixed distance ahead so the misses
+// overlap instead of serializing.
+//
+// Passing compact_expired also moves the live entries to the front of the
+// container and erases the expired tail in the same pass.
+
+struct compact_expired_t {
+    explicit compact_expired_t() = default;
+};
+
+inline constexpr compact_expired_t compact_expired{};
+
+namespace detail {
+    // Entries between prefetch and use; 16 measured best on shuffled
+    // 10M-entry arrays (weak_scan_bench), 4 and 32 were both slower
+    inline constexpr std::size_t weak_prefetch_distance = 16;
+
+    // Calls f(shared_ptr<T>&&) for every entry that could be locked. With
+    // Compact, live entries are packed to the front and the live count is
+    // returned; otherwise n is.
+    template <bool Compact, typename Weak, typename F>
+    std::size_t scan_weak(Weak* entries, std::size_t n, F&& f) {
+        using T = typename Weak::element_type;
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            if (i + weak_prefetch_distance < n) {
+                if (control_block* ahead = shared_access::control(entries[i + weak_prefetch_distance])) {
+                    // Write intent: the count is about to be CASed
+                    __builtin_prefetch(ahead, 1, 3);
+                }
+            }
+            Weak& w = entries[i];
+            control_block* ctrl = shared_access::control(w);
+            if (!ctrl || !ctrl->try_add_reference()) {
+                continue;
+            }
+            f(shared_access::adopt<T>(shared_access::pointer(w), ctrl));
+            if constexpr (Compact) {
+                if (kept != i) entries[kept] = std::move(w);
+                ++kept;
+            }
+        }
+        return Compact ? kept : n;
+    }
+}
+
+// Appends a shared_ptr for every live entry to out; returns the new end
+template <typename Range, typename OutputIt>
+OutputIt lock_all(const Range& weak_range, OutputIt out) {
+    detail::scan_weak<false>(std::data(weak_range), std::size(weak_range),
+                             [&](auto&& p) { *out++ = std::move(p); });
+    return out;
+}
+
+template <typename Range, typename OutputIt>
+OutputIt lock_all(Range& weak_range, OutputIt out, compact_expired_t) {
+    std::size_t kept = detail::scan_weak<true>(std::data(weak_range), std::size(weak_range),
+                                               [&](auto&& p) { *out++ = std::move(p); });
+    weak_range.erase(std::begin(weak_range) + kept, std::end(weak_range));
+    return out;
+}
+
+// Calls f(element&) for every live entry while holding a strong reference
+// to it; returns how many entries were alive
+template <typename Range, typename F>
+std::size_t for_each_alive(const Range& weak_range, F f) {
+    std::size_t alive = 0;
+    detail::scan_weak<false>(std::data(weak_range), std::size(weak_range),
+                             [&](auto&& p) { f(*p); ++alive; });
+    return alive;
+}
+
+template <typename Range, typename F>
+std::size_t for_each_alive(Range& weak_range, F f, compact_expired_t) {
+    std::size_t kept = detail::scan_weak<true>(std::data(weak_range), std::size(weak_range),
+                                               [&](auto&& p) { f(*p); });
+    weak_range.erase(std::begin(weak_range) + kept, std::end(weak_range));
+    return kept;
+}
+
+} // namespace sptr
+
+#endif // SMART_PTR_KIT_WEAK_SCAN_HPP
@@ -0,0 +1,46 @@
+#include "bump_arena.hpp"
+#include "oom_policy.hpp"
+#include "page_map.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+
+namespace sptr {
+
+namespace detail {
+
+bump_arena::~bump_arena() {
+    for (void* chunk : m_chunks) {
+        std::free(chunk);
+    }
+}
+
+void* bump_arena::allocate(std::size_t size, std::size_t align) {
+    auto aligned = [align](char* p) {
+        return reinterpret_cast<char*>(round_up(reinterpret_cast<std::uintptr_t>(p), align));
+    };
+    char* p = m_cursor ? aligned(m_cursor) : nullptr;
+    if (!p || p > m_limit || size > static_cast<std::size_t>(m_limit - p)) {
+        if (size > SIZE_MAX - align) {
+            SMART_PTR_KIT_OUT_OF_MEMORY(size);
+        }
+        // Oversized requests get a chunk of their own
+        std::size_t bytes = size + align > chunk_size ? size + align : chunk_size;
+        m_chunks.reserve(m_chunks.size() + 1);
+        void* chunk = std::malloc(bytes);
+        if (!chunk) {
+            SMART_PTR_KIT_OUT_OF_MEMORY(bytes);
+        }
+        m_chunks.push_back(chunk);
+        m_reserved += bytes;
+        m_cursor = static_cast<char*>(chunk);
+        m_limit = m_cursor + bytes;
+        p = aligned(m_cursor);
+    }
+    m_cursor = p + size;
+    return p;
+}
+
+} // namespace detail
+
+} // namespace sptr
@@ -0,0 +1,169 @@
+#include "shared_ptr.hpp"
+#include "oom_policy.hpp"
+
+#if defined(SMART_PTR_KIT_OUT_OF_LINE_COUNTS)
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace sptr {
+
+namespace detail {
+
+namespace {
+    // Free slots are threaded through their own storage
+    struct free_slot {
+        free_slot* next;
+    };
+
+    static_assert(sizeof(free_slot) <= sizeof(count_slot), "a free slot must fit in a count slot");
+
+    // 4096 slots per chunk. Chunks come straight from mmap so no heap object
+    // shares their pages, and they are never returned: the table only grows
+    // to the peak number of live control blocks.
+    constexpr std::size_t chunk_bytes = std::size_t(64) << 10;
+    constexpr std::size_t batch = 32;
+
+    struct count_table {
+        std::mutex lock;
+        free_slot* free = nullptr;
+        char* cursor = nullptr;
+        char* limit = nullptr;
+
+        // Hands out up to n slots as a list; returns how many, 0 only if
+        // the table could not grow
+        std::size_t take(free_slot*& out, std::size_t n) noexcept {
+            std::lock_guard<std::mutex> guard(lock);
+            std::size_t taken = 0;
+            for (; taken < n; ++taken) {
+                free_slot* slot = free;
+                if (slot) {
+                    free = slot->next;
+                } else {
+                    if (cursor == limit) {
+                        if (taken != 0 || !grow()) break;
+                    }
+                    slot = reinterpret_cast<free_slot*>(cursor);
+                    cursor += sizeof(count_slot);
+                }
+                slot->next = out;
+                out = slot;
+            }
+            return taken;
+        }
+
+        void give(free_slot* first, free_slot* last) noexcept {
+            std::lock_guard<std::mutex> guard(lock);
+            last->next = free;
+            free = first;
+        }
+
+        bool grow() noexcept {
+#if defined(__linux__)
+            void* chunk = mmap(nullptr, chunk_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (chunk == MAP_FAILED) return false;
+#else
+            void* chunk = ::operator new(chunk_bytes, std::nothrow);
+            if (!chunk) return false;
+#endif
+            cursor = static_cast<char*>(chunk);
+            limit = cursor + chunk_bytes;
+            return true;
+        }
+    };
+
+    count_table& table() {
+        // Leaked on purpose: control blocks may die during static destruction
+        static count_table* instance = new count_table();
+        return *instance;
+    }
+
+    // Per-thread stash so most blocks never touch the table's mutex. It is
+    // trivially destructible and stays usable after the thread's flush.
+    struct slot_cache {
+        free_slot* head;
+        std::size_t count;
+        bool flushed;
+    };
+
+    thread_local slot_cache cache = {nullptr, 0, false};
+
+    void flush(slot_cache& c) noexcept {
+        if (!c.head) return;
+        free_slot* last = c.head;
+        while (last->next) last = last->next;
+        table().give(c.head, last);
+        c.head = nullptr;
+        c.count = 0;
+    }
+
+    struct cache_flusher {
+        ~cache_flusher() {
+            flush(cache);
+            cache.flushed = true;
+        }
+    };
+
+    thread_local cache_flusher flusher;
+}
+
+bool reserve_count_slot() noexcept {
+    slot_cache& c = cache;
+    if (c.head) return true;
+    if (c.flushed) {
+        // The thread is exiting and nothing would return a new stash: take
+        // exactly one slot, as release_count_slot gives exactly one back
+        c.count = table().take(c.head, 1);
+    } else {
+        // Touch the flusher so this thread returns its stash on exit
+        (void)&flusher;
+        c.count = table().take(c.head, batch);
+    }
+    return c.head != nullptr;
+}
+
+count_slot* acquire_count_slot() {
+    if (!reserve_count_slot()) {
+        SMART_PTR_KIT_OUT_OF_MEMORY(chunk_bytes);
+    }
+    slot_cache& c = cache;
+    free_slot* slot = c.head;
+    c.head = slot->next;
+    --c.count;
+    return new(slot) count_slot;
+}
+
+void release_count_slot(count_slot* slot) noexcept {
+    slot->~count_slot();
+    auto* node = new(slot) free_slot{nullptr};
+    slot_cache& c = cache;
+    if (c.flushed) {
+        // The thread is exiting; its stash is gone
+        table().give(node, node);
+        return;
+    }
+    node->next = c.head;
+    c.head = node;
+    if (++c.count > 2 * batch) {
+        // Keep one batch, hand the rest back for other threads
+        free_slot* keep = c.head;
+        for (std::size_t i = 1; i < batch; ++i) keep = keep->next;
+        free_slot* rest = keep->next;
+        keep->next = nullptr;
+        free_slot* last = rest;
+        while (last->next) last = last->next;
+        table().give(rest, last);
+        c.count = batch;
+    }
+}
+
+} // namespace detail
+
+} // namespace sptr
+
+#endif // SMART_PTR_KIT_OUT_OF_LINE_COUNTS
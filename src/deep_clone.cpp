@@ -0,0 +1,27 @@
+#include "deep_clone.hpp"
+
+#include <new>
+
+namespace sptr {
+
+namespace detail {
+
+clone_arena* clone_arena::create() {
+    return new clone_arena();
+}
+
+void* clone_arena::allocate(std::size_t size, std::size_t align) {
+    void* p = m_arena.allocate(size, align);
+    m_refs.fetch_add(1, std::memory_order_relaxed);
+    return p;
+}
+
+void clone_arena::release() noexcept {
+    if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete this;
+    }
+}
+
+} // namespace detail
+
+} // namespace sptr
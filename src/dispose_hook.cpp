@@ -0,0 +1,104 @@
+#include "dispose_hook.hpp"
+
+#include <cstdint>
+#include <mutex>
+
+namespace sptr {
+
+namespace {
+    // Hook lists are rarely touched, so a small table of striped locks keyed
+    // by control block keeps the per-block cost at one pointer
+    constexpr std::size_t stripe_count = 64;
+
+    std::mutex& stripe_for(const detail::control_block* ctrl) noexcept {
+        static std::mutex stripes[stripe_count];
+        auto addr = reinterpret_cast<std::uintptr_t>(ctrl);
+        return stripes[(addr >> 4) % stripe_count];
+    }
+}
+
+void dispose_hook::link(detail::control_block* ctrl) noexcept {
+    if (!ctrl) return;
+    std::lock_guard<std::mutex> lock(stripe_for(ctrl));
+    m_ctrl = ctrl;
+    m_prev = nullptr;
+    m_next = ctrl->m_hooks.load(std::memory_order_relaxed);
+    if (m_next) m_next->m_prev = this;
+    m_state.store(linked, std::memory_order_relaxed);
+    ctrl->m_hooks.store(this, std::memory_order_release);
+}
+
+// Caller holds the stripe lock
+void dispose_hook::unlink() noexcept {
+    if (m_prev) {
+        m_prev->m_next = m_next;
+    } else {
+        m_ctrl->m_hooks.store(m_next, std::memory_order_relaxed);
+    }
+    if (m_next) m_next->m_prev = m_prev;
+    m_prev = nullptr;
+    m_next = nullptr;
+}
+
+void dispose_hook::reset() noexcept {
+    if (!m_ctrl) return;
+    std::mutex& stripe = stripe_for(m_ctrl);
+    for (;;) {
+        std::unique_lock<std::mutex> lock(stripe);
+        int state = m_state.load(std::memory_order_relaxed);
+        if (state == linked) {
+            unlink();
+            m_state.store(idle, std::memory_order_relaxed);
+            break;
+        }
+        if (state == running && m_runner != std::this_thread::get_id()) {
+            // The callback is executing elsewhere; it must finish before the
+            // hook (and the callable inside it) can go away
+            lock.unlock();
+            std::this_thread::yield();
+            continue;
+        }
+        if (state == running) {
+            // Called from inside the callback itself
+            *m_gone = true;
+            m_gone = nullptr;
+            m_state.store(idle, std::memory_order_relaxed);
+        }
+        break;
+    }
+    m_ctrl = nullptr;
+}
+
+bool dispose_hook::armed() const noexcept {
+    return m_state.load(std::memory_order_acquire) == linked;
+}
+
+namespace detail {
+
+void run_dispose_hooks(control_block& ctrl) noexcept {
+    std::mutex& stripe = stripe_for(&ctrl);
+    for (;;) {
+        dispose_hook* hook;
+        bool gone = false;
+        {
+            std::lock_guard<std::mutex> lock(stripe);
+            hook = ctrl.m_hooks.load(std::memory_order_relaxed);
+            if (!hook) return;
+            hook->unlink();
+            hook->m_state.store(dispose_hook::running, std::memory_order_relaxed);
+            hook->m_runner = std::this_thread::get_id();
+            hook->m_gone = &gone;
+        }
+        // Run unlocked so the callback may unregister or destroy hooks
+        hook->m_invoke(*hook);
+        std::lock_guard<std::mutex> lock(stripe);
+        if (!gone) {
+            hook->m_gone = nullptr;
+            hook->m_state.store(dispose_hook::idle, std::memory_order_release);
+        }
+    }
+}
+
+} // namespace detail
+
+} // namespace sptr
@@ -0,0 +1,223 @@
+#include "graph_serializer.hpp"
+#include "oom_policy.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace sptr {
+
+namespace {
+    constexpr char stream_magic[4] = {'S', 'P', 'G', '1'};
+    constexpr char trailer_magic[4] = {'S', 'P', 'G', 'E'};
+    constexpr std::uint32_t stream_version = 1;
+}
+
+graph_writer::graph_writer(std::ostream& out, std::size_t buffer_size)
+    : m_out(out), m_buffer(buffer_size < 64 ? 64 : buffer_size) {
+    write_bytes(stream_magic, sizeof(stream_magic));
+    write(stream_version);
+}
+
+graph_writer::~graph_writer() {
+    // Drop the references still held by unwritten entries; an unfinished
+    // stream is truncated and will be rejected by the reader
+    for (pending& p : m_queue) {
+        p.ctrl->release();
+    }
+}
+
+void graph_writer::write(const std::string& value) {
+    write_varint(value.size());
+    write_bytes(value.data(), value.size());
+}
+
+void graph_writer::write_bytes(const void* data, std::size_t size) {
+    auto* bytes = static_cast<const char*>(data);
+    if (size >= m_buffer.size()) {
+        // Large payloads bypass the buffer instead of being copied through it
+        flush_buffer();
+        m_out.write(bytes, static_cast<std::streamsize>(size));
+        return;
+    }
+    if (m_used + size > m_buffer.size()) {
+        flush_buffer();
+    }
+    std::memcpy(m_buffer.data() + m_used, bytes, size);
+    m_used += size;
+}
+
+void graph_writer::write_varint(std::uint64_t value) {
+    char bytes[10];
+    std::size_t n = 0;
+    while (value >= 0x80) {
+        bytes[n++] = static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    bytes[n++] = static_cast<char>(value);
+    write_bytes(bytes, n);
+}
+
+void graph_writer::write_reference(const void* object, detail::control_block* ctrl, save_fn save) {
+    if (!object) {
+        write_varint(0);
+        return;
+    }
+    if (!ctrl) {
+        // Nothing could own the restored copy the way this one is owned
+        SMART_PTR_KIT_THROW(graph_format_error("sptr: cannot write a pointer without a control block"));
+    }
+    object_key key{ctrl, object, save};
+    auto it = m_ids.find(key);
+    if (it != m_ids.end()) {
+        write_varint(it->second + 1);
+        return;
+    }
+    std::uint64_t id = m_next_id++;
+    m_ids.emplace(key, id);
+    ctrl->add_reference();
+    m_queue.push_back(pending{object, ctrl, save});
+    write_varint(id + 1);
+}
+
+void graph_writer::finish() {
+    if (m_finished) return;
+    while (!m_queue.empty()) {
+        // Stays queued while it is saved, so a throwing save still has its
+        // reference dropped by the destructor
+        pending next = m_queue.front();
+        next.save(*this, next.object);
+        m_queue.pop_front();
+        next.ctrl->release();
+    }
+    write_bytes(trailer_magic, sizeof(trailer_magic));
+    flush_buffer();
+    m_out.flush();
+    if (!m_out) {
+        SMART_PTR_KIT_THROW(graph_format_error("sptr: failed to write object graph"));
+    }
+    m_finished = true;
+}
+
+void graph_writer::flush_buffer() {
+    if (m_used == 0) return;
+    m_out.write(m_buffer.data(), static_cast<std::streamsize>(m_used));
+    m_used = 0;
+}
+
+graph_reader::graph_reader(std::istream& in, std::size_t buffer_size)
+    : m_in(in), m_buffer(buffer_size < 64 ? 64 : buffer_size) {
+    char magic[sizeof(stream_magic)];
+    read_bytes(magic, sizeof(magic));
+    if (std::memcmp(magic, stream_magic, sizeof(magic)) != 0) {
+        SMART_PTR_KIT_THROW(graph_format_error("sptr: not an object graph stream"));
+    }
+    std::uint32_t version = 0;
+    read(version);
+    if (version != stream_version) {
+        SMART_PTR_KIT_THROW(graph_format_error("sptr: unsupported object graph version"));
+    }
+}
+
+graph_reader::~graph_reader() {
+    release_slots();
+}
+
+void graph_reader::read(std::string& value) {
+    value.resize(checked_count(read_varint(), 1));
+    read_bytes(value.data(), value.size());
+}
+
+void graph_reader::read_bytes(void* data, std::size_t size) {
+    auto* out = static_cast<char*>(data);
+    while (size > 0) {
+        if (m_pos == m_end) {
+            if (size >= m_buffer.size()) {
+                // Large payloads go straight into the destination
+                m_in.read(out, static_cast<std::streamsize>(size));
+                if (static_cast<std::size_t>(m_in.gcount()) != size) {
+                    SMART_PTR_KIT_THROW(graph_format_error("sptr: object graph stream is truncated"));
+                }
+                return;
+            }
+            refill();
+        }
+        std::size_t n = std::min(size, m_end - m_pos);
+        std::memcpy(out, m_buffer.data() + m_pos, n);
+        m_pos += n;
+        out += n;
+        size -= n;
+    }
+}
+
+std::uint64_t graph_reader::read_varint() {
+    std::uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        unsigned char byte;
+        read_bytes(&byte, 1);
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+    SMART_PTR_KIT_THROW(graph_format_error("sptr: malformed varint in object graph"));
+}
+
+graph_reader::slot* graph_reader::read_reference(create_fn create, load_fn load) {
+    std::uint64_t ref = read_varint();
+    if (ref == 0) {
+        return nullptr;
+    }
+    std::uint64_t id = ref - 1;
+    if (id < m_slots.size()) {
+        return &m_slots[id];
+    }
+    if (id != m_slots.size()) {
+        SMART_PTR_KIT_THROW(graph_format_error("sptr: object graph refers to an unknown object"));
+    }
+    // First mention: create the object now, fill it in when its turn comes
+    slot s = create();
+    s.load = load;
+    m_slots.push_back(s);
+    return &m_slots.back();
+}
+
+void graph_reader::finish() {
+    if (m_finished) return;
+    while (m_next_to_load < m_slots.size()) {
+        slot s = m_slots[m_next_to_load++];
+        s.load(*this, s.object);
+    }
+    char trailer[sizeof(trailer_magic)];
+    read_bytes(trailer, sizeof(trailer));
+    if (std::memcmp(trailer, trailer_magic, sizeof(trailer)) != 0) {
+        SMART_PTR_KIT_THROW(graph_format_error("sptr: object graph stream is corrupt"));
+    }
+    release_slots();
+    m_finished = true;
+}
+
+std::size_t graph_reader::checked_count(std::uint64_t count, std::size_t element_size) {
+    if (element_size != 0 && count > std::numeric_limits<std::size_t>::max() / element_size / 2) {
+        SMART_PTR_KIT_THROW(graph_format_error("sptr: object graph length is out of range"));
+    }
+    return static_cast<std::size_t>(count);
+}
+
+void graph_reader::refill() {
+    m_in.read(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+    m_pos = 0;
+    m_end = static_cast<std::size_t>(m_in.gcount());
+    if (m_end == 0) {
+        SMART_PTR_KIT_THROW(graph_format_error("sptr: object graph stream is truncated"));
+    }
+}
+
+void graph_reader::release_slots() noexcept {
+    for (slot& s : m_slots) {
+        s.ctrl->release();
+    }
+    m_slots.clear();
+}
+
+} // namespace sptr
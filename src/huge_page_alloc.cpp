@@ -0,0 +1,197 @@
+#include "huge_page_alloc.hpp"
+#include "oom_policy.hpp"
+#include "page_map.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace sptr {
+
+namespace {
+    using detail::huge_page_size;
+    using detail::round_up;
+
+    enum class backing : std::uint32_t {
+        small,
+        hugetlb,
+        thp,
+        fallback
+    };
+
+    // Sits immediately in front of every block handed out
+    struct block_header {
+        void* base;
+        std::size_t mapping_size;   // total bytes to unmap / free
+        std::size_t align;          // operator new alignment for small blocks
+        std::size_t user;
+        backing kind;
+    };
+
+    // Read on every allocation, so kept as separate atomics rather than
+    // behind a lock; a reader racing a set may see a mix of old and new fields
+    const huge_page_config default_config;
+    std::atomic<std::size_t> config_threshold{default_config.threshold};
+    std::atomic<bool> config_use_hugetlb{default_config.use_hugetlb};
+    std::atomic<bool> config_advise_slabs{default_config.advise_slabs};
+
+    std::atomic<std::size_t> hugetlb_bytes{0};
+    std::atomic<std::size_t> thp_advised_bytes{0};
+    std::atomic<std::size_t> slab_advised_bytes{0};
+    std::atomic<std::size_t> fallback_bytes{0};
+    std::atomic<std::size_t> small_bytes{0};
+    std::atomic<std::size_t> hugetlb_failures{0};
+
+    std::atomic<std::size_t>& counter_for(backing kind) noexcept {
+        switch (kind) {
+            case backing::hugetlb: return hugetlb_bytes;
+            case backing::thp: return thp_advised_bytes;
+            case backing::fallback: return fallback_bytes;
+            case backing::small: break;
+        }
+        return small_bytes;
+    }
+
+    block_header* header_of(void* p) noexcept {
+        return reinterpret_cast<block_header*>(p) - 1;
+    }
+
+    void* map_hugetlb(std::size_t size) noexcept {
+#if defined(__linux__) && defined(MAP_HUGETLB)
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        return p == MAP_FAILED ? nullptr : p;
+#else
+        (void)size;
+        return nullptr;
+#endif
+    }
+
+    // madvise(MADV_HUGEPAGE) succeeds even with THP switched off, so check
+    // the system mode first; "never" means the advice cannot be honoured
+    bool thp_enabled() noexcept {
+#if defined(__linux__)
+        static const bool enabled = [] {
+            char mode[64] = {};
+            if (FILE* f = std::fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r")) {
+                std::size_t n = std::fread(mode, 1, sizeof(mode) - 1, f);
+                mode[n] = '\0';
+                std::fclose(f);
+            }
+            return std::strstr(mode, "[never]") == nullptr;
+        }();
+        return enabled;
+#else
+        return false;
+#endif
+    }
+
+    bool advise_hugepage(void* p, std::size_t size) noexcept {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        return thp_enabled() && madvise(p, size, MADV_HUGEPAGE) == 0;
+#else
+        (void)p; (void)size;
+        return false;
+#endif
+    }
+}
+
+void set_huge_page_config(const huge_page_config& config) noexcept {
+    config_threshold.store(config.threshold, std::memory_order_relaxed);
+    config_use_hugetlb.store(config.use_hugetlb, std::memory_order_relaxed);
+    config_advise_slabs.store(config.advise_slabs, std::memory_order_relaxed);
+}
+
+huge_page_config get_huge_page_config() noexcept {
+    huge_page_config config;
+    config.threshold = config_threshold.load(std::memory_order_relaxed);
+    config.use_hugetlb = config_use_hugetlb.load(std::memory_order_relaxed);
+    config.advise_slabs = config_advise_slabs.load(std::memory_order_relaxed);
+    return config;
+}
+
+huge_page_stats huge_page_counters() noexcept {
+    huge_page_stats stats;
+    stats.hugetlb_bytes = hugetlb_bytes.load(std::memory_order_relaxed);
+    stats.thp_advised_bytes = thp_advised_bytes.load(std::memory_order_relaxed);
+    stats.slab_advised_bytes = slab_advised_bytes.load(std::memory_order_relaxed);
+    stats.fallback_bytes = fallback_bytes.load(std::memory_order_relaxed);
+    stats.small_bytes = small_bytes.load(std::memory_order_relaxed);
+    stats.hugetlb_failures = hugetlb_failures.load(std::memory_order_relaxed);
+    return stats;
+}
+
+namespace detail {
+
+void* huge_allocate(std::size_t size, std::size_t align) {
+    if (align < alignof(block_header)) {
+        align = alignof(block_header);
+    }
+    if (align >= huge_page_size) {
+        SMART_PTR_KIT_OUT_OF_MEMORY(size);
+    }
+    std::size_t offset = round_up(sizeof(block_header), align);
+    // Header and rounding up to a whole huge page must not wrap
+    if (size > SIZE_MAX - offset - huge_page_size) {
+        SMART_PTR_KIT_OUT_OF_MEMORY(size);
+    }
+
+    void* base;
+    std::size_t total;
+    backing kind;
+    if (size < config_threshold.load(std::memory_order_relaxed)) {
+        total = offset + size;
+        base = ::operator new(total, std::align_val_t(align));
+        kind = backing::small;
+    } else {
+        total = round_up(offset + size, huge_page_size);
+        bool use_hugetlb = config_use_hugetlb.load(std::memory_order_relaxed);
+        base = use_hugetlb ? map_hugetlb(total) : nullptr;
+        if (base) {
+            kind = backing::hugetlb;
+        } else {
+            if (use_hugetlb) {
+                hugetlb_failures.fetch_add(1, std::memory_order_relaxed);
+            }
+            base = map_aligned(total);
+            kind = advise_hugepage(base, total) ? backing::thp : backing::fallback;
+        }
+    }
+
+    char* user = static_cast<char*>(base) + offset;
+    new(header_of(user)) block_header{base, total, align, 0, kind};
+    counter_for(kind).fetch_add(total, std::memory_order_relaxed);
+    return user;
+}
+
+void huge_deallocate(void* p) noexcept {
+    if (!p) return;
+    block_header header = *header_of(p);
+    counter_for(header.kind).fetch_sub(header.mapping_size, std::memory_order_relaxed);
+    if (header.kind == backing::small) {
+        ::operator delete(header.base, std::align_val_t(header.align));
+    } else {
+        unmap(header.base, header.mapping_size);
+    }
+}
+
+std::size_t& huge_user_word(void* p) noexcept {
+    return header_of(p)->user;
+}
+
+bool advise_huge_slab(void* p, std::size_t size) noexcept {
+    if (!config_advise_slabs.load(std::memory_order_relaxed) || !advise_hugepage(p, size)) {
+        return false;
+    }
+    slab_advised_bytes.fetch_add(size, std::memory_order_relaxed);
+    return true;
+}
+
+} // namespace detail
+
+} // namespace sptr
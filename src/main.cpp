@@ -1,120 +1,599 @@
-#include <iostream>
+// smart_ptr_demo: a workload driver for reproducing production-shaped
+// pointer traffic locally. Each worker thread creates objects, hands out a
+// fan-out of strong and weak references to them, reads random live objects
+// through those references and drops them after a sampled lifetime. The
+// same workload runs on sptr:: and std:: smart pointers for comparison.
+//
+// Usage: smart_ptr_demo [--option value]...
+//   --threads N           worker threads                              (4)
+//   --ops N               operations per thread                       (200000)
+//   --size-dist D         object sizes: fixed, uniform or lognormal   (lognormal)
+//   --size N              fixed size, or median for lognormal         (64)
+//   --size-max N          largest object, in bytes                    (4096)
+//   --fanout N            references taken on each new object         (4)
+//   --weak-pct P          percentage of those that are weak           (25)
+//   --reads N             reads of random live objects per operation  (4)
+//   --lifetime D          object lifetime: fixed or exp               (exp)
+//   --lifetime-ops N      (mean) lifetime, in operations of its thread (1000)
+//   --cross-pct P         percentage published to a table all threads read (10)
+//   --alloc A             default, pool, huge, numa or domain         (default)
+//   --types T             sptr, std or both                           (both)
+//   --format F            text, csv or json                           (text)
+//   --seed N              random seed                                 (1)
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
 
-#include "unique_ptr.hpp"
+#include "huge_page_alloc.hpp"
+#include "memory_domain.hpp"
+#include "numa_alloc.hpp"
+#include "pool_alloc.hpp"
 #include "shared_ptr.hpp"
 #include "weak_ptr.hpp"
 
-class Person {
+namespace {
+
+enum class size_dist { fixed, uniform, lognormal };
+enum class lifetime_dist { fixed, exponential };
+enum class alloc_policy { standard, pool, huge, numa, domain };
+
+struct options {
+    long threads = 4;
+    long ops = 200000;
+    size_dist sizes = size_dist::lognormal;
+    long size = 64;
+    long size_max = 4096;
+    long fanout = 4;
+    long weak_pct = 25;
+    long reads = 4;
+    lifetime_dist lifetime = lifetime_dist::exponential;
+    long lifetime_ops = 1000;
+    long cross_pct = 10;
+    alloc_policy alloc = alloc_policy::standard;
+    bool run_sptr = true;
+    bool run_std = true;
+    std::string format = "text";
+    long seed = 1;
+};
+
+const char* alloc_name(alloc_policy a) {
+    switch (a) {
+    case alloc_policy::pool: return "pool";
+    case alloc_policy::huge: return "huge";
+    case alloc_policy::numa: return "numa";
+    case alloc_policy::domain: return "domain";
+    default: return "default";
+    }
+}
+
+bool parse_long(const char* text, long min, long& out) {
+    char* end = nullptr;
+    long v = std::strtol(text, &end, 10);
+    if (!end || *end != '\0' || v < min) return false;
+    out = v;
+    return true;
+}
+
+// Returns an error message, or an empty string on success
+std::string parse_options(int argc, char** argv, options& o) {
+    for (int i = 1; i < argc; i += 2) {
+        std::string name = argv[i];
+        if (name == "--help" || name == "-h") return "help";
+        if (name.compare(0, 2, "--") != 0 || i + 1 >= argc) return "bad argument: " + name;
+        name = name.substr(2);
+        const char* value = argv[i + 1];
+        std::string v = value;
+        bool ok = true;
+        if (name == "threads") ok = parse_long(value, 1, o.threads);
+        else if (name == "ops") ok = parse_long(value, 1, o.ops);
+        else if (name == "size") ok = parse_long(value, 1, o.size);
+        else if (name == "size-max") ok = parse_long(value, 1, o.size_max);
+        else if (name == "fanout") ok = parse_long(value, 0, o.fanout);
+        else if (name == "weak-pct") ok = parse_long(value, 0, o.weak_pct) && o.weak_pct <= 100;
+        else if (name == "reads") ok = parse_long(value, 0, o.reads);
+        else if (name == "lifetime-ops") ok = parse_long(value, 1, o.lifetime_ops);
+        else if (name == "cross-pct") ok = parse_long(value, 0, o.cross_pct) && o.cross_pct <= 100;
+        else if (name == "seed") ok = parse_long(value, 0, o.seed);
+        else if (name == "size-dist") {
+            if (v == "fixed") o.sizes = size_dist::fixed;
+            else if (v == "uniform") o.sizes = size_dist::uniform;
+            else if (v == "lognormal") o.sizes = size_dist::lognormal;
+            else ok = false;
+        } else if (name == "lifetime") {
+            if (v == "fixed") o.lifetime = lifetime_dist::fixed;
+            else if (v == "exp") o.lifetime = lifetime_dist::exponential;
+            else ok = false;
+        } else if (name == "alloc") {
+            if (v == "default") o.alloc = alloc_policy::standard;
+            else if (v == "pool") o.alloc = alloc_policy::pool;
+            else if (v == "huge") o.alloc = alloc_policy::huge;
+            else if (v == "numa") o.alloc = alloc_policy::numa;
+            else if (v == "domain") o.alloc = alloc_policy::domain;
+            else ok = false;
+        } else if (name == "types") {
+            o.run_sptr = v == "sptr" || v == "both";
+            o.run_std = v == "std" || v == "both";
+            ok = o.run_sptr || o.run_std;
+        } else if (name == "format") {
+            o.format = v;
+            ok = v == "text" || v == "csv" || v == "json";
+        } else {
+            return "unknown option --" + name;
+        }
+        if (!ok) return "bad value for --" + name + ": " + v;
+    }
+    if (o.size > o.size_max) o.size = o.size_max;
+    return std::string();
+}
+
+// Objects come in power-of-two size buckets from 16 bytes to 64 KiB; the
+// first and last bytes are written so the memory is really touched
+constexpr std::size_t bucket_count = 13;
+
+struct object_base {
+    std::uint32_t size;
+    std::uint32_t checksum;
+};
+
+template <std::size_t N>
+struct object : object_base {
+    object() {
+        size = N;
+        checksum = 0;
+        bytes[0] = 1;
+        bytes[sizeof(bytes) - 1] = 1;
+    }
+
+    unsigned char bytes[N - sizeof(object_base)];
+};
+
+std::size_t bucket_of(long bytes) {
+    std::size_t b = 0;
+    while (b + 1 < bucket_count && (std::size_t(16) << b) < static_cast<std::size_t>(bytes)) ++b;
+    return b;
+}
+
+// The smart pointer families under test
+struct sptr_types {
+    static constexpr const char* name = "sptr";
+
+    template <typename T>
+    using shared = sptr::shared_ptr<T>;
+    template <typename T>
+    using weak = sptr::weak_ptr<T>;
+
+    template <typename T>
+    static shared<T> make() {
+        return sptr::make_shared<T>();
+    }
+
+    template <typename T, typename Alloc>
+    static shared<T> allocate(const Alloc& alloc) {
+        return sptr::allocate_shared<T>(alloc);
+    }
+};
+
+struct std_types {
+    static constexpr const char* name = "std";
+
+    template <typename T>
+    using shared = std::shared_ptr<T>;
+    template <typename T>
+    using weak = std::weak_ptr<T>;
+
+    template <typename T>
+    static shared<T> make() {
+        return std::make_shared<T>();
+    }
+
+    template <typename T, typename Alloc>
+    static shared<T> allocate(const Alloc& alloc) {
+        return std::allocate_shared<T>(alloc);
+    }
+};
+
+template <typename Types>
+using object_ptr = typename Types::template shared<object_base>;
+
+template <typename Types>
+using object_weak = typename Types::template weak<object_base>;
+
+template <typename Types, std::size_t N>
+object_ptr<Types> create_sized(alloc_policy alloc, sptr::memory_domain* domain) {
+    using T = object<N>;
+    switch (alloc) {
+    case alloc_policy::pool: return Types::template allocate<T>(sptr::pool_allocator<T>());
+    case alloc_policy::huge: return Types::template allocate<T>(sptr::huge_page_allocator<T>());
+    case alloc_policy::numa: return Types::template allocate<T>(sptr::numa_allocator<T>());
+    case alloc_policy::domain: return Types::template allocate<T>(sptr::domain_allocator<T>(*domain));
+    default: return Types::template make<T>();
+    }
+}
+
+template <typename Types, std::size_t... I>
+auto create_table(std::index_sequence<I...>) {
+    using fn = object_ptr<Types> (*)(alloc_policy, sptr::memory_domain*);
+    return std::array<fn, sizeof...(I)>{{&create_sized<Types, std::size_t(16) << I>...}};
+}
+
+template <typename Types>
+object_ptr<Types> create(std::size_t bucket, alloc_policy alloc, sptr::memory_domain* domain) {
+    static const auto table = create_table<Types>(std::make_index_sequence<bucket_count>());
+    return table[bucket](alloc, domain);
+}
+
+// Objects every thread can read; publishing replaces (and releases) an
+// entry that may have been created on another thread
+template <typename Types>
+class shared_table {
 public:
-    Person(std::string name) : m_name(std::move(name)) {
-        std::cout << "Person created: " << m_name << std::endl;
+    static constexpr std::size_t slots = 4096;
+    static constexpr std::size_t stripes = 64;
+
+    void publish(std::size_t i, object_ptr<Types> p) {
+        {
+            std::lock_guard<std::mutex> guard(m_locks[i % stripes]);
+            m_slots[i % slots].swap(p);
+        }
+        // The old entry dies here, outside the lock
     }
-    
-    ~Person() {
-        std::cout << "Person destroyed: " << m_name << std::endl;
+
+    object_ptr<Types> read(std::size_t i) {
+        std::lock_guard<std::mutex> guard(m_locks[i % stripes]);
+        return m_slots[i % slots];
     }
-    
-    void greet() const {
-        std::cout << "Hello, my name is " << m_name << std::endl;
+
+    void clear() {
+        for (auto& s : m_slots) s = object_ptr<Types>();
     }
-    
+
 private:
-    std::string m_name;
+    std::mutex m_locks[stripes];
+    std::vector<object_ptr<Types>> m_slots = std::vector<object_ptr<Types>>(slots);
+};
+
+// One object's owner plus the references handed out to it
+template <typename Types>
+struct record {
+    object_ptr<Types> owner;
+    std::vector<object_ptr<Types>> strong;
+    std::vector<object_weak<Types>> weak;
+
+    void clear() {
+        weak.clear();
+        strong.clear();
+        owner = object_ptr<Types>();
+    }
+};
+
+struct thread_result {
+    std::vector<std::uint32_t> latencies_ns;
+    std::uint64_t reads = 0;
+    std::uint64_t expired_reads = 0;
+    std::uint64_t checksum = 0;
 };
 
-void demonstrate_unique_ptr() {
-    std::cout << "\n=== unique_ptr demonstration ===\n" << std::endl;
-    
-    // Create a unique_ptr
-    sptr::unique_ptr<Person> p1(new Person("Alice"));
-    p1->greet();
-    
-    // Create using make_unique
-    auto p2 = sptr::make_unique<Person>("Bob");
-    p2->greet();
-    
-    // Move ownership
-    sptr::unique_ptr<Person> p3 = std::move(p2);
-    
-    // p2 is now nullptr
-    std::cout << "Is p2 null? " << (p2.get() == nullptr ? "Yes" : "No") << std::endl;
-    
-    // p3 has ownership
-    p3->greet();
-    
-    std::cout << "\nLeaving scope, Person objects will be destroyed\n" << std::endl;
-}
-
-void demonstrate_shared_ptr() {
-    std::cout << "\n=== shared_ptr demonstration ===\n" << std::endl;
-    
-    // Create a shared_ptr
-    sptr::shared_ptr<Person> s1(new Person("Charlie"));
-    std::cout << "Reference count: " << s1.use_count() << std::endl;
-    
-    // Create a shared_ptr sharing ownership
-    {
-        sptr::shared_ptr<Person> s2 = s1;
-        std::cout << "Reference count: " << s1.use_count() << std::endl;
-        s2->greet();
-        
-        // Create another shared_ptr
-        sptr::shared_ptr<Person> s3 = s1;
-        std::cout << "Reference count: " << s1.use_count() << std::endl;
-        
-        std::cout << "s2 and s3 going out of scope..." << std::endl;
-    }
-    
-    std::cout << "Reference count: " << s1.use_count() << std::endl;
-    s1->greet();
-    
-    std::cout << "\nLeaving scope, Charlie will be destroyed\n" << std::endl;
-}
-
-void demonstrate_weak_ptr() {
-    std::cout << "\n=== weak_ptr demonstration ===\n" << std::endl;
-    
-    // Create a weak_ptr from a shared_ptr
-    sptr::weak_ptr<Person> w1;
-    
-    {
-        std::cout << "Creating shared_ptr..." << std::endl;
-        sptr::shared_ptr<Person> s1(new Person("Dave"));
-        w1 = s1;
-        
-        std::cout << "Is w1 expired? " << (w1.expired() ? "Yes" : "No") << std::endl;
-        std::cout << "Reference count: " << w1.use_count() << std::endl;
-        
-        // Lock the weak_ptr to get a shared_ptr
-        auto s2 = w1.lock();
-        if (s2) {
-            s2->greet();
-            std::cout << "Reference count: " << w1.use_count() << std::endl;
+template <typename Types>
+void run_thread(const options& o, long thread, shared_table<Types>& table, sptr::memory_domain* domain,
+                const std::function<void()>& midpoint, thread_result& out) {
+    using clock = std::chrono::steady_clock;
+    std::mt19937_64 rng(static_cast<std::uint64_t>(o.seed) * 7919 + static_cast<std::uint64_t>(thread));
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::uniform_int_distribution<long> uniform_size(16, o.size_max);
+    std::lognormal_distribution<double> lognormal_size(std::log(static_cast<double>(o.size)), 1.0);
+    std::exponential_distribution<double> exp_lifetime(1.0 / static_cast<double>(o.lifetime_ops));
+
+    auto sample_size = [&]() -> long {
+        switch (o.sizes) {
+        case size_dist::fixed: return o.size;
+        case size_dist::uniform: return uniform_size(rng);
+        default: return std::min(o.size_max, static_cast<long>(lognormal_size(rng)) + 1);
+        }
+    };
+    auto sample_lifetime = [&]() -> long {
+        if (o.lifetime == lifetime_dist::fixed) return o.lifetime_ops;
+        return static_cast<long>(exp_lifetime(rng)) + 1;
+    };
+
+    // Live records, recycled through a free list; expiries in a min-heap
+    std::vector<record<Types>> records;
+    std::vector<std::size_t> free_slots;
+    using expiry = std::pair<long, std::size_t>;
+    std::priority_queue<expiry, std::vector<expiry>, std::greater<expiry>> expiries;
+
+    out.latencies_ns.reserve(static_cast<std::size_t>(o.ops));
+    for (long op = 0; op < o.ops; ++op) {
+        if (thread == 0 && op == o.ops / 2) {
+            midpoint();
+        }
+        auto start = clock::now();
+
+        std::size_t slot;
+        if (free_slots.empty()) {
+            slot = records.size();
+            records.emplace_back();
+        } else {
+            slot = free_slots.back();
+            free_slots.pop_back();
+        }
+        record<Types>& r = records[slot];
+        r.owner = create<Types>(bucket_of(sample_size()), o.alloc, domain);
+        for (long i = 0; i < o.fanout; ++i) {
+            if (percent(rng) < o.weak_pct) {
+                r.weak.emplace_back(r.owner);
+            } else {
+                r.strong.push_back(r.owner);
+            }
+        }
+        if (percent(rng) < o.cross_pct) {
+            table.publish(static_cast<std::size_t>(rng()), r.owner);
         }
-        
-        std::cout << "Shared_ptr going out of scope..." << std::endl;
-    }
-    
-    // The shared_ptr is gone, but we still have a weak_ptr
-    std::cout << "Is w1 expired? " << (w1.expired() ? "Yes" : "No") << std::endl;
-    std::cout << "Reference count: " << w1.use_count() << std::endl;
-    
-    // Try to lock it
-    auto s3 = w1.lock();
-    if (s3) {
-        s3->greet();
+        expiries.emplace(op + sample_lifetime(), slot);
+
+        for (long i = 0; i < o.reads; ++i) {
+            object_ptr<Types> p;
+            if (percent(rng) < o.cross_pct) {
+                p = table.read(static_cast<std::size_t>(rng()));
+            } else {
+                record<Types>& target = records[static_cast<std::size_t>(rng() % records.size())];
+                if (!target.weak.empty()) {
+                    p = target.weak[0].lock();
+                } else if (!target.strong.empty()) {
+                    p = target.strong[0];
+                }
+            }
+            ++out.reads;
+            if (p) {
+                out.checksum += p->size;
+            } else {
+                ++out.expired_reads;
+            }
+        }
+
+        while (!expiries.empty() && expiries.top().first <= op) {
+            std::size_t done = expiries.top().second;
+            expiries.pop();
+            records[done].clear();
+            free_slots.push_back(done);
+        }
+
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+        out.latencies_ns.push_back(static_cast<std::uint32_t>(std::min<long long>(ns, UINT32_MAX)));
+    }
+}
+
+#if defined(__linux__)
+// Resets the kernel's peak RSS (VmHWM) so each run reports its own peak
+void reset_peak_rss() {
+    if (FILE* f = std::fopen("/proc/self/clear_refs", "w")) {
+        std::fputs("5", f);
+        std::fclose(f);
+    }
+}
+
+long peak_rss_kb() {
+    long kb = -1;
+    if (FILE* f = std::fopen("/proc/self/status", "r")) {
+        char line[256];
+        while (std::fgets(line, sizeof(line), f)) {
+            if (std::strncmp(line, "VmHWM:", 6) == 0) kb = std::strtol(line + 6, nullptr, 10);
+        }
+        std::fclose(f);
+    }
+    if (kb < 0) {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0) kb = usage.ru_maxrss;
+    }
+    return kb;
+}
+#else
+void reset_peak_rss() {}
+long peak_rss_kb() {
+    return -1;
+}
+#endif
+
+// One run's results as ordered name/value pairs, shared by all formats
+using report = std::vector<std::pair<std::string, std::string>>;
+
+void add(report& r, const std::string& name, const std::string& value) {
+    r.emplace_back(name, value);
+}
+
+void add(report& r, const std::string& name, double value) {
+    char buf[64];
+    if (value == std::floor(value) && std::fabs(value) < 1e15) {
+        std::snprintf(buf, sizeof(buf), "%.0f", value);
     } else {
-        std::cout << "Could not lock weak_ptr, the resource is gone" << std::endl;
+        std::snprintf(buf, sizeof(buf), "%.3f", value);
     }
-    
-    std::cout << "\nLeaving scope, no more resources to destroy\n" << std::endl;
+    r.emplace_back(name, buf);
 }
 
-int main() {
-    demonstrate_unique_ptr();
-    demonstrate_shared_ptr();
-    demonstrate_weak_ptr();
-    
+// Allocator counters. The pool's are cumulative and reported as the
+// difference over the run; live byte counts are sampled halfway through it,
+// when the live set has reached its steady state.
+struct alloc_snapshot {
+    sptr::pool_stats pool;
+    sptr::huge_page_stats huge;
+    std::size_t domain_live = 0;
+};
+
+alloc_snapshot take_snapshot(const sptr::memory_domain& domain) {
+    return alloc_snapshot{sptr::pool_counters(), sptr::huge_page_counters(), domain.live_bytes_exact()};
+}
+
+void add_alloc_stats(report& r, const options& o, const alloc_snapshot& before, const alloc_snapshot& mid,
+                     sptr::memory_domain* domain) {
+    switch (o.alloc) {
+    case alloc_policy::pool: {
+        sptr::pool_stats after = sptr::pool_counters();
+        add(r, "pool_heaps", static_cast<double>(after.heaps));
+        add(r, "pool_allocations", static_cast<double>(after.allocations - before.pool.allocations));
+        add(r, "pool_local_frees", static_cast<double>(after.local_frees - before.pool.local_frees));
+        add(r, "pool_remote_frees", static_cast<double>(after.remote_frees - before.pool.remote_frees));
+        add(r, "pool_remote_batches", static_cast<double>(after.remote_batches - before.pool.remote_batches));
+        add(r, "pool_drained", static_cast<double>(after.drained - before.pool.drained));
+        break;
+    }
+    case alloc_policy::huge:
+        add(r, "huge_small_bytes", static_cast<double>(mid.huge.small_bytes));
+        add(r, "huge_thp_advised_bytes", static_cast<double>(mid.huge.thp_advised_bytes));
+        add(r, "huge_hugetlb_bytes", static_cast<double>(mid.huge.hugetlb_bytes));
+        add(r, "huge_fallback_bytes", static_cast<double>(mid.huge.fallback_bytes));
+        break;
+    case alloc_policy::numa:
+        for (int node = 0; node < sptr::numa_node_count(); ++node) {
+            sptr::numa_node_stats s = sptr::numa_stats(node);
+            std::string prefix = "numa" + std::to_string(node) + "_";
+            add(r, prefix + "bytes_reserved", static_cast<double>(s.bytes_reserved));
+            add(r, prefix + "allocations", static_cast<double>(s.allocations));
+        }
+        break;
+    case alloc_policy::domain:
+        add(r, "domain_live_bytes", static_cast<double>(mid.domain_live));
+        add(r, "domain_rejected", static_cast<double>(domain->rejected()));
+        break;
+    default:
+        break;
+    }
+}
+
+template <typename Types>
+report run(const options& o) {
+    sptr::memory_domain domain("smart_ptr_demo");
+    shared_table<Types> table;
+    std::vector<thread_result> results(static_cast<std::size_t>(o.threads));
+    alloc_snapshot before = take_snapshot(domain);
+    alloc_snapshot mid = before;
+    reset_peak_rss();
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (long t = 0; t < o.threads; ++t) {
+        workers.emplace_back([&, t] {
+            run_thread<Types>(o, t, table, &domain, [&] { mid = take_snapshot(domain); },
+                              results[static_cast<std::size_t>(t)]);
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    long rss = peak_rss_kb();
+    table.clear();
+
+    std::vector<std::uint32_t> latencies;
+    std::uint64_t reads = 0, expired = 0, checksum = 0;
+    for (auto& r : results) {
+        latencies.insert(latencies.end(), r.latencies_ns.begin(), r.latencies_ns.end());
+        reads += r.reads;
+        expired += r.expired_reads;
+        checksum += r.checksum;
+    }
+    auto percentile = [&](double p) -> double {
+        if (latencies.empty()) return 0;
+        auto k = static_cast<std::size_t>(p / 100.0 * static_cast<double>(latencies.size() - 1));
+        std::nth_element(latencies.begin(), latencies.begin() + static_cast<std::ptrdiff_t>(k), latencies.end());
+        return latencies[k];
+    };
+
+    double total_ops = static_cast<double>(o.threads) * static_cast<double>(o.ops);
+    report r;
+    add(r, "types", Types::name);
+    add(r, "alloc", alloc_name(o.alloc));
+    add(r, "threads", static_cast<double>(o.threads));
+    add(r, "ops", total_ops);
+    add(r, "seconds", seconds);
+    add(r, "ops_per_sec", total_ops / seconds);
+    add(r, "p50_ns", percentile(50));
+    add(r, "p90_ns", percentile(90));
+    add(r, "p99_ns", percentile(99));
+    add(r, "p999_ns", percentile(99.9));
+    add(r, "max_ns", percentile(100));
+    add(r, "reads", static_cast<double>(reads));
+    add(r, "expired_reads", static_cast<double>(expired));
+    add(r, "peak_rss_kb", static_cast<double>(rss));
+    add_alloc_stats(r, o, before, mid, &domain);
+    // Keeps the reads from being optimized away
+    add(r, "checksum", static_cast<double>(checksum % 1000000007));
+    return r;
+}
+
+void print(const std::vector<report>& reports, const std::string& format) {
+    if (format == "csv") {
+        for (std::size_t i = 0; i < reports[0].size(); ++i) {
+            std::printf("%s%s", i ? "," : "", reports[0][i].first.c_str());
+        }
+        std::printf("\n");
+        for (const auto& r : reports) {
+            for (std::size_t i = 0; i < r.size(); ++i) {
+                std::printf("%s%s", i ? "," : "", r[i].second.c_str());
+            }
+            std::printf("\n");
+        }
+    } else if (format == "json") {
+        std::printf("[\n");
+        for (std::size_t n = 0; n < reports.size(); ++n) {
+            std::printf("  {");
+            for (std::size_t i = 0; i < reports[n].size(); ++i) {
+                const auto& kv = reports[n][i];
+                bool text = kv.first == "types" || kv.first == "alloc";
+                std::printf("%s\"%s\": %s%s%s", i ? ", " : "", kv.first.c_str(), text ? "\"" : "",
+                            kv.second.c_str(), text ? "\"" : "");
+            }
+            std::printf("}%s\n", n + 1 < reports.size() ? "," : "");
+        }
+        std::printf("]\n");
+    } else {
+        for (const auto& r : reports) {
+            for (const auto& kv : r) {
+                std::printf("%-22s %s\n", kv.first.c_str(), kv.second.c_str());
+            }
+            std::printf("\n");
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    options o;
+    std::string error = parse_options(argc, argv, o);
+    if (!error.empty()) {
+        if (error != "help") std::fprintf(stderr, "smart_ptr_demo: %s\n", error.c_str());
+        std::fprintf(stderr,
+                     "usage: smart_ptr_demo [--threads N] [--ops N] [--size-dist fixed|uniform|lognormal]\n"
+                     "                      [--size N] [--size-max N] [--fanout N] [--weak-pct P] [--reads N]\n"
+                     "                      [--lifetime fixed|exp] [--lifetime-ops N] [--cross-pct P]\n"
+                     "                      [--alloc default|pool|huge|numa|domain] [--types sptr|std|both]\n"
+                     "                      [--format text|csv|json] [--seed N]\n");
+        return error == "help" ? 0 : 2;
+    }
+
+    std::vector<report> reports;
+    if (o.run_sptr) reports.push_back(run<sptr_types>(o));
+    if (o.run_std) reports.push_back(run<std_types>(o));
+    print(reports, o.format);
     return 0;
-}
\ No newline at end of file
+}
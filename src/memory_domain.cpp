@@ -0,0 +1,141 @@
+#include "memory_domain.hpp"
+#include "oom_policy.hpp"
+
+namespace sptr {
+
+namespace {
+    // Threads are spread over the shards round-robin on first use
+    std::size_t shard_index() noexcept {
+        static std::atomic<std::size_t> next{0};
+        thread_local std::size_t index = next.fetch_add(1, std::memory_order_relaxed);
+        return index % memory_domain::shard_count;
+    }
+}
+
+memory_domain::memory_domain(std::string name) : m_name(std::move(name)) {}
+
+void memory_domain::set_soft_limit(std::size_t bytes, limit_callback on_exceeded) {
+    {
+        std::lock_guard<std::mutex> lock(m_callback_mutex);
+        m_on_soft_limit = std::move(on_exceeded);
+    }
+    m_soft_exceeded.store(false, std::memory_order_relaxed);
+    m_soft_limit.store(bytes, std::memory_order_relaxed);
+}
+
+void memory_domain::set_hard_limit(std::size_t bytes) noexcept {
+    m_hard_limit.store(bytes, std::memory_order_relaxed);
+}
+
+std::size_t memory_domain::soft_limit() const noexcept {
+    return m_soft_limit.load(std::memory_order_relaxed);
+}
+
+std::size_t memory_domain::hard_limit() const noexcept {
+    return m_hard_limit.load(std::memory_order_relaxed);
+}
+
+std::size_t memory_domain::live_bytes() const noexcept {
+    long live = m_central.load(std::memory_order_relaxed);
+    return live > 0 ? static_cast<std::size_t>(live) : 0;
+}
+
+std::size_t memory_domain::live_bytes_exact() const noexcept {
+    long live = m_central.load(std::memory_order_relaxed);
+    for (const shard& s : m_shards) {
+        live -= s.budget.load(std::memory_order_relaxed);
+    }
+    return live > 0 ? static_cast<std::size_t>(live) : 0;
+}
+
+std::size_t memory_domain::rejected() const noexcept {
+    return m_rejected.load(std::memory_order_relaxed);
+}
+
+bool memory_domain::try_charge(std::size_t bytes) noexcept {
+    auto need = static_cast<long>(bytes);
+    shard& s = m_shards[shard_index()];
+    long budget = s.budget.load(std::memory_order_relaxed);
+    while (budget >= need) {
+        if (s.budget.compare_exchange_weak(budget, budget - need, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    // Reserve this charge plus a quantum for the shard's next ones; near the
+    // hard limit, pull every idle reservation back and try for just the charge
+    if (reserve(need + quantum)) {
+        s.budget.fetch_add(quantum, std::memory_order_relaxed);
+        return true;
+    }
+    drain_shards();
+    if (reserve(need)) {
+        return true;
+    }
+    m_rejected.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void memory_domain::credit(std::size_t bytes) noexcept {
+    shard& s = m_shards[shard_index()];
+    long budget = s.budget.fetch_add(static_cast<long>(bytes), std::memory_order_relaxed) +
+                  static_cast<long>(bytes);
+    if (budget > quantum) {
+        // Hand the surplus back; whatever other threads took meanwhile stays
+        long surplus = s.budget.exchange(0, std::memory_order_relaxed);
+        if (surplus != 0) {
+            long live = m_central.fetch_sub(surplus, std::memory_order_relaxed) - surplus;
+            check_soft_limit(live);
+        }
+    }
+}
+
+// Moves bytes from the domain's headroom into a reservation; fails if that
+// would take the centre past the hard limit
+bool memory_domain::reserve(long bytes) noexcept {
+    std::size_t hard = hard_limit();
+    long live;
+    if (hard == no_limit) {
+        live = m_central.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    } else {
+        long reserved = m_central.load(std::memory_order_relaxed);
+        do {
+            if (reserved + bytes > static_cast<long>(hard)) return false;
+        } while (!m_central.compare_exchange_weak(reserved, reserved + bytes, std::memory_order_relaxed));
+        live = reserved + bytes;
+    }
+    check_soft_limit(live);
+    return true;
+}
+
+// Returns every shard's unused reservation to the centre
+void memory_domain::drain_shards() noexcept {
+    long drained = 0;
+    for (shard& s : m_shards) {
+        drained += s.budget.exchange(0, std::memory_order_relaxed);
+    }
+    if (drained != 0) {
+        m_central.fetch_sub(drained, std::memory_order_relaxed);
+    }
+}
+
+void memory_domain::check_soft_limit(long live) noexcept {
+    std::size_t soft = soft_limit();
+    if (soft == no_limit) return;
+
+    if (live < 0 || static_cast<std::size_t>(live) < soft) {
+        m_soft_exceeded.store(false, std::memory_order_relaxed);
+        return;
+    }
+    if (m_soft_exceeded.exchange(true, std::memory_order_relaxed)) return;
+
+    // Callbacks are user code; a throwing one must not escape credit()/dispose()
+    std::lock_guard<std::mutex> lock(m_callback_mutex);
+    if (m_on_soft_limit) {
+        SMART_PTR_KIT_TRY {
+            m_on_soft_limit(*this, static_cast<std::size_t>(live));
+        } SMART_PTR_KIT_CATCH_ALL {
+        }
+    }
+}
+
+} // namespace sptr
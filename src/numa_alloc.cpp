@@ -0,0 +1,283 @@
+#include "numa_alloc.hpp"
+#include "huge_page_alloc.hpp"
+#include "oom_policy.hpp"
+#include "page_map.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace sptr {
+
+namespace {
+    using detail::round_up;
+
+    // Every arena mapping is chunk_size-aligned and starts with a header, so
+    // the owning node can be recovered from any address inside it
+    constexpr std::size_t chunk_size = detail::huge_page_size;
+    constexpr std::size_t header_size = 64;
+
+    // Size classes: 16-byte steps up to 1 KiB, then powers of two up to 256 KiB.
+    // Blocks of a class are aligned to the largest power of two dividing the
+    // class size, so rounding a request up to its alignment is enough.
+    constexpr std::size_t small_step = 16;
+    constexpr std::size_t small_max = 1024;
+    constexpr std::size_t small_classes = small_max / small_step;
+    constexpr std::size_t pow2_classes = 8;  // 2 KiB .. 256 KiB
+    constexpr std::size_t class_count = small_classes + pow2_classes;
+    constexpr std::size_t large_threshold = small_max << pow2_classes;
+
+    // Linux mbind policy; defined here to avoid a libnuma dependency
+    constexpr int mpol_preferred = 1;
+    constexpr unsigned long mpol_f_node = 1UL << 0;
+    constexpr unsigned long mpol_f_addr = 1UL << 1;
+
+    struct chunk_header {
+        int node;
+        bool large;
+        std::size_t mapping_size;
+    };
+
+    struct free_block {
+        free_block* next;
+    };
+
+    struct node_arena {
+        std::mutex mutex;
+        char* cursor = nullptr;
+        char* limit = nullptr;
+        std::array<free_block*, class_count> free_lists{};
+        std::atomic<std::size_t> bytes_reserved{0};
+        std::atomic<std::size_t> bytes_live{0};
+        std::atomic<std::size_t> allocations{0};
+        std::atomic<std::size_t> deallocations{0};
+        std::atomic<bool> bound{false};
+    };
+
+    std::size_t size_class(std::size_t size) noexcept {
+        if (size <= small_max) {
+            return (size == 0 ? 0 : (size - 1) / small_step);
+        }
+        std::size_t cls = small_classes;
+        for (std::size_t s = small_max * 2; s < size; s <<= 1) {
+            ++cls;
+        }
+        return cls;
+    }
+
+    std::size_t class_size(std::size_t cls) noexcept {
+        if (cls < small_classes) {
+            return (cls + 1) * small_step;
+        }
+        return small_max << (cls - small_classes + 1);
+    }
+
+    std::size_t class_align(std::size_t cls) noexcept {
+        std::size_t size = class_size(cls);
+        std::size_t align = size & (~size + 1);
+        return align > 4096 ? 4096 : align;
+    }
+
+    int parse_max_node(const std::string& list) {
+        // Formats like "0", "0-1" or "0,2-3"; we only need the highest id
+        int max_node = 0;
+        int value = 0;
+        bool in_number = false;
+        for (char c : list) {
+            if (c >= '0' && c <= '9') {
+                value = value * 10 + (c - '0');
+                in_number = true;
+            } else {
+                if (in_number && value > max_node) max_node = value;
+                value = 0;
+                in_number = false;
+            }
+        }
+        if (in_number && value > max_node) max_node = value;
+        return max_node;
+    }
+
+    int detect_node_count() noexcept {
+#if defined(__linux__)
+        std::ifstream in("/sys/devices/system/node/online");
+        std::string list;
+        if (in && std::getline(in, list) && !list.empty()) {
+            return parse_max_node(list) + 1;
+        }
+#endif
+        return 1;
+    }
+
+    std::vector<node_arena>& arenas() {
+        static std::vector<node_arena> instance(static_cast<std::size_t>(numa_node_count()));
+        return instance;
+    }
+
+    int resolve_node(int node) {
+        if (node == numa_local_node) {
+            return current_numa_node();
+        }
+        if (node < 0 || node >= numa_node_count()) {
+            SMART_PTR_KIT_THROW(std::invalid_argument("sptr: unknown NUMA node"));
+        }
+        return node;
+    }
+
+    bool bind_to_node(void* addr, std::size_t size, int node) noexcept {
+#if defined(__linux__) && defined(SYS_mbind)
+        if (numa_node_count() < 2) {
+            return false;
+        }
+        unsigned long mask[16] = {};
+        constexpr std::size_t bits = sizeof(unsigned long) * 8;
+        if (static_cast<std::size_t>(node) >= bits * 16) {
+            return false;
+        }
+        mask[node / bits] = 1UL << (node % bits);
+        return syscall(SYS_mbind, addr, size, mpol_preferred, mask, bits * 16, 0) == 0;
+#else
+        (void)addr; (void)size; (void)node;
+        return false;
+#endif
+    }
+
+    void* map_chunk(node_arena& arena, int node, std::size_t size, bool large) {
+        void* base = detail::map_aligned(size);
+        if (bind_to_node(base, size, node)) {
+            arena.bound.store(true, std::memory_order_relaxed);
+        }
+        if (!large) {
+            // Dense control-block slabs are the TLB-hungry part
+            detail::advise_huge_slab(base, size);
+        }
+        new(base) chunk_header{node, large, size};
+        arena.bytes_reserved.fetch_add(size, std::memory_order_relaxed);
+        return base;
+    }
+
+    chunk_header* header_of(const void* p) noexcept {
+        auto addr = reinterpret_cast<std::uintptr_t>(p);
+        return reinterpret_cast<chunk_header*>(addr & ~(chunk_size - 1));
+    }
+}
+
+int numa_node_count() noexcept {
+    static const int count = detect_node_count();
+    return count;
+}
+
+int current_numa_node() noexcept {
+#if defined(__linux__) && defined(SYS_getcpu)
+    if (numa_node_count() > 1) {
+        unsigned cpu = 0;
+        unsigned node = 0;
+        if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+            return static_cast<int>(node);
+        }
+    }
+#endif
+    return 0;
+}
+
+int numa_node_of(const void* p) noexcept {
+#if defined(__linux__) && defined(SYS_get_mempolicy)
+    int node = -1;
+    if (syscall(SYS_get_mempolicy, &node, nullptr, 0, p, mpol_f_node | mpol_f_addr) == 0) {
+        return node;
+    }
+#else
+    (void)p;
+#endif
+    return -1;
+}
+
+numa_node_stats numa_stats(int node) {
+    node_arena& arena = arenas()[static_cast<std::size_t>(resolve_node(node))];
+    numa_node_stats stats;
+    stats.bytes_reserved = arena.bytes_reserved.load(std::memory_order_relaxed);
+    stats.bytes_live = arena.bytes_live.load(std::memory_order_relaxed);
+    stats.allocations = arena.allocations.load(std::memory_order_relaxed);
+    stats.deallocations = arena.deallocations.load(std::memory_order_relaxed);
+    stats.bound = arena.bound.load(std::memory_order_relaxed);
+    return stats;
+}
+
+namespace detail {
+
+void* numa_allocate(std::size_t size, std::size_t align, int node) {
+    node = resolve_node(node);
+    if (align >= chunk_size) {
+        SMART_PTR_KIT_OUT_OF_MEMORY(size);
+    }
+    node_arena& arena = arenas()[static_cast<std::size_t>(node)];
+    std::size_t rounded = round_up(size == 0 ? 1 : size, align);
+
+    if (rounded > large_threshold || align > 4096) {
+        std::size_t offset = round_up(header_size, align);
+        std::size_t mapping = round_up(offset + rounded, chunk_size);
+        char* base = static_cast<char*>(map_chunk(arena, node, mapping, true));
+        arena.bytes_live.fetch_add(rounded, std::memory_order_relaxed);
+        arena.allocations.fetch_add(1, std::memory_order_relaxed);
+        return base + offset;
+    }
+
+    std::size_t cls = size_class(rounded);
+    std::size_t block = class_size(cls);
+    void* result;
+    {
+        std::lock_guard<std::mutex> lock(arena.mutex);
+        if (free_block* head = arena.free_lists[cls]) {
+            arena.free_lists[cls] = head->next;
+            result = head;
+        } else {
+            auto cursor = round_up(reinterpret_cast<std::uintptr_t>(arena.cursor), class_align(cls));
+            if (arena.cursor == nullptr ||
+                cursor + block > reinterpret_cast<std::uintptr_t>(arena.limit)) {
+                char* base = static_cast<char*>(map_chunk(arena, node, chunk_size, false));
+                arena.limit = base + chunk_size;
+                cursor = round_up(reinterpret_cast<std::uintptr_t>(base + header_size), class_align(cls));
+            }
+            result = reinterpret_cast<void*>(cursor);
+            arena.cursor = reinterpret_cast<char*>(cursor + block);
+        }
+    }
+    arena.bytes_live.fetch_add(block, std::memory_order_relaxed);
+    arena.allocations.fetch_add(1, std::memory_order_relaxed);
+    return result;
+}
+
+void numa_deallocate(void* p, std::size_t size, std::size_t align) noexcept {
+    if (!p) return;
+    chunk_header* header = header_of(p);
+    node_arena& arena = arenas()[static_cast<std::size_t>(header->node)];
+    std::size_t rounded = round_up(size == 0 ? 1 : size, align);
+
+    arena.deallocations.fetch_add(1, std::memory_order_relaxed);
+    if (header->large) {
+        arena.bytes_live.fetch_sub(rounded, std::memory_order_relaxed);
+        arena.bytes_reserved.fetch_sub(header->mapping_size, std::memory_order_relaxed);
+        detail::unmap(header, header->mapping_size);
+        return;
+    }
+
+    std::size_t cls = size_class(rounded);
+    arena.bytes_live.fetch_sub(class_size(cls), std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(arena.mutex);
+    auto* block = static_cast<free_block*>(p);
+    block->next = arena.free_lists[cls];
+    arena.free_lists[cls] = block;
+}
+
+} // namespace detail
+
+} // namespace sptr
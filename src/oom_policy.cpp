@@ -0,0 +1,56 @@
+#include "oom_policy.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+
+namespace sptr {
+
+namespace {
+    std::atomic<oom_handler> handler{nullptr};
+
+    void run_handler(std::size_t bytes) {
+        if (oom_handler h = handler.load(std::memory_order_acquire)) {
+            h(bytes);
+        }
+    }
+
+    [[noreturn]] void report_and_abort(std::size_t bytes) noexcept {
+        std::fprintf(stderr, "sptr: out of memory allocating %zu bytes\n", bytes);
+        std::abort();
+    }
+}
+
+oom_handler set_oom_handler(oom_handler h) noexcept {
+    return handler.exchange(h, std::memory_order_acq_rel);
+}
+
+oom_handler get_oom_handler() noexcept {
+    return handler.load(std::memory_order_acquire);
+}
+
+namespace detail {
+
+void throw_out_of_memory(std::size_t bytes) {
+    run_handler(bytes);
+#if SMART_PTR_KIT_HAS_EXCEPTIONS
+    throw std::bad_alloc();
+#else
+    // A library built without exceptions cannot throw on the caller's behalf
+    report_and_abort(bytes);
+#endif
+}
+
+void abort_out_of_memory(std::size_t bytes) noexcept {
+    run_handler(bytes);
+    report_and_abort(bytes);
+}
+
+void abort_with(const char* what) noexcept {
+    std::fprintf(stderr, "%s\n", what);
+    std::abort();
+}
+
+} // namespace detail
+
+} // namespace sptr
@@ -0,0 +1,31 @@
+#include "ownership_group.hpp"
+
+namespace sptr {
+
+namespace detail {
+
+void* group_block::allocate(std::size_t size, std::size_t align) {
+    void* p = m_arena.allocate(size, align);
+    ++m_objects;
+    return p;
+}
+
+void group_block::add_destructor(void (*destroy)(void*), void* object) {
+    m_destructors.push_back(destructor{destroy, object});
+}
+
+void group_block::dispose() noexcept {
+    for (std::size_t i = m_destructors.size(); i > 0; --i) {
+        m_destructors[i - 1].destroy(m_destructors[i - 1].object);
+    }
+    m_destructors.clear();
+}
+
+void group_block::destroy() noexcept {
+    // The arena frees its chunks with the block
+    delete this;
+}
+
+} // namespace detail
+
+} // namespace sptr
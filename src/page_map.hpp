@@ -0,0 +1,63 @@
+#ifndef SMART_PTR_KIT_SRC_PAGE_MAP_HPP
+#define SMART_PTR_KIT_SRC_PAGE_MAP_HPP
+
+// Internal helpers for the page-level allocators (not installed)
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include "oom_policy.hpp"
+
+namespace sptr {
+namespace detail {
+
+// 2 MiB: the x86-64/arm64 huge page size and the arena chunk granularity
+inline constexpr std::size_t huge_page_size = std::size_t(2) << 20;
+
+inline std::size_t round_up(std::size_t n, std::size_t align) noexcept {
+    return (n + align - 1) & ~(align - 1);
+}
+
+// Maps size bytes (a multiple of huge_page_size) at a huge_page_size-aligned
+// address. Failure goes through the out-of-memory policy (std::bad_alloc).
+inline void* map_aligned(std::size_t size) {
+#if defined(__linux__)
+    std::size_t padded = size + huge_page_size;
+    void* raw = mmap(nullptr, padded, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        SMART_PTR_KIT_OUT_OF_MEMORY(size);
+    }
+    auto begin = reinterpret_cast<std::uintptr_t>(raw);
+    auto aligned = round_up(begin, huge_page_size);
+    if (aligned != begin) {
+        munmap(raw, aligned - begin);
+    }
+    std::size_t tail = (begin + padded) - (aligned + size);
+    if (tail != 0) {
+        munmap(reinterpret_cast<void*>(aligned + size), tail);
+    }
+    return reinterpret_cast<void*>(aligned);
+#else
+    return ::operator new(size, std::align_val_t(huge_page_size));
+#endif
+}
+
+inline void unmap(void* p, std::size_t size) noexcept {
+#if defined(__linux__)
+    munmap(p, size);
+#else
+    (void)size;
+    ::operator delete(p, std::align_val_t(huge_page_size));
+#endif
+}
+
+} // namespace detail
+} // namespace sptr
+
+#endif // SMART_PTR_KIT_SRC_PAGE_MAP_HPP
@@ -0,0 +1,228 @@
+#include "persistent_heap.hpp"
+#include "oom_policy.hpp"
+#include "page_map.hpp"
+
+#include <cstring>
+#include <fstream>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sptr {
+
+namespace {
+    constexpr std::uint64_t heap_magic = 0x50414548525450ULL;  // "PTRHEAP"
+
+    // Lives at offset 0 of both the in-memory heap and the file
+    struct alignas(persistent_heap::max_alignment) heap_header {
+        std::uint64_t magic;
+        std::uint32_t format_version;
+        std::uint32_t header_size;
+        std::uint64_t schema_version;
+        std::uint64_t used;          // bytes in use, header included
+        std::uint64_t root_offset;   // 0 when no root was set
+        std::uint64_t checksum;      // FNV-1a over [header_size, used)
+    };
+
+    // FNV-1a over 8-byte words, so validating a large heap stays cheap
+    std::uint64_t checksum(const char* data, std::size_t size) noexcept {
+        constexpr std::uint64_t prime = 0x100000001b3ULL;
+        std::uint64_t hash = 0xcbf29ce484222325ULL;
+        std::size_t i = 0;
+        for (; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t)) {
+            std::uint64_t word;
+            std::memcpy(&word, data + i, sizeof(word));
+            hash = (hash ^ word) * prime;
+        }
+        for (; i < size; ++i) {
+            hash = (hash ^ static_cast<unsigned char>(data[i])) * prime;
+        }
+        return hash;
+    }
+
+    heap_header* header_of(char* base) noexcept {
+        return reinterpret_cast<heap_header*>(base);
+    }
+}
+
+persistent_heap::persistent_heap(std::size_t capacity, std::uint64_t schema_version) {
+    m_mapped = detail::round_up(capacity + sizeof(heap_header), 4096);
+#if defined(__linux__)
+    void* mem = mmap(nullptr, m_mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        SMART_PTR_KIT_OUT_OF_MEMORY(m_mapped);
+    }
+    m_base = static_cast<char*>(mem);
+#else
+    m_base = static_cast<char*>(::operator new(m_mapped, std::align_val_t(max_alignment)));
+    std::memset(m_base, 0, m_mapped);
+#endif
+    new(m_base) heap_header{heap_magic, format_version, sizeof(heap_header),
+                            schema_version, sizeof(heap_header), 0, 0};
+}
+
+persistent_heap persistent_heap::open(const std::string& path, std::uint64_t schema_version,
+                                      bool verify_checksum) {
+    persistent_heap heap;
+#if defined(__linux__)
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        SMART_PTR_KIT_THROW(persistent_heap_error("sptr: cannot open persistent heap " + path));
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(heap_header)) {
+        ::close(fd);
+        SMART_PTR_KIT_THROW(persistent_heap_error("sptr: persistent heap file is truncated"));
+    }
+    heap.m_mapped = static_cast<std::size_t>(st.st_size);
+    void* mem = mmap(nullptr, heap.m_mapped, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED) {
+        SMART_PTR_KIT_THROW(persistent_heap_error("sptr: cannot map persistent heap " + path));
+    }
+    heap.m_base = static_cast<char*>(mem);
+#else
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        SMART_PTR_KIT_THROW(persistent_heap_error("sptr: cannot open persistent heap " + path));
+    }
+    heap.m_mapped = static_cast<std::size_t>(in.tellg());
+    if (heap.m_mapped < sizeof(heap_header)) {
+        SMART_PTR_KIT_THROW(persistent_heap_error("sptr: persistent heap file is truncated"));
+    }
+    heap.m_base = static_cast<char*>(::operator new(heap.m_mapped, std::align_val_t(max_alignment)));
+    in.seekg(0);
+    in.read(heap.m_base, static_cast<std::streamsize>(heap.m_mapped));
+#endif
+    heap.m_read_only = true;
+
+    // Validation pass: nothing in the file is trusted until it is checked
+    const heap_header* header = header_of(heap.m_base);
+    if (header->magic != heap_magic) {
+        SMART_PTR_KIT_THROW(persistent_heap_error("sptr: not a persistent heap file"));
+    }
+    if (header->format_version != format_version || header->header_size != sizeof(heap_header)) {
+        SMART_PTR_KIT_THROW(persistent_heap_error("sptr: unsupported persistent heap format version"));
+    }
+    if (header->schema_version != schema_version) {
+        SMART_PTR_KIT_THROW(persistent_heap_error("sptr: persistent heap schema version mismatch"));
+    }
+    if (header->used != heap.m_mapped) {
+        SMART_PTR_KIT_THROW(persistent_heap_error("sptr: persistent heap file is truncated"));
+    }
+    if (header->root_offset != 0 &&
+        (header->root_offset < sizeof(heap_header) || header->root_offset >= header->used)) {
+        SMART_PTR_KIT_THROW(persistent_heap_error("sptr: persistent heap root is out of bounds"));
+    }
+    if (verify_checksum &&
+        checksum(heap.m_base + sizeof(heap_header), header->used - sizeof(heap_header)) !=
+        header->checksum) {
+        SMART_PTR_KIT_THROW(persistent_heap_error("sptr: persistent heap checksum mismatch"));
+    }
+    return heap;
+}
+
+persistent_heap::persistent_heap(persistent_heap&& other) noexcept
+    : m_base(other.m_base), m_mapped(other.m_mapped), m_read_only(other.m_read_only) {
+    other.m_base = nullptr;
+    other.m_mapped = 0;
+}
+
+persistent_heap& persistent_heap::operator=(persistent_heap&& other) noexcept {
+    if (this != &other) {
+        release();
+        m_base = other.m_base;
+        m_mapped = other.m_mapped;
+        m_read_only = other.m_read_only;
+        other.m_base = nullptr;
+        other.m_mapped = 0;
+    }
+    return *this;
+}
+
+persistent_heap::~persistent_heap() {
+    release();
+}
+
+void persistent_heap::release() noexcept {
+    if (!m_base) return;
+#if defined(__linux__)
+    munmap(m_base, m_mapped);
+#else
+    ::operator delete(m_base, std::align_val_t(max_alignment));
+#endif
+    m_base = nullptr;
+}
+
+void* persistent_heap::allocate(std::size_t size, std::size_t align) {
+    if (m_read_only) {
+        SMART_PTR_KIT_THROW(persistent_heap_error("sptr: persistent heap is read-only"));
+    }
+    heap_header* header = header_of(m_base);
+    std::size_t offset = detail::round_up(header->used, align);
+    // Written so that neither side can wrap for a huge size
+    if (offset > m_mapped || size > m_mapped - offset) {
+        SMART_PTR_KIT_OUT_OF_MEMORY(size);
+    }
+    header->used = offset + size;
+    return m_base + offset;
+}
+
+std::size_t persistent_heap::offset_of(const void* p, std::size_t size) const {
+    if (!contains(p, size)) {
+        SMART_PTR_KIT_THROW(persistent_heap_error("sptr: object is not inside this persistent heap"));
+    }
+    return static_cast<std::size_t>(static_cast<const char*>(p) - m_base);
+}
+
+const void* persistent_heap::checked_object(const void* p, std::size_t size, std::size_t align) const {
+    if (!contains(p, size) || reinterpret_cast<std::uintptr_t>(p) % align != 0) {
+        SMART_PTR_KIT_THROW(persistent_heap_error("sptr: persistent heap pointer is out of bounds"));
+    }
+    return p;
+}
+
+std::size_t persistent_heap::root_offset() const noexcept {
+    return m_base ? header_of(m_base)->root_offset : 0;
+}
+
+void persistent_heap::set_root_offset(std::size_t offset) {
+    if (m_read_only) {
+        SMART_PTR_KIT_THROW(persistent_heap_error("sptr: persistent heap is read-only"));
+    }
+    header_of(m_base)->root_offset = offset;
+}
+
+bool persistent_heap::contains(const void* p, std::size_t size) const noexcept {
+    if (!m_base) return false;
+    auto* ptr = static_cast<const char*>(p);
+    std::size_t used = header_of(m_base)->used;
+    return ptr >= m_base + sizeof(heap_header) && ptr <= m_base + used &&
+           size <= static_cast<std::size_t>(m_base + used - ptr);
+}
+
+std::size_t persistent_heap::size() const noexcept {
+    return m_base ? header_of(m_base)->used : 0;
+}
+
+std::uint64_t persistent_heap::schema_version() const noexcept {
+    return m_base ? header_of(m_base)->schema_version : 0;
+}
+
+void persistent_heap::save(const std::string& path) const {
+    heap_header header = *header_of(m_base);
+    header.checksum = checksum(m_base + sizeof(heap_header), header.used - sizeof(heap_header));
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(m_base + sizeof(heap_header), static_cast<std::streamsize>(header.used - sizeof(heap_header)));
+    if (!out) {
+        SMART_PTR_KIT_THROW(persistent_heap_error("sptr: failed to write persistent heap " + path));
+    }
+}
+
+} // namespace sptr
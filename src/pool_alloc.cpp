@@ -0,0 +1,342 @@
+#include "pool_alloc.hpp"
+#include "oom_policy.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace sptr {
+
+namespace {
+    // Blocks are carved from page_size-aligned pages whose header names the
+    // owning heap, so a free can find its owner from the address alone
+    constexpr std::size_t page_size = std::size_t(64) << 10;
+    constexpr std::size_t step = 16;
+    constexpr std::size_t max_small = 512;
+    constexpr std::size_t class_count = max_small / step;
+    constexpr unsigned batch_limit = 64;
+
+    struct thread_heap;
+
+    struct free_block {
+        free_block* next;
+    };
+
+    // Everything but owner and cls is touched by the owning thread only
+    struct alignas(step) page_header {
+        thread_heap* owner;
+        std::size_t cls;
+        free_block* free = nullptr;   // blocks handed back to this page
+        char* bump;                   // first block never handed out
+        std::size_t live = 0;         // blocks out, undrained remote frees included
+        page_header* prev = nullptr;  // links in the owner's partial list
+        page_header* next = nullptr;
+        bool partial = false;
+
+        page_header(thread_heap* heap, std::size_t c) noexcept
+            : owner(heap), cls(c), bump(reinterpret_cast<char*>(this) + sizeof(page_header)) {}
+    };
+
+    // Counters written by a single thread; readers only need a relaxed view
+    struct counter {
+        std::atomic<std::size_t> value{0};
+
+        void bump(std::size_t n = 1) noexcept {
+            value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        void drop() noexcept {
+            value.store(value.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+        }
+    };
+
+    struct thread_heap {
+        // Return list pushed by other threads; the only contended field
+        alignas(64) std::atomic<free_block*> remote{nullptr};
+
+        // Per size class: the page allocations come from, and the other
+        // pages that have free blocks again
+        alignas(64) page_header* current[class_count] = {};
+        page_header* partial[class_count] = {};
+
+        // Remote frees not yet handed to their owner
+        thread_heap* pending_owner = nullptr;
+        free_block* pending_head = nullptr;
+        free_block* pending_tail = nullptr;
+        unsigned pending_count = 0;
+
+        counter allocations;
+        counter local_frees;
+        counter remote_frees;
+        counter remote_batches;
+        counter drained;
+        counter pages;
+    };
+
+    struct heap_registry {
+        std::mutex lock;
+        std::vector<thread_heap*> all;
+        std::vector<thread_heap*> abandoned;
+    };
+
+    heap_registry& registry() {
+        // Leaked on purpose: blocks may be freed during static destruction
+        static heap_registry* instance = new heap_registry();
+        return *instance;
+    }
+
+    thread_heap* acquire_heap() {
+        heap_registry& reg = registry();
+        {
+            std::lock_guard<std::mutex> lock(reg.lock);
+            if (!reg.abandoned.empty()) {
+                thread_heap* heap = reg.abandoned.back();
+                reg.abandoned.pop_back();
+                return heap;
+            }
+        }
+        // Heaps are never freed: blocks may still point at them after their
+        // thread exits, and a later thread adopts them
+        auto* heap = new (std::nothrow) thread_heap();
+        if (!heap) {
+            SMART_PTR_KIT_OUT_OF_MEMORY(sizeof(thread_heap));
+        }
+        std::lock_guard<std::mutex> lock(reg.lock);
+        reg.all.push_back(heap);
+        return heap;
+    }
+
+    void flush_pending(thread_heap& heap) noexcept {
+        if (!heap.pending_head) return;
+        std::atomic<free_block*>& remote = heap.pending_owner->remote;
+        free_block* head = remote.load(std::memory_order_relaxed);
+        do {
+            heap.pending_tail->next = head;
+        } while (!remote.compare_exchange_weak(head, heap.pending_head,
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed));
+        heap.remote_batches.bump();
+        heap.pending_owner = nullptr;
+        heap.pending_head = nullptr;
+        heap.pending_tail = nullptr;
+        heap.pending_count = 0;
+    }
+
+    page_header* page_of(const void* p) noexcept {
+        auto addr = reinterpret_cast<std::uintptr_t>(p);
+        return reinterpret_cast<page_header*>(addr & ~(page_size - 1));
+    }
+
+    bool is_small(std::size_t size, std::size_t align) noexcept {
+        return size <= max_small && align <= step;
+    }
+
+    void unlink_partial(thread_heap& heap, page_header& page) noexcept {
+        (page.prev ? page.prev->next : heap.partial[page.cls]) = page.next;
+        if (page.next) page.next->prev = page.prev;
+        page.prev = page.next = nullptr;
+        page.partial = false;
+    }
+
+    void release_page(thread_heap& heap, page_header& page) noexcept {
+        page.~page_header();
+        ::operator delete(static_cast<void*>(&page), std::align_val_t(page_size));
+        heap.pages.drop();
+    }
+
+    // A block is back on its page: an empty page goes back to the system
+    // unless allocations are still being served from it
+    void free_local(thread_heap& heap, page_header& page, free_block* block) noexcept {
+        block->next = page.free;
+        page.free = block;
+        --page.live;
+        if (&page == heap.current[page.cls]) return;
+        if (page.live == 0) {
+            if (page.partial) unlink_partial(heap, page);
+            release_page(heap, page);
+        } else if (!page.partial) {
+            page.next = heap.partial[page.cls];
+            if (page.next) page.next->prev = &page;
+            heap.partial[page.cls] = &page;
+            page.partial = true;
+        }
+    }
+
+    void drain_remote(thread_heap& heap) noexcept {
+        free_block* block = heap.remote.exchange(nullptr, std::memory_order_acquire);
+        std::size_t count = 0;
+        while (block) {
+            free_block* next = block->next;
+            free_local(heap, *page_of(block), block);
+            block = next;
+            ++count;
+        }
+        heap.drained.bump(count);
+    }
+
+    void* take_block(page_header& page) noexcept {
+        void* block;
+        if (page.free) {
+            block = page.free;
+            page.free = page.free->next;
+        } else {
+            std::size_t block_size = (page.cls + 1) * step;
+            if (page.bump + block_size > reinterpret_cast<char*>(&page) + page_size) {
+                return nullptr;
+            }
+            block = page.bump;
+            page.bump += block_size;
+        }
+        ++page.live;
+        return block;
+    }
+
+    // The current page is full: switch to a partial page, or a new one
+    page_header& next_page(thread_heap& heap, std::size_t cls) {
+        page_header* page = heap.partial[cls];
+        if (page) {
+            unlink_partial(heap, *page);
+        } else {
+            void* memory = ::operator new(page_size, std::align_val_t(page_size), std::nothrow);
+            if (!memory) {
+                SMART_PTR_KIT_OUT_OF_MEMORY(page_size);
+            }
+            page = new(memory) page_header(&heap, cls);
+            heap.pages.bump();
+        }
+        // The old current page is full; its frees will list it as partial
+        heap.current[cls] = page;
+        return *page;
+    }
+
+    thread_local thread_heap* t_heap = nullptr;
+    thread_local bool t_exiting = false;
+
+    // Hands the heap back for adoption when its thread exits, along with
+    // the pages it has nothing left on
+    struct heap_guard {
+        ~heap_guard() {
+            t_exiting = true;
+            if (!t_heap) return;
+            thread_heap& heap = *t_heap;
+            flush_pending(heap);
+            drain_remote(heap);
+            for (page_header*& page : heap.current) {
+                if (page && page->live == 0) {
+                    release_page(heap, *page);
+                    page = nullptr;
+                }
+            }
+            heap_registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.lock);
+            reg.abandoned.push_back(t_heap);
+            t_heap = nullptr;
+        }
+    };
+
+    thread_local heap_guard t_guard;
+
+    thread_heap& local_heap() {
+        if (!t_heap) {
+            t_heap = acquire_heap();
+            (void)&t_guard;  // odr-use so the guard is constructed for this thread
+        }
+        return *t_heap;
+    }
+}
+
+pool_stats pool_counters() noexcept {
+    pool_stats stats;
+    heap_registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.lock);
+    stats.heaps = reg.all.size();
+    for (thread_heap* heap : reg.all) {
+        stats.allocations += heap->allocations.value.load(std::memory_order_relaxed);
+        stats.local_frees += heap->local_frees.value.load(std::memory_order_relaxed);
+        stats.remote_frees += heap->remote_frees.value.load(std::memory_order_relaxed);
+        stats.remote_batches += heap->remote_batches.value.load(std::memory_order_relaxed);
+        stats.drained += heap->drained.value.load(std::memory_order_relaxed);
+        stats.pages += heap->pages.value.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+void flush_remote_frees() noexcept {
+    if (t_heap) {
+        flush_pending(*t_heap);
+    }
+}
+
+namespace detail {
+
+void* pool_allocate(std::size_t size, std::size_t align) {
+    if (!is_small(size, align)) {
+        void* p = ::operator new(size, std::align_val_t(align), std::nothrow);
+        if (!p) {
+            SMART_PTR_KIT_OUT_OF_MEMORY(size);
+        }
+        return p;
+    }
+    thread_heap& heap = local_heap();
+    std::size_t cls = size == 0 ? 0 : (size - 1) / step;
+    page_header* page = heap.current[cls];
+    // Reuse returned blocks before bumping into fresh memory
+    if ((!page || !page->free) && heap.remote.load(std::memory_order_relaxed)) {
+        drain_remote(heap);
+    }
+    void* block = page ? take_block(*page) : nullptr;
+    while (!block) {
+        block = take_block(next_page(heap, cls));
+    }
+    heap.allocations.bump();
+    return block;
+}
+
+void pool_deallocate(void* p, std::size_t size, std::size_t align) noexcept {
+    if (!p) return;
+    if (!is_small(size, align)) {
+        ::operator delete(p, std::align_val_t(align));
+        return;
+    }
+    page_header* page = page_of(p);
+    auto* block = static_cast<free_block*>(p);
+
+    thread_heap* heap = t_heap;
+    if (!heap && !t_exiting) {
+        // Consumer threads get a heap too, if only for their pending batch
+        heap = &local_heap();
+    }
+    if (!heap) {
+        // Thread is exiting: push straight to the owner
+        block->next = page->owner->remote.load(std::memory_order_relaxed);
+        while (!page->owner->remote.compare_exchange_weak(block->next, block,
+                                                          std::memory_order_release,
+                                                          std::memory_order_relaxed)) {
+        }
+        return;
+    }
+
+    if (page->owner == heap) {
+        free_local(*heap, *page, block);
+        heap->local_frees.bump();
+        return;
+    }
+
+    if (heap->pending_owner != page->owner) {
+        flush_pending(*heap);
+        heap->pending_owner = page->owner;
+        heap->pending_tail = block;
+    }
+    block->next = heap->pending_head;
+    heap->pending_head = block;
+    heap->remote_frees.bump();
+    if (++heap->pending_count >= batch_limit) {
+        flush_pending(*heap);
+    }
+}
+
+} // namespace detail
+
+} // namespace sptr
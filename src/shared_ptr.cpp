@@ -1,4 +1,97 @@
 #include "shared_ptr.hpp"
 
-// Template implementation is in the header file
-// This file exists to satisfy the build system
\ No newline at end of file
+#include <cstdint>
+#include <thread>
+
+#if defined(__linux__)
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace sptr {
+
+namespace detail {
+
+namespace {
+    // futex words are 32 bits: park on the half of the counter holding the
+    // low bits, which every increment and decrement changes
+    std::uint32_t* futex_word(std::atomic<long>& counter) noexcept {
+        auto* word = reinterpret_cast<std::uint32_t*>(&counter);
+#if defined(__linux__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        if (sizeof(long) > sizeof(std::uint32_t)) word += sizeof(long) / sizeof(std::uint32_t) - 1;
+#endif
+        return word;
+    }
+
+    void wait_on(std::uint32_t* word, std::uint32_t expected, std::chrono::nanoseconds timeout) noexcept {
+        bool forever = timeout == std::chrono::nanoseconds::max();
+#if defined(__linux__)
+        struct timespec ts;
+        struct timespec* tsp = nullptr;
+        if (!forever) {
+            ts.tv_sec = static_cast<time_t>(timeout.count() / 1000000000);
+            ts.tv_nsec = static_cast<long>(timeout.count() % 1000000000);
+            tsp = &ts;
+        }
+        syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, expected, tsp, nullptr, 0);
+#else
+        (void)word;
+        (void)expected;
+        std::chrono::nanoseconds nap = std::chrono::microseconds(100);
+        std::this_thread::sleep_for(forever || nap < timeout ? nap : timeout);
+#endif
+    }
+
+    void wake_all_on(std::uint32_t* word) noexcept {
+#if defined(__linux__)
+        syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#else
+        (void)word;
+#endif
+    }
+}
+
+void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected,
+                std::chrono::nanoseconds timeout) noexcept {
+    wait_on(reinterpret_cast<std::uint32_t*>(&word), expected, timeout);
+}
+
+void futex_wake_all(std::atomic<std::uint32_t>& word) noexcept {
+    wake_all_on(reinterpret_cast<std::uint32_t*>(&word));
+}
+
+bool control_block::wait_for_use_count(long target, std::chrono::nanoseconds timeout) noexcept {
+    using clock = std::chrono::steady_clock;
+    bool forever = timeout == std::chrono::nanoseconds::max();
+    clock::time_point deadline = forever ? clock::time_point::max() : clock::now() + timeout;
+    for (;;) {
+        // Announce the waiter before sampling, so any release after the
+        // sample sees the bit (or changes the word and fails the futex wait)
+        long count = use_counter().fetch_or(waiters_bit, std::memory_order_acq_rel) | waiters_bit;
+        if ((count & count_mask) <= target) {
+            return true;
+        }
+        std::chrono::nanoseconds left = std::chrono::nanoseconds::max();
+        if (!forever) {
+            left = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - clock::now());
+            if (left <= std::chrono::nanoseconds::zero()) {
+                return false;
+            }
+        }
+        wait_on(futex_word(use_counter()), static_cast<std::uint32_t>(count), left);
+    }
+}
+
+void control_block::wake_use_count_waiters(std::atomic<long>& counter) noexcept {
+    // The bit stays set: clearing it here could strand a waiter that set it
+    // again just before the clear. Objects that were waited on keep paying a
+    // wake-up per release, everything else never does.
+    wake_all_on(futex_word(counter));
+}
+
+} // namespace detail
+
+} // namespace sptr
@@ -0,0 +1,39 @@
+#include "shared_string.hpp"
+#include "oom_policy.hpp"
+
+#include <cstdint>
+#include <new>
+
+namespace sptr {
+
+namespace detail {
+
+string_block* string_block::create(const char* chars, std::size_t length) {
+    if (length > SIZE_MAX - sizeof(string_block)) {
+        SMART_PTR_KIT_OUT_OF_MEMORY(SIZE_MAX);
+    }
+    std::size_t bytes = sizeof(string_block) + length;
+    void* mem = ::operator new(bytes, std::nothrow);
+    if (!mem) {
+        SMART_PTR_KIT_OUT_OF_MEMORY(bytes);
+    }
+    string_block* block = nullptr;
+    SMART_PTR_KIT_TRY {
+        block = new(mem) string_block(length);
+    } SMART_PTR_KIT_CATCH_ALL {
+        // Out-of-line counts: the count slot could not be allocated
+        ::operator delete(mem);
+        SMART_PTR_KIT_RETHROW;
+    }
+    std::memcpy(reinterpret_cast<char*>(block + 1), chars, length);
+    return block;
+}
+
+void string_block::destroy() noexcept {
+    this->~string_block();
+    ::operator delete(this);
+}
+
+} // namespace detail
+
+} // namespace sptr
@@ -0,0 +1,189 @@
+#include "trace.hpp"
+#include "oom_policy.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+namespace sptr {
+
+namespace {
+    constexpr char trace_magic[8] = {'S', 'P', 'T', 'R', 'T', 'R', 'C', '1'};
+}
+
+std::vector<trace_record> load_trace(const std::string& path) {
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) {
+        SMART_PTR_KIT_THROW(std::runtime_error("sptr: cannot open trace " + path));
+    }
+    trace_header header;
+    if (std::fread(&header, sizeof(header), 1, f) != 1 || std::memcmp(header.magic, trace_magic, 8) != 0 ||
+        header.record_size != sizeof(trace_record)) {
+        std::fclose(f);
+        SMART_PTR_KIT_THROW(std::runtime_error("sptr: not a trace file: " + path));
+    }
+    std::vector<trace_record> records;
+    trace_record chunk[4096];
+    std::size_t n;
+    while ((n = std::fread(chunk, sizeof(trace_record), 4096, f)) > 0) {
+        records.insert(records.end(), chunk, chunk + n);
+    }
+    std::fclose(f);
+    // Buffers land in the file whole, one thread at a time
+    std::stable_sort(records.begin(), records.end(), [](const trace_record& a, const trace_record& b) {
+        return a.timestamp_ns < b.timestamp_ns;
+    });
+    return records;
+}
+
+#if defined(SMART_PTR_KIT_TRACE)
+
+namespace {
+    constexpr std::size_t buffer_records = 4096;
+
+    // The output file, opened on first use. Leaked on purpose: pointers are
+    // still released during static destruction.
+    struct trace_writer {
+        std::mutex lock;
+        FILE* file = nullptr;
+        std::string path;
+        // Set at exit: late events are dropped rather than reopening the file
+        bool closed = false;
+
+        void open_locked() {
+            if (file || closed) return;
+            if (path.empty()) {
+                const char* env = std::getenv("SMART_PTR_KIT_TRACE_FILE");
+                path = env && *env ? env : "sptr_trace.bin";
+            }
+            file = std::fopen(path.c_str(), "wb");
+            if (!file) return;
+            trace_header header = {};
+            std::memcpy(header.magic, trace_magic, sizeof(header.magic));
+            header.record_size = sizeof(trace_record);
+            std::fwrite(&header, sizeof(header), 1, file);
+        }
+
+        void write(const trace_record* records, std::size_t n) {
+            std::lock_guard<std::mutex> guard(lock);
+            open_locked();
+            if (file) std::fwrite(records, sizeof(trace_record), n, file);
+        }
+
+        void close() {
+            std::lock_guard<std::mutex> guard(lock);
+            if (file) std::fclose(file);
+            file = nullptr;
+            closed = true;
+        }
+    };
+
+    trace_writer& writer() {
+        static trace_writer* instance = [] {
+            auto* w = new trace_writer();
+            std::atexit([] { writer().close(); });
+            return w;
+        }();
+        return *instance;
+    }
+
+    std::atomic<std::uint16_t> next_thread{0};
+
+    // Trivially destructible, so events from other thread_local destructors
+    // still land somewhere (they are written straight through)
+    struct thread_buffer {
+        trace_record* records;
+        std::size_t count;
+        std::uint16_t thread;
+        bool started;
+    };
+
+    thread_local thread_buffer buffer = {nullptr, 0, 0, false};
+
+    void flush_buffer(thread_buffer& b) noexcept {
+        if (b.count == 0) return;
+        writer().write(b.records, b.count);
+        b.count = 0;
+    }
+
+    struct buffer_flusher {
+        ~buffer_flusher() {
+            flush_buffer(buffer);
+            std::free(buffer.records);
+            buffer.records = nullptr;
+        }
+    };
+
+    thread_local buffer_flusher flusher;
+}
+
+void set_trace_file(const std::string& path) {
+    flush_buffer(buffer);
+    trace_writer& w = writer();
+    std::lock_guard<std::mutex> guard(w.lock);
+    if (w.file) std::fclose(w.file);
+    w.file = nullptr;
+    w.closed = false;
+    w.path = path;
+}
+
+void flush_trace() noexcept {
+    flush_buffer(buffer);
+    trace_writer& w = writer();
+    std::lock_guard<std::mutex> guard(w.lock);
+    if (w.file) std::fflush(w.file);
+}
+
+namespace detail {
+
+void trace_event(trace_op op, const void* block, std::size_t size) noexcept {
+    thread_buffer& b = buffer;
+    if (!b.started) {
+        b.started = true;
+        b.thread = next_thread.fetch_add(1, std::memory_order_relaxed);
+        b.records = static_cast<trace_record*>(std::malloc(buffer_records * sizeof(trace_record)));
+        // Registers the flush at thread exit
+        (void)&flusher;
+    }
+    trace_record r;
+    r.timestamp_ns = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+    r.block = reinterpret_cast<std::uintptr_t>(block);
+    r.size = static_cast<std::uint32_t>(std::min<std::size_t>(size, UINT32_MAX));
+    r.thread = b.thread;
+    r.op = op;
+    r.reserved = 0;
+    if (!b.records) {
+        // Exiting thread (or out of memory): write through
+        writer().write(&r, 1);
+        return;
+    }
+    b.records[b.count++] = r;
+    if (b.count == buffer_records) {
+        flush_buffer(b);
+    }
+}
+
+} // namespace detail
+
+#else
+
+void set_trace_file(const std::string&) {}
+
+void flush_trace() noexcept {}
+
+namespace detail {
+
+void trace_event(trace_op, const void*, std::size_t) noexcept {}
+
+} // namespace detail
+
+#endif // SMART_PTR_KIT_TRACE
+
+} // namespace sptr
@@ -0,0 +1,40 @@
+#include "unique_array.hpp"
+#include "oom_policy.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace sptr {
+
+namespace detail {
+
+void* aligned_array_allocate(std::size_t bytes, std::size_t align) {
+    if (align == 0 || (align & (align - 1)) != 0) {
+        SMART_PTR_KIT_THROW(std::invalid_argument("sptr: alignment must be a power of two"));
+    }
+    if (align < sizeof(void*)) {
+        align = sizeof(void*);
+    }
+    // Even an empty array owns a buffer, so a null data() means "no array"
+    if (bytes < align) {
+        bytes = align;
+    }
+    if (bytes > SIZE_MAX - align) {
+        SMART_PTR_KIT_OUT_OF_MEMORY(bytes);
+    }
+    // aligned_alloc wants a whole number of alignment units
+    void* p = std::aligned_alloc(align, (bytes + align - 1) / align * align);
+    if (!p) {
+        SMART_PTR_KIT_OUT_OF_MEMORY(bytes);
+    }
+    return p;
+}
+
+void aligned_array_deallocate(void* p) noexcept {
+    std::free(p);
+}
+
+} // namespace detail
+
+} // namespace sptr
@@ -0,0 +1,90 @@
+// Probe functions for codegen_test. This file is compiled at -O2 on its own
+// and disassembled; each probe is one hot-path operation whose instruction
+// sequence the test pins down. extern "C" keeps the symbol names readable.
+// It is compiled a second time with -fno-exceptions to compare the two
+// modes.
+
+#include <new>
+#include <utility>
+
+#include "shared_ptr.hpp"
+#include "unique_ptr.hpp"
+#include "weak_ptr.hpp"
+
+using shared_int = sptr::shared_ptr<int>;
+using weak_int = sptr::weak_ptr<int>;
+using unique_int = sptr::unique_ptr<int>;
+
+extern "C" {
+
+// Copy: one locked increment, no call
+void probe_shared_copy(const shared_int& src, void* dst) {
+    new(dst) shared_int(src);
+}
+
+// Move: plain loads and stores
+void probe_shared_move(shared_int& src, void* dst) {
+    new(dst) shared_int(std::move(src));
+}
+
+void probe_shared_swap(shared_int& a, shared_int& b) {
+    a.swap(b);
+}
+
+// Release: one locked decrement while other owners remain
+void probe_shared_destroy(shared_int* p) {
+    p->~shared_int();
+}
+
+int* probe_shared_get(const shared_int& p) {
+    return p.get();
+}
+
+void probe_weak_copy(const weak_int& src, void* dst) {
+    new(dst) weak_int(src);
+}
+
+void probe_weak_move(weak_int& src, void* dst) {
+    new(dst) weak_int(std::move(src));
+}
+
+// unique_ptr is a bare pointer: access is one load
+int* probe_unique_get(const unique_int& p) {
+    return p.get();
+}
+
+int probe_unique_deref(const unique_int& p) {
+    return *p;
+}
+
+void probe_unique_move(unique_int& src, void* dst) {
+    new(dst) unique_int(std::move(src));
+}
+
+int* probe_unique_release(unique_int& p) {
+    return p.release();
+}
+
+// Factories: allocation failure goes through the OOM policy, so none of
+// these needs a cleanup landing pad in either mode
+void probe_make_shared(void* dst) {
+    new(dst) shared_int(sptr::make_shared<int>(1));
+}
+
+void probe_try_make_shared(void* dst) {
+    new(dst) shared_int(sptr::try_make_shared<int>(1));
+}
+
+void probe_make_shared_array(std::size_t n, void* dst) {
+    new(dst) sptr::shared_ptr<int[]>(sptr::make_shared<int[]>(n));
+}
+
+void probe_shared_from_raw(int* p, void* dst) {
+    new(dst) shared_int(p);
+}
+
+void probe_make_unique(void* dst) {
+    new(dst) unique_int(sptr::make_unique<int>(1));
+}
+
+} // extern "C"
@@ -0,0 +1,268 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include "owned_ptr.hpp"
+#include "shared_ptr.hpp"
+#include "shared_string.hpp"
+#include "unique_array.hpp"
+#include "unique_ptr.hpp"
+#include "weak_bind.hpp"
+#include "weak_ptr.hpp"
+
+// Disassembles the -O2 probe object (codegen_probes.cpp) with objdump and
+// holds the hot paths to their expected instruction sequences. Given the
+// probes compiled with -fno-exceptions as well, it holds that build to the
+// same budgets and compares the two builds' sizes.
+//
+// Usage: codegen_test <objdump> <codegen_probes.o> [<no-exceptions codegen_probes.o>]
+
+namespace {
+
+std::string objdump_path;
+std::string object_path;
+std::string noexcept_object_path;
+
+// Out-of-line counts cost one extra load, of the block's slot pointer
+#if defined(SMART_PTR_KIT_OUT_OF_LINE_COUNTS)
+constexpr std::size_t slot_load = 1;
+#else
+constexpr std::size_t slot_load = 0;
+#endif
+
+// Instructions of each function, "mnemonic operands" with the address and
+// raw bytes stripped, up to and including the first ret (the hot path;
+// what follows is padding or out-of-line slow paths)
+using disassembly = std::map<std::string, std::vector<std::string>>;
+
+disassembly disassemble(const std::string& object) {
+    disassembly result;
+    std::string cmd = objdump_path + " -d --no-show-raw-insn " + object;
+    FILE* pipe = popen(cmd.c_str(), "r");
+    if (!pipe) return result;
+
+    std::vector<std::string>* current = nullptr;
+    bool done = false;
+    char line[512];
+    while (std::fgets(line, sizeof(line), pipe)) {
+        std::string s(line);
+        while (!s.empty() && (s.back() == '\n' || s.back() == ' ')) s.pop_back();
+        // "0000000000000000 <probe_shared_copy>:"
+        std::size_t open = s.find(" <");
+        if (open != std::string::npos && s.size() > 2 && s.compare(s.size() - 2, 2, ">:") == 0) {
+            current = &result[s.substr(open + 2, s.size() - open - 4)];
+            done = false;
+            continue;
+        }
+        // "   10:\tlock addq $0x1,0x8(%rax)"
+        std::size_t tab = s.find(":\t");
+        if (!current || done || tab == std::string::npos) continue;
+        std::string insn = s.substr(tab + 2);
+        for (auto& c : insn) {
+            if (c == '\t') c = ' ';
+        }
+        current->push_back(insn);
+        if (insn.compare(0, 3, "ret") == 0) done = true;
+    }
+    pclose(pipe);
+    return result;
+}
+
+const disassembly& probes(const std::string& object = object_path) {
+    static std::map<std::string, disassembly> cache;
+    auto it = cache.find(object);
+    if (it == cache.end()) it = cache.emplace(object, disassemble(object)).first;
+    return it->second;
+}
+
+const std::vector<std::string>& probe(const std::string& name, const std::string& object = object_path) {
+    static const std::vector<std::string> missing;
+    const disassembly& d = probes(object);
+    auto it = d.find(name);
+    return it == d.end() ? missing : it->second;
+}
+
+// Sizes in bytes of `objdump <flag>` entries: functions from the symbol
+// table (-t) or sections from the headers (-h)
+std::map<std::string, std::size_t> sizes(const std::string& object, const char* flag) {
+    std::map<std::string, std::size_t> result;
+    std::string cmd = objdump_path + " " + flag + " " + object;
+    FILE* pipe = popen(cmd.c_str(), "r");
+    if (!pipe) return result;
+    char line[512];
+    while (std::fgets(line, sizeof(line), pipe)) {
+        char a[128], b[128], c[128], d[128], e[128], f[128];
+        if (std::strcmp(flag, "-t") == 0) {
+            // "0000000000000000 g     F .text\t000000000000001a probe_shared_copy"
+            if (std::sscanf(line, "%127s %127s %127s %127s %127s %127s", a, b, c, d, e, f) == 6 &&
+                std::strcmp(c, "F") == 0) {
+                result[f] = std::strtoul(e, nullptr, 16);
+            }
+        } else if (std::sscanf(line, "%127s %127s %127s", a, b, c) == 3 && b[0] == '.') {
+            // "  0 .text         0000002a  0000000000000000 ..."
+            result[b] = std::strtoul(c, nullptr, 16);
+        }
+    }
+    pclose(pipe);
+    return result;
+}
+
+// Code plus the unwind data and landing-pad tables exceptions need
+std::size_t code_and_unwind_bytes(const std::string& object) {
+    std::size_t total = 0;
+    for (const auto& s : sizes(object, "-h")) {
+        const std::string& name = s.first;
+        if (name.compare(0, 5, ".text") == 0 || name.compare(0, 9, ".eh_frame") == 0 ||
+            name.compare(0, 17, ".gcc_except_table") == 0) {
+            total += s.second;
+        }
+    }
+    return total;
+}
+
+int count_prefix(const std::vector<std::string>& insns, const std::string& prefix) {
+    int n = 0;
+    for (const auto& i : insns) {
+        if (i.compare(0, prefix.size(), prefix) == 0) ++n;
+    }
+    return n;
+}
+
+// Any call, or a jump through a register (a tail call)
+bool has_call(const std::vector<std::string>& insns) {
+    for (const auto& i : insns) {
+        if (i.compare(0, 4, "call") == 0 || i.find("jmp *") != std::string::npos) return true;
+    }
+    return false;
+}
+
+std::string listing(const std::vector<std::string>& insns) {
+    std::string out;
+    for (const auto& i : insns) out += "    " + i + "\n";
+    return out;
+}
+
+} // namespace
+
+class CodegenTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+#if !defined(__x86_64__)
+        GTEST_SKIP() << "instruction budgets are written for x86-64";
+#endif
+        if (object_path.empty()) {
+            GTEST_SKIP() << "no probe object given";
+        }
+        ASSERT_FALSE(probes().empty()) << "could not disassemble " << object_path;
+    }
+
+    // Holds in the -fno-exceptions build too, when it is given
+    static void expect_budget(const std::string& name, std::size_t max_insns, int locks) {
+        for (const std::string* object : {&object_path, &noexcept_object_path}) {
+            if (object->empty()) continue;
+            const auto& insns = probe(name, *object);
+            ASSERT_FALSE(insns.empty()) << name << " not found in " << *object;
+            EXPECT_LE(insns.size(), max_insns) << name << ":\n" << listing(insns);
+            EXPECT_EQ(count_prefix(insns, "lock"), locks) << name << ":\n" << listing(insns);
+            EXPECT_FALSE(has_call(insns)) << name << ":\n" << listing(insns);
+        }
+    }
+};
+
+TEST_F(CodegenTests, SharedCopyIsOneLockedIncrement) {
+    expect_budget("probe_shared_copy", 7 + slot_load, 1);
+    const auto& insns = probe("probe_shared_copy");
+    int rmw = count_prefix(insns, "lock add") + count_prefix(insns, "lock inc") + count_prefix(insns, "lock xadd");
+    EXPECT_EQ(rmw, 1) << listing(insns);
+    // A CAS loop would mean the increment stopped being a plain fetch_add
+    EXPECT_EQ(count_prefix(insns, "lock cmpxchg"), 0);
+}
+
+TEST_F(CodegenTests, SharedMoveHasNoAtomics) {
+    expect_budget("probe_shared_move", 5, 0);
+    expect_budget("probe_shared_swap", 9, 0);
+    expect_budget("probe_shared_get", 2, 0);
+}
+
+TEST_F(CodegenTests, SharedReleaseFastPathIsOneLockedDecrement) {
+    // Up to the first ret: the release that leaves other owners behind
+    expect_budget("probe_shared_destroy", 20 + slot_load, 1);
+}
+
+TEST_F(CodegenTests, WeakCopyIsOneLockedIncrement) {
+    expect_budget("probe_weak_copy", 7 + slot_load, 1);
+    expect_budget("probe_weak_move", 5, 0);
+}
+
+TEST_F(CodegenTests, UniquePtrIsABarePointer) {
+    expect_budget("probe_unique_get", 2, 0);
+    expect_budget("probe_unique_deref", 3, 0);
+    expect_budget("probe_unique_move", 4, 0);
+    expect_budget("probe_unique_release", 3, 0);
+}
+
+TEST_F(CodegenTests, FactoriesNeedNoLandingPads) {
+    // Allocation failure is reported, not cleaned up after: the factories
+    // have nothing to unwind even when exceptions are on
+    if (slot_load != 0) {
+        GTEST_SKIP() << "out-of-line counts: a failed slot allocation must free the block";
+    }
+    auto sections = sizes(object_path, "-h");
+    auto table = sections.find(".gcc_except_table");
+    EXPECT_TRUE(table == sections.end() || table->second == 0)
+        << "a probe grew a landing pad:\n" << listing(probe("probe_make_shared"));
+}
+
+TEST_F(CodegenTests, ExceptionFreeBuildIsNoLarger) {
+    if (noexcept_object_path.empty()) {
+        GTEST_SKIP() << "no -fno-exceptions probe object given";
+    }
+    auto with = sizes(object_path, "-t");
+    auto without = sizes(noexcept_object_path, "-t");
+    std::printf("%-28s %12s %14s\n", "probe", "exceptions", "no exceptions");
+    for (const auto& f : with) {
+        if (f.first.compare(0, 6, "probe_") != 0) continue;
+        std::printf("%-28s %10zu B %12zu B\n", f.first.c_str(), f.second, without[f.first]);
+        EXPECT_LE(without[f.first], f.second) << f.first;
+    }
+    std::size_t with_total = code_and_unwind_bytes(object_path);
+    std::size_t without_total = code_and_unwind_bytes(noexcept_object_path);
+    std::printf("%-28s %10zu B %12zu B\n", "code + unwind data", with_total, without_total);
+    EXPECT_LE(without_total, with_total);
+}
+
+TEST(SizeBudgetTests, PointerSizes) {
+    constexpr std::size_t word = sizeof(void*);
+    EXPECT_EQ(sizeof(sptr::unique_ptr<int>), word);
+    EXPECT_EQ(sizeof(sptr::unique_ptr<int[]>), word);
+    EXPECT_EQ(sizeof(sptr::unique_ptr<int, sptr::allocator_delete<std::allocator<int>>>), word);
+    EXPECT_EQ(sizeof(sptr::shared_ptr<int>), 2 * word);
+    EXPECT_EQ(sizeof(sptr::weak_ptr<int>), 2 * word);
+    EXPECT_EQ(sizeof(sptr::owned_ptr<int>), 2 * word);
+    EXPECT_EQ(sizeof(sptr::unique_array<int>), 2 * word);
+    EXPECT_EQ(sizeof(sptr::shared_string), 3 * word);
+    EXPECT_LE(sizeof(sptr::weak_binder<void (std::string::*)(), std::string>), 4 * word);
+}
+
+TEST(SizeBudgetTests, ControlBlockOverhead) {
+    constexpr std::size_t word = sizeof(void*);
+    // vtable, two counts (or the side-table slot pointer) and the hook list
+    EXPECT_LE(sizeof(sptr::detail::inplace_control_block<long>) - sizeof(long), 4 * word);
+    // ...plus the pointer and the deleter, which is stored even when empty
+    EXPECT_LE(sizeof(sptr::detail::ptr_control_block<long>), 6 * word);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    if (argc >= 3) {
+        objdump_path = argv[1];
+        object_path = argv[2];
+    }
+    if (argc >= 4) {
+        noexcept_object_path = argv[3];
+    }
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "deep_clone.hpp"
+
+namespace {
+
+struct Node {
+    Node() = default;
+    Node(const Node& other)
+        : value(other.value), label(other.label), children(other.children), parent(other.parent) {
+        if (value == throw_on_copy) throw std::runtime_error("copy failed");
+        copies++;
+    }
+
+    int value = 0;
+    std::string label;
+    std::vector<sptr::shared_ptr<Node>> children;
+    sptr::weak_ptr<Node> parent;
+
+    static int destroyed;
+    static int copies;
+    static int throw_on_copy;
+    ~Node() { destroyed++; }
+};
+
+int Node::destroyed = 0;
+int Node::copies = 0;
+int Node::throw_on_copy = -1;
+
+template <typename Visitor>
+void sptr_visit_children(Node& n, Visitor& visit) {
+    for (auto& c : n.children) visit(c);
+    visit(n.parent);
+}
+
+sptr::shared_ptr<Node> make_node(int value, const std::string& label) {
+    auto n = sptr::make_shared<Node>();
+    n->value = value;
+    n->label = label;
+    return n;
+}
+
+void link(const sptr::shared_ptr<Node>& parent, const sptr::shared_ptr<Node>& child) {
+    parent->children.push_back(child);
+    child->parent = parent;
+}
+
+} // namespace
+
+class DeepCloneTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Node::destroyed = 0;
+        Node::copies = 0;
+        Node::throw_on_copy = -1;
+    }
+};
+
+TEST_F(DeepCloneTests, ClonesTreeIndependently) {
+    auto root = make_node(1, "root");
+    link(root, make_node(2, "left"));
+    link(root, make_node(3, "right"));
+
+    auto copy = sptr::deep_clone(root);
+    ASSERT_TRUE(copy);
+    EXPECT_NE(copy.get(), root.get());
+    EXPECT_EQ(Node::copies, 3);
+    ASSERT_EQ(copy->children.size(), 2u);
+    EXPECT_NE(copy->children[0].get(), root->children[0].get());
+    EXPECT_EQ(copy->children[1]->label, "right");
+
+    copy->children[0]->label = "changed";
+    EXPECT_EQ(root->children[0]->label, "left");
+}
+
+TEST_F(DeepCloneTests, SharedNodeIsClonedOnce) {
+    auto shared = make_node(7, "shared");
+    auto root = make_node(1, "root");
+    root->children.push_back(shared);
+    root->children.push_back(shared);
+
+    auto copy = sptr::deep_clone(root);
+    EXPECT_EQ(Node::copies, 2);
+    EXPECT_EQ(copy->children[0].get(), copy->children[1].get());
+    EXPECT_NE(copy->children[0].get(), shared.get());
+    EXPECT_EQ(copy->children[0].use_count(), 2);
+}
+
+TEST_F(DeepCloneTests, WeakEdgesPointAtClones) {
+    auto root = make_node(1, "root");
+    link(root, make_node(2, "child"));
+
+    auto copy = sptr::deep_clone(root);
+    EXPECT_EQ(copy->children[0]->parent.lock().get(), copy.get());
+    EXPECT_EQ(root->children[0]->parent.lock().get(), root.get());
+}
+
+TEST_F(DeepCloneTests, WeakEdgeOutsideGraphKeepsOriginal) {
+    auto outer = make_node(1, "outer");
+    link(outer, make_node(2, "subtree"));
+
+    auto copy = sptr::deep_clone(outer->children[0]);
+    EXPECT_EQ(Node::copies, 1);
+    EXPECT_EQ(copy->parent.lock().get(), outer.get());
+}
+
+TEST_F(DeepCloneTests, ClonesAreReleased) {
+    auto root = make_node(1, "root");
+    for (int i = 0; i < 100; ++i) {
+        link(root, make_node(i, "child"));
+    }
+    {
+        auto copy = sptr::deep_clone(root);
+        EXPECT_EQ(Node::copies, 101);
+    }
+    EXPECT_EQ(Node::destroyed, 101);
+}
+
+TEST_F(DeepCloneTests, LongChainDoesNotRecurse) {
+    auto head = make_node(0, "");
+    auto tail = head;
+    for (int i = 1; i < 10000; ++i) {
+        auto next = make_node(i, "");
+        link(tail, next);
+        tail = next;
+    }
+    auto copy = sptr::deep_clone(head);
+    EXPECT_EQ(Node::copies, 10000);
+
+    auto n = copy;
+    int count = 1;
+    while (!n->children.empty()) {
+        EXPECT_EQ(n->children[0]->parent.lock().get(), n.get());
+        n = n->children[0];
+        ++count;
+    }
+    EXPECT_EQ(count, 10000);
+    EXPECT_EQ(n->value, 9999);
+
+    // Unlink iteratively; the recursive destructor chain is too deep for
+    // sanitizer builds
+    n.reset();
+    for (auto* list : {&head, &copy}) {
+        auto cur = *list;
+        list->reset();
+        while (cur && !cur->children.empty()) {
+            auto next = cur->children[0];
+            cur->children.clear();
+            cur = next;
+        }
+    }
+    tail.reset();
+}
+
+TEST_F(DeepCloneTests, ThrowingCopyLeavesOriginalIntact) {
+    auto root = make_node(1, "root");
+    link(root, make_node(2, "ok"));
+    link(root, make_node(3, "bad"));
+    Node::throw_on_copy = 3;
+
+    EXPECT_THROW(sptr::deep_clone(root), std::runtime_error);
+    EXPECT_EQ(Node::destroyed, Node::copies);
+    EXPECT_EQ(root.use_count(), 1);
+    EXPECT_EQ(root->children[1]->parent.lock().get(), root.get());
+}
+
+TEST_F(DeepCloneTests, NullRoot) {
+    sptr::shared_ptr<Node> empty;
+    EXPECT_FALSE(sptr::deep_clone(empty));
+}
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include "dispose_hook.hpp"
+#include "weak_ptr.hpp"
+
+namespace {
+
+class Resource {
+public:
+    explicit Resource(int v = 0) : value(v) {}
+    ~Resource() { destroyed++; }
+
+    int value;
+
+    static int destroyed;
+    static void reset() { destroyed = 0; }
+};
+
+int Resource::destroyed = 0;
+
+} // namespace
+
+class DisposeHookTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Resource::reset();
+    }
+};
+
+TEST_F(DisposeHookTests, RunsBeforeDestructor) {
+    auto p = sptr::make_shared<Resource>(5);
+    sptr::weak_ptr<Resource> w(p);
+    Resource* raw = p.get();
+    int seen = -1;
+    int destroyed_before = -1;
+    bool expired = false;
+    auto hook = sptr::on_dispose(p, [&] {
+        seen = raw->value;
+        destroyed_before = Resource::destroyed;
+        expired = w.expired();
+    });
+    EXPECT_TRUE(hook.armed());
+
+    auto copy = p;
+    p.reset();
+    EXPECT_EQ(seen, -1);
+    copy.reset();
+    EXPECT_EQ(seen, 5);
+    EXPECT_EQ(destroyed_before, 0);
+    EXPECT_TRUE(expired);
+    EXPECT_EQ(Resource::destroyed, 1);
+    EXPECT_FALSE(hook.armed());
+}
+
+TEST_F(DisposeHookTests, RemovedHookDoesNotRun) {
+    auto p = sptr::make_shared<Resource>();
+    int runs = 0;
+    {
+        auto a = sptr::on_dispose(p, [&] { runs += 1; });
+        auto b = sptr::on_dispose(p, [&] { runs += 10; });
+        auto c = sptr::on_dispose(p, [&] { runs += 100; });
+        b.reset();
+        EXPECT_FALSE(b.armed());
+        // a and c are unregistered when they go out of scope
+    }
+    auto d = sptr::on_dispose(p, [&] { runs += 1000; });
+    p.reset();
+    EXPECT_EQ(runs, 1000);
+}
+
+TEST_F(DisposeHookTests, MultipleHooksAllRun) {
+    auto p = sptr::make_shared<Resource>();
+    int runs = 0;
+    sptr::dispose_hook hooks[] = {
+        {p, [&] { runs++; }},
+        {p, [&] { runs++; }},
+        {p, [&] { runs++; }},
+    };
+    p.reset();
+    EXPECT_EQ(runs, 3);
+}
+
+TEST_F(DisposeHookTests, LargeCallableIsSupported) {
+    auto p = sptr::make_shared<Resource>();
+    std::string captured(100, 'x');
+    char padding[64] = {};
+    std::size_t seen = 0;
+    auto hook = sptr::on_dispose(p, [&seen, captured, padding] { seen = captured.size() + sizeof(padding); });
+    p.reset();
+    EXPECT_EQ(seen, 164u);
+}
+
+TEST_F(DisposeHookTests, IndexDropsEntryEagerly) {
+    struct entry {
+        sptr::weak_ptr<Resource> object;
+        std::unique_ptr<sptr::dispose_hook> hook;
+    };
+    std::map<int, entry> index;
+    std::vector<sptr::shared_ptr<Resource>> owners;
+    for (int i = 0; i < 10; ++i) {
+        owners.push_back(sptr::make_shared<Resource>(i));
+        auto& e = index[i];
+        e.object = owners.back();
+        // The callback destroys its own hook along with the entry
+        e.hook.reset(new sptr::dispose_hook(owners.back(), [&index, i] { index.erase(i); }));
+    }
+    owners[3].reset();
+    owners[7].reset();
+    EXPECT_EQ(index.size(), 8u);
+    EXPECT_EQ(index.count(3), 0u);
+    EXPECT_EQ(index.count(7), 0u);
+    index.clear();
+    owners.clear();
+    EXPECT_EQ(Resource::destroyed, 10);
+}
+
+TEST_F(DisposeHookTests, ResetWaitsForRunningCallback) {
+    auto p = sptr::make_shared<Resource>();
+    std::atomic<bool> started{false};
+    std::atomic<bool> finished{false};
+    sptr::dispose_hook hook(p, [&] {
+        started = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        finished = true;
+    });
+    std::thread releaser([&] { p.reset(); });
+    while (!started) std::this_thread::yield();
+    hook.reset();
+    EXPECT_TRUE(finished);
+    releaser.join();
+}
+
+TEST_F(DisposeHookTests, NullOwnerIsNeverArmed) {
+    sptr::shared_ptr<Resource> empty;
+    int runs = 0;
+    auto hook = sptr::on_dispose(empty, [&] { runs++; });
+    EXPECT_FALSE(hook.armed());
+}
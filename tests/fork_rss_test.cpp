@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "shared_ptr.hpp"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <malloc.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// A preloaded record; make_shared puts its control block right next to it
+struct Record {
+    char bytes[192];
+};
+
+constexpr long records = 40000;
+
+#if defined(__linux__)
+// Sum of Private_Dirty over the whole address space, in kB; -1 if unknown.
+// Reads with raw syscalls so the measurement itself dirties no heap pages.
+long private_dirty_kb() {
+    int fd = open("/proc/self/smaps_rollup", O_RDONLY);
+    if (fd < 0) return -1;
+    char buf[4096];
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) return -1;
+    buf[n] = '\0';
+    const char* line = std::strstr(buf, "Private_Dirty:");
+    if (!line) return -1;
+    return std::strtol(line + std::strlen("Private_Dirty:"), nullptr, 10);
+}
+
+// Forks a worker that copies every shared_ptr once, like a request handler
+// touching the preloaded data, and returns how many kB it had to un-share
+long child_dirtied_kb(const std::vector<sptr::shared_ptr<Record>>& data) {
+    int fds[2];
+    if (pipe(fds) != 0) return -1;
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        long before = private_dirty_kb();
+        for (const auto& p : data) {
+            sptr::shared_ptr<Record> copy = p;
+            asm volatile("" : : "r"(copy.get()) : "memory");
+        }
+        long after = private_dirty_kb();
+        long delta = before < 0 || after < 0 ? -1 : after - before;
+        ssize_t written = write(fds[1], &delta, sizeof(delta));
+        _exit(written == sizeof(delta) ? 0 : 1);
+    }
+    close(fds[1]);
+    long delta = -1;
+    if (read(fds[0], &delta, sizeof(delta)) != sizeof(delta)) delta = -1;
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return delta;
+}
+#endif
+
+} // namespace
+
+TEST(ForkRssTests, ChildRefcountTrafficStaysOffObjectPages) {
+#if !defined(__linux__)
+    GTEST_SKIP() << "needs /proc/self/smaps_rollup";
+#else
+    std::vector<sptr::shared_ptr<Record>> data;
+    data.reserve(records);
+    for (long i = 0; i < records; ++i) {
+        data.push_back(sptr::make_shared<Record>());
+    }
+    long payload_kb = records * static_cast<long>(sizeof(Record)) / 1024;
+
+    long dirtied = child_dirtied_kb(data);
+    if (dirtied < 0) {
+        GTEST_SKIP() << "private RSS not measurable here";
+    }
+    RecordProperty("child_private_dirty_kb", static_cast<int>(dirtied));
+    RecordProperty("payload_kb", static_cast<int>(payload_kb));
+#if defined(SMART_PTR_KIT_OUT_OF_LINE_COUNTS)
+    // Only the dense count table is un-shared: 16 bytes per record
+    EXPECT_LT(dirtied, payload_kb / 4);
+#else
+    // Counts live next to the records, so every page holding one is copied
+    EXPECT_GT(dirtied, payload_kb / 2);
+#endif
+#endif
+}
+
+TEST(ForkRssTests, CountsWorkAcrossManyBlocks) {
+    // Exercises slot reuse in the out-of-line mode (and is a plain refcount
+    // test otherwise)
+    for (int round = 0; round < 3; ++round) {
+        std::vector<sptr::shared_ptr<int>> v;
+        for (int i = 0; i < 10000; ++i) {
+            v.push_back(sptr::make_shared<int>(i));
+        }
+        std::vector<sptr::shared_ptr<int>> copies(v.begin(), v.end());
+        for (int i = 0; i < 10000; ++i) {
+            EXPECT_EQ(v[i].use_count(), 2);
+            EXPECT_EQ(*copies[i], i);
+        }
+    }
+}
+
+#if defined(SMART_PTR_KIT_OUT_OF_LINE_COUNTS) && defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+TEST(ForkRssTests, TryMakeSharedSurvivesAFullCountTable) {
+    // Leave the heap plenty of free blocks, then forbid any new mapping: the
+    // count table is what runs out, and try_make_shared must come back empty
+    // rather than throw through its noexcept
+    EXPECT_EXIT(
+        {
+            constexpr int blocks = 1 << 16;
+            std::vector<sptr::shared_ptr<Record>> v;
+            v.reserve(blocks);
+            mallopt(M_TRIM_THRESHOLD, INT_MAX);
+            mallopt(M_MMAP_THRESHOLD, INT_MAX);
+            std::vector<void*> spare(blocks);
+            for (void*& p : spare) p = std::malloc(2 * sizeof(Record));
+            for (void* p : spare) std::free(p);
+            long pages = 0;
+            if (FILE* f = std::fopen("/proc/self/statm", "r")) {
+                if (std::fscanf(f, "%ld", &pages) != 1) pages = 0;
+                std::fclose(f);
+            }
+            rlimit limit{};
+            getrlimit(RLIMIT_AS, &limit);
+            limit.rlim_cur = static_cast<rlim_t>(pages) * sysconf(_SC_PAGESIZE);
+            setrlimit(RLIMIT_AS, &limit);
+            for (int i = 0; i < blocks; ++i) {
+                auto p = sptr::try_make_shared<Record>();
+                if (!p) std::_Exit(0);
+                v.push_back(std::move(p));
+            }
+            std::_Exit(1);
+        },
+        ::testing::ExitedWithCode(0), "");
+}
+#endif
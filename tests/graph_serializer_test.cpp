@@ -0,0 +1,223 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "graph_serializer.hpp"
+
+namespace {
+
+struct Node {
+    int value = 0;
+    std::string label;
+    std::vector<sptr::shared_ptr<Node>> children;
+    sptr::weak_ptr<Node> parent;
+
+    static int destroyed;
+    ~Node() { destroyed++; }
+};
+
+int Node::destroyed = 0;
+
+void sptr_save(sptr::graph_writer& w, const Node& n) {
+    w.write(n.value);
+    w.write(n.label);
+    w.write(n.children);
+    w.write(n.parent);
+}
+
+void sptr_load(sptr::graph_reader& r, Node& n) {
+    r.read(n.value);
+    r.read(n.label);
+    r.read(n.children);
+    r.read(n.parent);
+}
+
+sptr::shared_ptr<Node> make_node(int value, const std::string& label) {
+    auto n = sptr::make_shared<Node>();
+    n->value = value;
+    n->label = label;
+    return n;
+}
+
+void link(const sptr::shared_ptr<Node>& parent, const sptr::shared_ptr<Node>& child) {
+    parent->children.push_back(child);
+    child->parent = parent;
+}
+
+} // namespace
+
+class GraphSerializerTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Node::destroyed = 0;
+    }
+};
+
+TEST_F(GraphSerializerTests, RoundTripsTree) {
+    auto root = make_node(1, "root");
+    link(root, make_node(2, "left"));
+    link(root, make_node(3, "right"));
+
+    std::stringstream buffer;
+    sptr::save_graph(buffer, root);
+    auto copy = sptr::load_graph<Node>(buffer);
+
+    ASSERT_TRUE(copy);
+    EXPECT_NE(copy.get(), root.get());
+    EXPECT_EQ(copy->label, "root");
+    ASSERT_EQ(copy->children.size(), 2u);
+    EXPECT_EQ(copy->children[0]->value, 2);
+    EXPECT_EQ(copy->children[1]->label, "right");
+    EXPECT_EQ(copy->children[0]->parent.lock().get(), copy.get());
+    EXPECT_EQ(copy.use_count(), 1);
+}
+
+TEST_F(GraphSerializerTests, SharedNodesAreWrittenOnce) {
+    auto shared = make_node(42, std::string(1000, 'x'));
+    auto root = make_node(0, "root");
+    for (int i = 0; i < 100; ++i) {
+        root->children.push_back(shared);
+    }
+
+    std::stringstream buffer;
+    sptr::graph_writer writer(buffer);
+    writer.write(root);
+    writer.finish();
+    EXPECT_EQ(writer.objects_written(), 2u);
+    EXPECT_LT(buffer.str().size(), 2000u);
+
+    auto copy = sptr::load_graph<Node>(buffer);
+    ASSERT_EQ(copy->children.size(), 100u);
+    EXPECT_EQ(copy->children[0].get(), copy->children[99].get());
+    EXPECT_EQ(copy->children[0].use_count(), 100);
+}
+
+TEST_F(GraphSerializerTests, RestoresCycles) {
+    auto a = make_node(1, "a");
+    auto b = make_node(2, "b");
+    a->children.push_back(b);
+    b->children.push_back(a);
+
+    std::stringstream buffer;
+    sptr::save_graph(buffer, a);
+    a->children.clear();  // break the original cycle so it can be freed
+
+    auto copy = sptr::load_graph<Node>(buffer);
+    EXPECT_EQ(copy->children[0]->children[0].get(), copy.get());
+    copy->children.clear();
+}
+
+TEST_F(GraphSerializerTests, WeakOnlyTargetsComeBackExpired) {
+    auto outsider = make_node(9, "outside");
+    auto root = make_node(1, "root");
+    root->parent = outsider;  // not strongly reachable from root
+
+    std::stringstream buffer;
+    sptr::save_graph(buffer, root);
+    int destroyed_before = Node::destroyed;
+    auto copy = sptr::load_graph<Node>(buffer);
+
+    EXPECT_TRUE(copy->parent.expired());
+    EXPECT_EQ(Node::destroyed, destroyed_before + 1);
+}
+
+TEST_F(GraphSerializerTests, NullRootAndMultipleRoots) {
+    std::stringstream buffer;
+    sptr::shared_ptr<Node> null_root;
+    auto root = make_node(5, "r");
+    {
+        sptr::graph_writer writer(buffer);
+        writer.write(null_root);
+        writer.write(root);
+        writer.write(root);
+        writer.finish();
+    }
+    sptr::graph_reader reader(buffer);
+    sptr::shared_ptr<Node> a, b, c;
+    reader.read(a);
+    reader.read(b);
+    reader.read(c);
+    reader.finish();
+    EXPECT_FALSE(a);
+    EXPECT_EQ(b.get(), c.get());
+    EXPECT_EQ(b->value, 5);
+}
+
+TEST_F(GraphSerializerTests, AliasingPointersAreDistinctObjects) {
+    struct Pair {
+        Node first;
+        Node second;
+    };
+    auto pair = sptr::make_shared<Pair>();
+    pair->first.value = 1;
+    pair->second.value = 2;
+    auto root = make_node(0, "root");
+    root->children.push_back(sptr::shared_ptr<Node>(pair, &pair->first));
+    root->children.push_back(sptr::shared_ptr<Node>(pair, &pair->second));
+    root->children.push_back(sptr::shared_ptr<Node>(pair, &pair->first));
+
+    std::stringstream buffer;
+    sptr::save_graph(buffer, root);
+    auto copy = sptr::load_graph<Node>(buffer);
+    ASSERT_EQ(copy->children.size(), 3u);
+    // One block, two objects: neither edge may stand in for the other
+    EXPECT_EQ(copy->children[0]->value, 1);
+    EXPECT_EQ(copy->children[1]->value, 2);
+    EXPECT_EQ(copy->children[0].get(), copy->children[2].get());
+}
+
+TEST_F(GraphSerializerTests, RejectsPointersWithoutControlBlock) {
+    Node outside;
+    auto root = make_node(0, "root");
+    root->children.push_back(sptr::shared_ptr<Node>(sptr::shared_ptr<Node>(), &outside));
+    std::stringstream buffer;
+    EXPECT_THROW(sptr::save_graph(buffer, root), sptr::graph_format_error);
+}
+
+TEST_F(GraphSerializerTests, RejectsBadStreams) {
+    std::stringstream garbage("definitely not a graph");
+    EXPECT_THROW(sptr::load_graph<Node>(garbage), sptr::graph_format_error);
+
+    auto root = make_node(1, "root");
+    link(root, make_node(2, "child"));
+    std::stringstream buffer;
+    sptr::save_graph(buffer, root);
+    std::string bytes = buffer.str();
+    std::stringstream truncated(bytes.substr(0, bytes.size() - 6));
+    EXPECT_THROW(sptr::load_graph<Node>(truncated), sptr::graph_format_error);
+}
+
+TEST_F(GraphSerializerTests, LongChainsDoNotRecurse) {
+    auto head = make_node(0, "");
+    auto tail = head;
+    for (int i = 1; i < 200000; ++i) {
+        auto next = make_node(i, "");
+        tail->children.push_back(next);
+        tail = next;
+    }
+
+    std::stringstream buffer;
+    sptr::save_graph(buffer, head);
+    auto copy = sptr::load_graph<Node>(buffer);
+
+    const Node* n = copy.get();
+    int count = 1;
+    while (!n->children.empty()) {
+        n = n->children[0].get();
+        ++count;
+    }
+    EXPECT_EQ(count, 200000);
+    EXPECT_EQ(n->value, 199999);
+
+    // Unlink iteratively; the recursive destructor chain would overflow
+    for (auto* list : {&head, &copy}) {
+        auto cur = *list;
+        list->reset();
+        while (cur && !cur->children.empty()) {
+            auto next = cur->children[0];
+            cur->children.clear();
+            cur = next;
+        }
+    }
+    tail.reset();
+}
@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+#include "huge_page_alloc.hpp"
+#include "numa_alloc.hpp"
+
+class Counted {
+public:
+    Counted() { constructed++; }
+    ~Counted() { destroyed++; }
+
+    static void reset() { constructed = 0; destroyed = 0; }
+    static int constructed;
+    static int destroyed;
+};
+
+int Counted::constructed = 0;
+int Counted::destroyed = 0;
+
+class HugePageAllocTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Counted::reset();
+        saved = sptr::get_huge_page_config();
+    }
+
+    void TearDown() override {
+        sptr::set_huge_page_config(saved);
+    }
+
+    sptr::huge_page_config saved;
+};
+
+static std::size_t large_backed(const sptr::huge_page_stats& s) {
+    return s.hugetlb_bytes + s.thp_advised_bytes + s.fallback_bytes;
+}
+
+TEST_F(HugePageAllocTests, SmallArraysStayOnRegularHeap) {
+    auto before = sptr::huge_page_counters();
+    {
+        auto arr = sptr::make_unique_huge<int[]>(16);
+        EXPECT_EQ(arr[0], 0);
+        EXPECT_EQ(arr[15], 0);
+        EXPECT_GT(sptr::huge_page_counters().small_bytes, before.small_bytes);
+        EXPECT_EQ(large_backed(sptr::huge_page_counters()), large_backed(before));
+    }
+    EXPECT_EQ(sptr::huge_page_counters().small_bytes, before.small_bytes);
+}
+
+TEST_F(HugePageAllocTests, LargeArraysAreHugePageBacked) {
+    auto before = sptr::huge_page_counters();
+    const std::size_t n = (std::size_t(4) << 20) / sizeof(double);
+    {
+        auto arr = sptr::make_unique_huge<double[]>(n, true);
+        arr[0] = 1.0;
+        arr[n - 1] = 2.0;
+        EXPECT_EQ(arr[n - 1], 2.0);
+
+        auto during = sptr::huge_page_counters();
+        EXPECT_GE(large_backed(during) - large_backed(before), n * sizeof(double));
+    }
+    EXPECT_EQ(large_backed(sptr::huge_page_counters()), large_backed(before));
+}
+
+TEST_F(HugePageAllocTests, ThresholdIsConfigurable) {
+    sptr::huge_page_config config;
+    config.threshold = 4096;
+    config.use_hugetlb = false;
+    sptr::set_huge_page_config(config);
+
+    auto before = sptr::huge_page_counters();
+    auto arr = sptr::make_unique_huge<char[]>(8192);
+    auto during = sptr::huge_page_counters();
+    EXPECT_EQ(during.hugetlb_bytes, before.hugetlb_bytes);
+    EXPECT_GT(during.thp_advised_bytes + during.fallback_bytes, before.thp_advised_bytes + before.fallback_bytes);
+}
+
+TEST_F(HugePageAllocTests, ArrayElementsAreDestroyed) {
+    {
+        auto arr = sptr::make_unique_huge<Counted[]>(10);
+        EXPECT_EQ(Counted::constructed, 10);
+    }
+    EXPECT_EQ(Counted::destroyed, 10);
+}
+
+TEST_F(HugePageAllocTests, MakeSharedHuge) {
+    sptr::huge_page_config config;
+    config.threshold = 4096;
+    sptr::set_huge_page_config(config);
+
+    auto before = sptr::huge_page_counters();
+    {
+        auto arr = sptr::make_shared_huge<Counted[]>(5000);
+        EXPECT_EQ(Counted::constructed, 5000);
+        EXPECT_EQ(arr.use_count(), 1);
+        EXPECT_GT(large_backed(sptr::huge_page_counters()), large_backed(before));
+
+        auto copy = arr;
+        EXPECT_EQ(copy.get(), &arr[0]);
+    }
+    EXPECT_EQ(Counted::destroyed, 5000);
+    EXPECT_EQ(large_backed(sptr::huge_page_counters()), large_backed(before));
+}
+
+TEST_F(HugePageAllocTests, AllocatorRespectsAlignment) {
+    sptr::huge_page_allocator<std::max_align_t> alloc;
+    auto* p = alloc.allocate(3);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p) % alignof(std::max_align_t), 0u);
+    alloc.deallocate(p, 3);
+}
+
+TEST_F(HugePageAllocTests, ArenaSlabsFollowPolicy) {
+    sptr::huge_page_config config;
+    config.advise_slabs = true;
+    sptr::set_huge_page_config(config);
+
+    // Force a fresh slab: more small objects than one 2 MiB chunk can hold
+    auto before = sptr::huge_page_counters();
+    std::size_t reserved = sptr::numa_stats(0).bytes_reserved;
+    std::vector<sptr::shared_ptr<int>> ptrs;
+    while (sptr::numa_stats(0).bytes_reserved == reserved) {
+        ptrs.push_back(sptr::make_shared_on_node<int>(0, 1));
+    }
+    auto after = sptr::huge_page_counters();
+    // THP may be disabled system-wide; then no advice is taken or counted
+    EXPECT_GE(after.slab_advised_bytes, before.slab_advised_bytes);
+}
+
+TEST_F(HugePageAllocTests, OverflowingCountsFailCleanly) {
+    // n * 8 wraps to 0; it must fail rather than allocate a tiny block
+    constexpr std::size_t wraps = SIZE_MAX / 4 + 1;
+    EXPECT_THROW(sptr::make_unique_huge<std::uint64_t[]>(wraps), std::bad_alloc);
+    EXPECT_THROW(sptr::huge_page_allocator<std::uint64_t>().allocate(wraps), std::bad_alloc);
+    // Fits in size_t, but not once the header is added
+    EXPECT_THROW(sptr::huge_page_allocator<char>().allocate(SIZE_MAX - 16), std::bad_alloc);
+}
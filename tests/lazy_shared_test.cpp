@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "lazy_shared.hpp"
+
+namespace {
+
+class Resource {
+public:
+    explicit Resource(int v = 0) : value(v) {}
+    ~Resource() { destroyed++; }
+
+    int value;
+
+    static std::atomic<int> destroyed;
+    static void reset() { destroyed = 0; }
+};
+
+std::atomic<int> Resource::destroyed{0};
+
+} // namespace
+
+class LazySharedTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Resource::reset();
+    }
+};
+
+TEST_F(LazySharedTests, BuildsOnFirstUse) {
+    int calls = 0;
+    {
+        sptr::lazy_shared<Resource> lazy([&calls] {
+            ++calls;
+            return Resource(7);
+        });
+        EXPECT_FALSE(lazy.ready());
+        EXPECT_EQ(calls, 0);
+
+        EXPECT_EQ(lazy.get().value, 7);
+        EXPECT_TRUE(lazy.ready());
+        EXPECT_EQ(lazy->value, 7);
+        EXPECT_EQ(&*lazy, &lazy.get());
+        EXPECT_EQ(calls, 1);
+    }
+    // One temporary returned by the factory, then the shared object
+    EXPECT_EQ(Resource::destroyed, 2);
+}
+
+TEST_F(LazySharedTests, DefaultConstructsWithoutFactory) {
+    sptr::lazy_shared<Resource> lazy;
+    EXPECT_EQ(lazy.get().value, 0);
+}
+
+TEST_F(LazySharedTests, AcceptsSharedPtrFactory) {
+    sptr::lazy_shared<Resource> lazy([] { return sptr::make_shared<Resource>(5); });
+    EXPECT_EQ(lazy.get().value, 5);
+    EXPECT_EQ(Resource::destroyed, 0);
+}
+
+TEST_F(LazySharedTests, GetSharedOutlivesTheLazy) {
+    sptr::shared_ptr<Resource> kept;
+    {
+        sptr::lazy_shared<Resource> lazy([] { return sptr::make_shared<Resource>(9); });
+        kept = lazy.get_shared();
+        EXPECT_EQ(kept.get(), &lazy.get());
+        EXPECT_EQ(kept.use_count(), 2);
+    }
+    EXPECT_EQ(Resource::destroyed, 0);
+    EXPECT_EQ(kept->value, 9);
+    EXPECT_EQ(kept.use_count(), 1);
+}
+
+TEST_F(LazySharedTests, FailedFactoryIsRetried) {
+    int calls = 0;
+    sptr::lazy_shared<Resource> lazy([&calls] {
+        if (++calls == 1) {
+            throw std::runtime_error("not yet");
+        }
+        return sptr::make_shared<Resource>(calls);
+    });
+    EXPECT_THROW(lazy.get(), std::runtime_error);
+    EXPECT_FALSE(lazy.ready());
+    EXPECT_EQ(lazy.get().value, 2);
+    EXPECT_EQ(calls, 2);
+}
+
+TEST_F(LazySharedTests, NullFactoryResultIsAFailure) {
+    int calls = 0;
+    sptr::lazy_shared<Resource> lazy([&calls]() -> sptr::shared_ptr<Resource> {
+        if (++calls == 1) {
+            return nullptr;
+        }
+        return sptr::make_shared<Resource>(calls);
+    });
+    EXPECT_THROW(lazy.get(), std::logic_error);
+    EXPECT_FALSE(lazy.ready());
+    EXPECT_EQ(lazy.get().value, 2);
+    EXPECT_TRUE(lazy.ready());
+    EXPECT_EQ(calls, 2);
+}
+
+TEST_F(LazySharedTests, ConcurrentCallersShareOneBuild) {
+    std::atomic<int> calls{0};
+    sptr::lazy_shared<Resource> lazy([&calls] {
+        ++calls;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return sptr::make_shared<Resource>(11);
+    });
+
+    std::vector<std::thread> threads;
+    std::vector<Resource*> seen(8, nullptr);
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&lazy, &seen, i] { seen[i] = &lazy.get(); });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(calls, 1);
+    for (Resource* p : seen) {
+        EXPECT_EQ(p, &lazy.get());
+    }
+    EXPECT_EQ(lazy.get().value, 11);
+}
+
+TEST_F(LazySharedTests, WaitersRetryAfterFailedBuild) {
+    std::atomic<int> calls{0};
+    sptr::lazy_shared<Resource> lazy([&calls] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (++calls == 1) {
+            throw std::runtime_error("first build fails");
+        }
+        return sptr::make_shared<Resource>(3);
+    });
+
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&] {
+            try {
+                EXPECT_EQ(lazy.get().value, 3);
+            } catch (const std::runtime_error&) {
+                ++failures;
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(failures, 1);
+    EXPECT_EQ(calls, 2);
+}
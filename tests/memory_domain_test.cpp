@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "memory_domain.hpp"
+#include "weak_ptr.hpp"
+
+class Resource {
+public:
+    Resource() : m_id(next_id++) {}
+    Resource(int value) : m_id(next_id++), m_value(value) {}
+    ~Resource() { destroyed++; }
+
+    int id() const { return m_id; }
+    int value() const { return m_value; }
+
+    static void reset() { next_id = 0; destroyed = 0; }
+    static int destroyed;
+
+private:
+    int m_id;
+    int m_value = 0;
+    static int next_id;
+};
+
+int Resource::next_id = 0;
+int Resource::destroyed = 0;
+
+struct Blob {
+    char bytes[1000];
+};
+
+class MemoryDomainTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Resource::reset();
+    }
+};
+
+TEST_F(MemoryDomainTests, ChargesAndCreditsSharedPtr) {
+    sptr::memory_domain domain("tenant-a");
+    EXPECT_EQ(domain.name(), "tenant-a");
+    {
+        auto ptr = sptr::make_shared_in<Resource>(domain, 42);
+        EXPECT_EQ(ptr->value(), 42);
+        // Control block and object are charged together
+        EXPECT_GT(domain.live_bytes_exact(), sizeof(Resource));
+    }
+    EXPECT_EQ(Resource::destroyed, 1);
+    EXPECT_EQ(domain.live_bytes_exact(), 0u);
+}
+
+TEST_F(MemoryDomainTests, WeakPtrDefersCredit) {
+    sptr::memory_domain domain;
+    sptr::weak_ptr<Resource> weak;
+    {
+        auto ptr = sptr::make_shared_in<Resource>(domain, 1);
+        weak = ptr;
+    }
+    // Object disposed, but the block is still charged until destroy()
+    EXPECT_EQ(Resource::destroyed, 1);
+    EXPECT_GT(domain.live_bytes_exact(), 0u);
+    weak.reset();
+    EXPECT_EQ(domain.live_bytes_exact(), 0u);
+}
+
+TEST_F(MemoryDomainTests, ChargesUniquePtr) {
+    sptr::memory_domain domain;
+    {
+        auto ptr = sptr::make_unique_in<Resource>(domain, 3);
+        EXPECT_EQ(ptr->value(), 3);
+        EXPECT_EQ(domain.live_bytes_exact(), sizeof(Resource));
+    }
+    EXPECT_EQ(Resource::destroyed, 1);
+    EXPECT_EQ(domain.live_bytes_exact(), 0u);
+}
+
+TEST_F(MemoryDomainTests, HardLimitFailsAllocation) {
+    sptr::memory_domain domain;
+    domain.set_hard_limit(10 * 1024);
+
+    std::vector<sptr::shared_ptr<Blob>> blobs;
+    for (int i = 0; i < 9; ++i) {
+        blobs.push_back(sptr::make_shared_in<Blob>(domain));
+    }
+    EXPECT_THROW(sptr::make_shared_in<Blob>(domain), sptr::domain_limit_exceeded);
+    EXPECT_THROW(sptr::make_unique_in<Blob>(domain), std::bad_alloc);
+    EXPECT_EQ(domain.rejected(), 2u);
+    EXPECT_LE(domain.live_bytes_exact(), 10u * 1024);
+
+    // Freeing makes room again
+    blobs.pop_back();
+    EXPECT_NO_THROW(sptr::make_shared_in<Blob>(domain));
+}
+
+TEST_F(MemoryDomainTests, SoftLimitCallsBackOncePerCrossing) {
+    sptr::memory_domain domain;
+    int calls = 0;
+    std::size_t reported = 0;
+    domain.set_soft_limit(64 * 1024, [&](sptr::memory_domain&, std::size_t live) {
+        ++calls;
+        reported = live;
+    });
+
+    std::vector<sptr::unique_ptr<Blob, sptr::domain_delete<Blob>>> blobs;
+    for (int i = 0; i < 200; ++i) {
+        blobs.push_back(sptr::make_unique_in<Blob>(domain));
+    }
+    EXPECT_EQ(calls, 1);
+    EXPECT_GE(reported, 64u * 1024);
+
+    blobs.clear();
+    for (int i = 0; i < 200; ++i) {
+        blobs.push_back(sptr::make_unique_in<Blob>(domain));
+    }
+    EXPECT_EQ(calls, 2);
+}
+
+TEST_F(MemoryDomainTests, ThrowingSoftLimitCallbackIsContained) {
+    sptr::memory_domain domain;
+    int calls = 0;
+    domain.set_soft_limit(64 * 1024, [&](sptr::memory_domain&, std::size_t) {
+        ++calls;
+        throw std::runtime_error("over budget");
+    });
+    std::vector<sptr::unique_ptr<Blob, sptr::domain_delete<Blob>>> blobs;
+    for (int i = 0; i < 200; ++i) {
+        blobs.push_back(sptr::make_unique_in<Blob>(domain));
+    }
+    EXPECT_EQ(calls, 1);
+    blobs.clear();
+    EXPECT_EQ(domain.live_bytes_exact(), 0u);
+}
+
+TEST_F(MemoryDomainTests, EstimateTracksExactAcrossThreads) {
+    sptr::memory_domain domain;
+    std::vector<std::thread> threads;
+    std::vector<std::vector<sptr::shared_ptr<Blob>>> held(4);
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 500; ++i) {
+                held[t].push_back(sptr::make_shared_in<Blob>(domain));
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    std::size_t exact = domain.live_bytes_exact();
+    std::size_t estimate = domain.live_bytes();
+    EXPECT_GE(exact, 4u * 500 * sizeof(Blob));
+    // The estimate includes the shards' unused reservations
+    EXPECT_GE(estimate, exact);
+    EXPECT_LE(estimate - exact,
+              sptr::memory_domain::shard_count * 2 * static_cast<std::size_t>(sptr::memory_domain::quantum));
+
+    held.clear();
+    EXPECT_EQ(domain.live_bytes_exact(), 0u);
+}
+
+TEST_F(MemoryDomainTests, HardLimitHoldsUnderContention) {
+    // Threads racing for the last bytes must not all get them
+    sptr::memory_domain domain;
+    constexpr std::size_t limit = 64 * 1024;
+    domain.set_hard_limit(limit);
+    std::atomic<std::size_t> granted{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&] {
+            while (domain.try_charge(1000)) granted += 1000;
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    EXPECT_LE(granted.load(), limit);
+    EXPECT_GT(granted.load(), limit - 1000 * 8);
+    EXPECT_EQ(domain.live_bytes_exact(), granted.load());
+    EXPECT_GE(domain.rejected(), 8u);
+}
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+// Built with -fno-exceptions against a copy of the library built the same
+// way: every header has to compile in that mode, and failures follow the
+// out-of-memory policy instead of throwing.
+#include "deep_clone.hpp"
+#include "dispose_hook.hpp"
+#include "graph_serializer.hpp"
+#include "huge_page_alloc.hpp"
+#include "lazy_shared.hpp"
+#include "memory_domain.hpp"
+#include "numa_alloc.hpp"
+#include "observer_list.hpp"
+#include "oom_policy.hpp"
+#include "owned_ptr.hpp"
+#include "ownership_group.hpp"
+#include "persistent_heap.hpp"
+#include "pool_alloc.hpp"
+#include "relocate.hpp"
+#include "scoped_shared.hpp"
+#include "shared_ptr.hpp"
+#include "shared_string.hpp"
+#include "trace.hpp"
+#include "unique_array.hpp"
+#include "unique_ptr.hpp"
+#include "weak_bind.hpp"
+#include "weak_ptr.hpp"
+#include "weak_scan.hpp"
+
+static_assert(!SMART_PTR_KIT_HAS_EXCEPTIONS, "this test must be built with -fno-exceptions");
+
+namespace {
+
+// More than any allocator will hand out
+constexpr std::size_t too_many = SIZE_MAX / 4;
+
+int handler_calls = 0;
+
+void counting_handler(std::size_t) {
+    ++handler_calls;
+}
+
+void logging_handler(std::size_t bytes) {
+    std::fprintf(stderr, "oom handler saw %zu bytes\n", bytes);
+}
+
+void exiting_handler(std::size_t) {
+    std::_Exit(3);
+}
+
+struct page {
+    char bytes[4096];
+};
+
+class NoExceptionsTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        handler_calls = 0;
+        sptr::set_oom_handler(nullptr);
+    }
+
+    void TearDown() override {
+        sptr::set_oom_handler(nullptr);
+    }
+};
+
+} // namespace
+
+TEST_F(NoExceptionsTests, FactoriesWork) {
+    auto p = sptr::make_shared<int>(1);
+    auto a = sptr::make_shared<int[]>(16);
+    auto u = sptr::make_unique<int>(2);
+    auto o = sptr::make_owned<int>(3);
+    sptr::shared_ptr<int> raw(new int(4));
+    EXPECT_EQ(*p + a[15] + *u + *o + *raw, 10);
+}
+
+TEST_F(NoExceptionsTests, TryFactoriesAreNoexcept) {
+    static_assert(noexcept(sptr::try_make_shared<int>(1)));
+    static_assert(noexcept(sptr::try_make_shared<int[]>(4)));
+    static_assert(noexcept(sptr::try_make_unique<int>(1)));
+    auto p = sptr::try_make_shared<int>(5);
+    ASSERT_TRUE(p);
+    EXPECT_EQ(*p, 5);
+    auto u = sptr::try_make_unique<int>(6);
+    ASSERT_TRUE(u);
+    EXPECT_EQ(*u, 6);
+}
+
+TEST_F(NoExceptionsTests, TryMakeSharedReturnsEmptyOnFailure) {
+    sptr::set_oom_handler(&counting_handler);
+    auto a = sptr::try_make_shared<char[]>(too_many);
+    EXPECT_FALSE(a);
+    EXPECT_EQ(a.use_count(), 0);
+    // The caller handles it; the handler is not involved
+    EXPECT_EQ(handler_calls, 0);
+}
+
+TEST_F(NoExceptionsTests, MakeSharedAbortsOnFailure) {
+    EXPECT_DEATH(sptr::make_shared<char[]>(too_many), "sptr: out of memory allocating");
+}
+
+TEST_F(NoExceptionsTests, HandlerRunsBeforeTheAbort) {
+    sptr::set_oom_handler(&logging_handler);
+    EXPECT_DEATH(sptr::make_shared<char[]>(too_many), "oom handler saw [0-9]+ bytes");
+}
+
+TEST_F(NoExceptionsTests, HandlerMayTakeOver) {
+    sptr::set_oom_handler(&exiting_handler);
+    EXPECT_EXIT(sptr::make_shared<char[]>(too_many), ::testing::ExitedWithCode(3), "");
+}
+
+TEST_F(NoExceptionsTests, SetHandlerReturnsThePreviousOne) {
+    EXPECT_EQ(sptr::set_oom_handler(&counting_handler), nullptr);
+    EXPECT_EQ(sptr::get_oom_handler(), &counting_handler);
+    EXPECT_EQ(sptr::set_oom_handler(&logging_handler), &counting_handler);
+}
+
+TEST_F(NoExceptionsTests, OtherErrorsAbortWithTheirMessage) {
+    // Thrown from the library's sources
+    EXPECT_DEATH(sptr::load_trace("/nonexistent/sptr.trace"), "sptr: cannot open trace");
+    // ...and from its headers
+    sptr::memory_domain domain("capped");
+    domain.set_hard_limit(64);
+    EXPECT_DEATH(sptr::make_shared_in<page>(domain), "memory domain hard limit exceeded");
+}
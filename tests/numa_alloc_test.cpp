@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include "numa_alloc.hpp"
+#include "weak_ptr.hpp"
+
+class Resource {
+public:
+    Resource() : m_id(next_id++) {}
+    Resource(int value) : m_id(next_id++), m_value(value) {}
+    ~Resource() { destroyed++; }
+
+    int id() const { return m_id; }
+    int value() const { return m_value; }
+
+    static void reset() { next_id = 0; destroyed = 0; }
+    static int destroyed;
+
+private:
+    int m_id;
+    int m_value = 0;
+    static int next_id;
+};
+
+int Resource::next_id = 0;
+int Resource::destroyed = 0;
+
+struct alignas(64) CacheLine {
+    char bytes[64];
+};
+
+class NumaAllocTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Resource::reset();
+    }
+};
+
+TEST_F(NumaAllocTests, NodeTopology) {
+    EXPECT_GE(sptr::numa_node_count(), 1);
+    EXPECT_GE(sptr::current_numa_node(), 0);
+    EXPECT_LT(sptr::current_numa_node(), sptr::numa_node_count());
+}
+
+TEST_F(NumaAllocTests, MakeSharedOnNode) {
+    auto before = sptr::numa_stats(0);
+    {
+        auto ptr = sptr::make_shared_on_node<Resource>(0, 42);
+        EXPECT_TRUE(ptr);
+        EXPECT_EQ(ptr->value(), 42);
+        EXPECT_EQ(ptr.use_count(), 1);
+
+        auto during = sptr::numa_stats(0);
+        EXPECT_EQ(during.allocations, before.allocations + 1);
+        EXPECT_GT(during.bytes_live, before.bytes_live);
+        EXPECT_GT(during.bytes_reserved, 0u);
+    }
+    EXPECT_EQ(Resource::destroyed, 1);
+
+    auto after = sptr::numa_stats(0);
+    EXPECT_EQ(after.deallocations, before.deallocations + 1);
+    EXPECT_EQ(after.bytes_live, before.bytes_live);
+}
+
+TEST_F(NumaAllocTests, WeakPtrKeepsNodeBlockAlive) {
+    sptr::weak_ptr<Resource> weak;
+    {
+        auto ptr = sptr::make_shared_local<Resource>(7);
+        weak = ptr;
+        EXPECT_FALSE(weak.expired());
+    }
+    EXPECT_EQ(Resource::destroyed, 1);
+    EXPECT_TRUE(weak.expired());
+}
+
+TEST_F(NumaAllocTests, MakeUniqueOnNode) {
+    {
+        auto ptr = sptr::make_unique_on_node<Resource>(0, 5);
+        EXPECT_EQ(ptr->value(), 5);
+
+        auto local = sptr::make_unique_local<Resource>(6);
+        EXPECT_EQ(local->value(), 6);
+    }
+    EXPECT_EQ(Resource::destroyed, 2);
+}
+
+TEST_F(NumaAllocTests, FreedBlocksAreReused) {
+    void* first = sptr::detail::numa_allocate(48, 16, 0);
+    sptr::detail::numa_deallocate(first, 48, 16);
+    void* second = sptr::detail::numa_allocate(48, 16, 0);
+    EXPECT_EQ(first, second);
+    sptr::detail::numa_deallocate(second, 48, 16);
+}
+
+TEST_F(NumaAllocTests, RespectsAlignment) {
+    auto ptr = sptr::make_unique_on_node<CacheLine>(0);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(ptr.get()) % 64, 0u);
+
+    // Past the size-class range the arena maps a dedicated region
+    void* big = sptr::detail::numa_allocate(std::size_t(1) << 20, 4096, 0);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(big) % 4096, 0u);
+    sptr::detail::numa_deallocate(big, std::size_t(1) << 20, 4096);
+}
+
+TEST_F(NumaAllocTests, ReportsPlacement) {
+    auto ptr = sptr::make_shared_on_node<Resource>(0, 1);
+    int node = sptr::numa_node_of(ptr.get());
+    // -1 when the kernel does not expose placement (e.g. no NUMA support)
+    EXPECT_TRUE(node == -1 || (node >= 0 && node < sptr::numa_node_count()));
+}
+
+TEST_F(NumaAllocTests, UnknownNodeThrows) {
+    EXPECT_THROW(sptr::make_shared_on_node<Resource>(sptr::numa_node_count(), 1),
+                 std::invalid_argument);
+}
+
+TEST_F(NumaAllocTests, RejectsOverflowingCounts) {
+    sptr::numa_allocator<std::uint64_t> alloc(0);
+    EXPECT_THROW(alloc.allocate(SIZE_MAX / 4), std::bad_alloc);
+}
@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "observer_list.hpp"
+
+namespace {
+
+class Subscriber {
+public:
+    explicit Subscriber(int v = 0) : value(v) {}
+    ~Subscriber() { destroyed++; }
+
+    void notify() { calls++; }
+
+    int value;
+    std::atomic<int> calls{0};
+
+    static std::atomic<int> destroyed;
+    static void reset() { destroyed = 0; }
+};
+
+std::atomic<int> Subscriber::destroyed{0};
+
+} // namespace
+
+class ObserverListTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Subscriber::reset();
+    }
+};
+
+TEST_F(ObserverListTests, NotifiesLiveSubscribers) {
+    sptr::observer_list<Subscriber> list;
+    auto a = sptr::make_shared<Subscriber>(1);
+    auto b = sptr::make_shared<Subscriber>(2);
+    list.add(a);
+    list.add(b);
+
+    EXPECT_EQ(list.for_each([](Subscriber& s) { s.notify(); }), 2u);
+    EXPECT_EQ(a->calls, 1);
+    EXPECT_EQ(b->calls, 1);
+    // The list does not keep subscribers alive
+    EXPECT_EQ(a.use_count(), 1);
+}
+
+TEST_F(ObserverListTests, DeadSubscribersAreSkippedAndDropped) {
+    sptr::observer_list<Subscriber> list;
+    auto a = sptr::make_shared<Subscriber>(1);
+    auto b = sptr::make_shared<Subscriber>(2);
+    list.add(a);
+    list.add(b);
+    b.reset();
+
+    EXPECT_EQ(list.for_each([](Subscriber& s) { s.notify(); }), 1u);
+    EXPECT_EQ(list.size(), 2u);
+    list.compact();
+    EXPECT_EQ(list.size(), 1u);
+}
+
+TEST_F(ObserverListTests, RemoveUnsubscribes) {
+    sptr::observer_list<Subscriber> list;
+    auto a = sptr::make_shared<Subscriber>(1);
+    auto b = sptr::make_shared<Subscriber>(2);
+    list.add(a);
+    list.add(b);
+
+    EXPECT_TRUE(list.remove(a));
+    EXPECT_FALSE(list.remove(a));
+    list.for_each([](Subscriber& s) { s.notify(); });
+    EXPECT_EQ(a->calls, 0);
+    EXPECT_EQ(b->calls, 1);
+}
+
+TEST_F(ObserverListTests, NotificationCompactsMostlyExpiredList) {
+    sptr::observer_list<Subscriber> list;
+    std::vector<sptr::shared_ptr<Subscriber>> subs;
+    for (int i = 0; i < 100; ++i) {
+        subs.push_back(sptr::make_shared<Subscriber>(i));
+        list.add(subs.back());
+    }
+    subs.resize(10);
+    EXPECT_EQ(list.for_each([](Subscriber&) {}), 10u);
+    EXPECT_EQ(list.size(), 10u);
+}
+
+TEST_F(ObserverListTests, CallbackMaySubscribeAndUnsubscribe) {
+    sptr::observer_list<Subscriber> list;
+    auto a = sptr::make_shared<Subscriber>(1);
+    auto late = sptr::make_shared<Subscriber>(2);
+    list.add(a);
+
+    list.for_each([&](Subscriber&) {
+        list.add(late);
+        list.remove(a);
+    });
+    // The running notification used its own snapshot
+    EXPECT_EQ(late->calls, 0);
+    list.for_each([](Subscriber& s) { s.notify(); });
+    EXPECT_EQ(a->calls, 0);
+    EXPECT_EQ(late->calls, 1);
+}
+
+TEST_F(ObserverListTests, ConcurrentNotifyAndChurn) {
+    sptr::observer_list<Subscriber> list;
+    std::vector<sptr::shared_ptr<Subscriber>> stable;
+    for (int i = 0; i < 64; ++i) {
+        stable.push_back(sptr::make_shared<Subscriber>(i));
+        list.add(stable.back());
+    }
+
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> notifiers;
+    for (int t = 0; t < 3; ++t) {
+        notifiers.emplace_back([&] {
+            while (!stop) {
+                std::size_t n = list.for_each([](Subscriber& s) { s.notify(); });
+                EXPECT_GE(n, 64u);
+            }
+        });
+    }
+    for (int i = 0; i < 2000; ++i) {
+        auto temp = sptr::make_shared<Subscriber>(-1);
+        list.add(temp);
+        if (i % 2) list.remove(temp);
+    }
+    stop = true;
+    for (auto& t : notifiers) t.join();
+
+    for (auto& s : stable) {
+        EXPECT_GT(s->calls, 0);
+    }
+    list.compact();
+    EXPECT_EQ(list.size(), 64u);
+    EXPECT_EQ(Subscriber::destroyed, 2000);
+}
+
+TEST_F(ObserverListTests, ReadersNeverSeeAFreedSnapshot) {
+    // Back-to-back rebuilds retire a snapshot while readers registered
+    // under either parity may still be walking it; run under ASan or TSan
+    // (SMART_PTR_KIT_SANITIZER) to catch an early free
+    sptr::observer_list<Subscriber> list;
+    std::vector<sptr::shared_ptr<Subscriber>> subs;
+    for (int i = 0; i < 32; ++i) {
+        subs.push_back(sptr::make_shared<Subscriber>(i));
+        list.add(subs.back());
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<long> checksum{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 3; ++t) {
+        threads.emplace_back([&] {
+            while (!stop) {
+                long sum = 0;
+                std::size_t n = list.for_each([&](Subscriber& s) { sum += s.value; });
+                EXPECT_EQ(n, 32u);
+                checksum += sum;
+            }
+        });
+    }
+    for (int t = 0; t < 2; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 5000; ++i) list.compact();
+        });
+    }
+    for (std::size_t i = 3; i < threads.size(); ++i) threads[i].join();
+    stop = true;
+    for (int t = 0; t < 3; ++t) threads[t].join();
+
+    EXPECT_EQ(checksum % (31 * 32 / 2), 0);
+    EXPECT_EQ(list.size(), 32u);
+}
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include "owned_ptr.hpp"
+
+namespace {
+
+class Resource {
+public:
+    explicit Resource(int v = 0) : value(v) {}
+    virtual ~Resource() { destroyed++; }
+
+    int value;
+
+    static std::atomic<int> destroyed;
+    static void reset() { destroyed = 0; }
+};
+
+std::atomic<int> Resource::destroyed{0};
+
+class Derived : public Resource {
+public:
+    using Resource::Resource;
+};
+
+} // namespace
+
+class OwnedPtrTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Resource::reset();
+    }
+};
+
+TEST_F(OwnedPtrTests, UniqueOwnership) {
+    auto owner = sptr::make_owned<Resource>(5);
+    EXPECT_EQ(owner->value, 5);
+    auto moved = std::move(owner);
+    EXPECT_FALSE(owner);
+    EXPECT_EQ(moved->value, 5);
+    moved.reset();
+    EXPECT_EQ(Resource::destroyed, 1);
+}
+
+TEST_F(OwnedPtrTests, ObserverSeesDeath) {
+    auto owner = sptr::make_owned<Resource>(1);
+    sptr::observer_ref<Resource> obs(owner);
+    auto copy = obs;
+    EXPECT_FALSE(obs.expired());
+    {
+        auto b = copy.lock();
+        ASSERT_TRUE(b);
+        EXPECT_EQ(b->value, 1);
+    }
+    owner.reset();
+    EXPECT_EQ(Resource::destroyed, 1);
+    EXPECT_TRUE(obs.expired());
+    EXPECT_TRUE(copy.expired());
+    EXPECT_FALSE(obs.lock());
+}
+
+TEST_F(OwnedPtrTests, BorrowOutlivingOwnerDefersDestruction) {
+    sptr::owned_ptr<Resource> owner(new Derived(3));
+    auto obs = owner.observe();
+    {
+        auto b = obs.lock();
+        owner.reset();
+        // The borrow keeps the object until it ends
+        EXPECT_FALSE(obs.expired());
+        EXPECT_EQ(Resource::destroyed, 0);
+        EXPECT_EQ(b->value, 3);
+    }
+    EXPECT_EQ(Resource::destroyed, 1);
+    EXPECT_TRUE(obs.expired());
+}
+
+TEST_F(OwnedPtrTests, ConvertingMove) {
+    sptr::owned_ptr<Derived> d(new Derived(9));
+    sptr::owned_ptr<Resource> base(std::move(d));
+    EXPECT_EQ(base->value, 9);
+    base.reset();
+    EXPECT_EQ(Resource::destroyed, 1);
+}
+
+TEST_F(OwnedPtrTests, EmptyObserver) {
+    sptr::observer_ref<Resource> obs;
+    EXPECT_TRUE(obs.expired());
+    EXPECT_FALSE(obs.lock());
+}
+
+TEST_F(OwnedPtrTests, ConcurrentLockAndRelease) {
+    for (int round = 0; round < 200; ++round) {
+        auto owner = sptr::make_owned<Resource>(round);
+        auto obs = owner.observe();
+        std::thread releaser([&] { owner.reset(); });
+        while (auto b = obs.lock()) {
+            EXPECT_EQ(b->value, round);
+        }
+        releaser.join();
+    }
+    EXPECT_EQ(Resource::destroyed, 200);
+}
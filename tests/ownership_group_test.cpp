@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ownership_group.hpp"
+#include "weak_ptr.hpp"
+
+namespace {
+
+struct Node {
+    explicit Node(int v) : value(v) {}
+    ~Node() {
+        destroyed++;
+        order.push_back(value);
+    }
+
+    int value;
+    std::vector<Node*> children;
+
+    static int destroyed;
+    static std::vector<int> order;
+    static void reset() {
+        destroyed = 0;
+        order.clear();
+    }
+};
+
+int Node::destroyed = 0;
+std::vector<int> Node::order;
+
+} // namespace
+
+class OwnershipGroupTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Node::reset();
+    }
+};
+
+TEST_F(OwnershipGroupTests, MembersDieTogether) {
+    sptr::group_ptr<Node> root;
+    {
+        sptr::ownership_group group;
+        root = group.make<Node>(0);
+        for (int i = 1; i <= 100; ++i) {
+            root->children.push_back(group.create<Node>(i));
+        }
+        EXPECT_EQ(group.objects(), 101u);
+        EXPECT_EQ(group.use_count(), 2);
+    }
+    // The group handle is gone but root still owns everything
+    EXPECT_EQ(Node::destroyed, 0);
+    EXPECT_EQ(root->children[99]->value, 100);
+    root.reset();
+    EXPECT_EQ(Node::destroyed, 101);
+    // Destroyed in reverse creation order
+    EXPECT_EQ(Node::order.front(), 100);
+    EXPECT_EQ(Node::order.back(), 0);
+}
+
+TEST_F(OwnershipGroupTests, CopiesShareOneCount) {
+    sptr::ownership_group group;
+    auto a = group.make<Node>(1);
+    auto b = group.make<Node>(2);
+    EXPECT_EQ(a.use_count(), 3);
+    auto c = a;
+    EXPECT_EQ(b.use_count(), 4);
+    EXPECT_EQ(group.share(b.get()).use_count(), 5);
+    EXPECT_EQ(group.use_count(), 4);
+}
+
+TEST_F(OwnershipGroupTests, ConvertsToAliasingSharedPtr) {
+    sptr::shared_ptr<Node> shared;
+    sptr::weak_ptr<Node> weak;
+    {
+        sptr::ownership_group group;
+        auto node = group.make<Node>(7);
+        shared = node;
+        weak = shared;
+        EXPECT_EQ(shared.get(), node.get());
+        EXPECT_EQ(shared.use_count(), 3);
+    }
+    EXPECT_EQ(shared->value, 7);
+    EXPECT_FALSE(weak.expired());
+    shared.reset();
+    EXPECT_TRUE(weak.expired());
+    EXPECT_EQ(Node::destroyed, 1);
+}
+
+TEST_F(OwnershipGroupTests, LargeAndAlignedObjects) {
+    struct alignas(64) Wide {
+        char bytes[64];
+    };
+    sptr::ownership_group group;
+    auto big = group.make<std::vector<char>>(1000, 'x');
+    for (int i = 0; i < 2000; ++i) {
+        Wide* w = group.create<Wide>();
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(w) % 64, 0u);
+    }
+    auto text = group.make<std::string>(200000, 'y');
+    EXPECT_EQ(text->size(), 200000u);
+    EXPECT_GT(group.bytes_reserved(), 2000u * 64u);
+    EXPECT_EQ((*big)[999], 'x');
+}
+
+TEST_F(OwnershipGroupTests, MovedFromGroupStartsOver) {
+    sptr::ownership_group first;
+    auto a = first.make<Node>(1);
+    sptr::ownership_group second(std::move(first));
+    EXPECT_EQ(first.objects(), 0u);
+    EXPECT_EQ(first.use_count(), 0);
+    EXPECT_FALSE(first.share(a.get()));
+
+    auto b = first.make<Node>(2);
+    EXPECT_EQ(first.objects(), 1u);
+    EXPECT_EQ(second.objects(), 1u);
+    // Two separate regions, each owned by its handle and one group_ptr
+    EXPECT_EQ(a.use_count(), 2);
+    EXPECT_EQ(b.use_count(), 2);
+    b.reset();
+    first = sptr::ownership_group();
+    EXPECT_EQ(Node::destroyed, 1);
+}
@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include "persistent_heap.hpp"
+
+struct GraphNode {
+    int value;
+    sptr::offset_ptr<const GraphNode> left;
+    sptr::offset_ptr<const GraphNode> right;
+
+    GraphNode(int v, const GraphNode* l = nullptr, const GraphNode* r = nullptr)
+        : value(v), left(l), right(r) {}
+};
+
+class PersistentHeapTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path = ::testing::TempDir() + "sptr_persistent_heap_test.bin";
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+
+    // Diamond: root -> {a, b}, both a and b -> shared
+    void build_and_save(std::uint64_t schema = 3) {
+        sptr::persistent_heap heap(4096, schema);
+        auto* shared = heap.construct<GraphNode>(7);
+        auto* a = heap.construct<GraphNode>(1, shared);
+        auto* b = heap.construct<GraphNode>(2, nullptr, shared);
+        auto* root = heap.construct<GraphNode>(0, a, b);
+        heap.set_root(root);
+        heap.save(path);
+    }
+
+    std::string path;
+};
+
+TEST_F(PersistentHeapTests, OffsetPtrSurvivesCopy) {
+    int values[2] = {10, 20};
+    sptr::offset_ptr<int> p(&values[1]);
+    sptr::offset_ptr<int> q(p);
+    EXPECT_EQ(q.get(), &values[1]);
+    EXPECT_EQ(*q, 20);
+
+    sptr::offset_ptr<int> null;
+    EXPECT_FALSE(null);
+    EXPECT_EQ(null.get(), nullptr);
+}
+
+TEST_F(PersistentHeapTests, RoundTripPreservesGraph) {
+    build_and_save();
+    auto heap = sptr::persistent_heap::open(path, 3);
+    EXPECT_TRUE(heap.read_only());
+    EXPECT_EQ(heap.schema_version(), 3u);
+
+    const GraphNode* root = heap.root<GraphNode>();
+    ASSERT_NE(root, nullptr);
+    EXPECT_EQ(root->value, 0);
+    EXPECT_EQ(root->left->value, 1);
+    EXPECT_EQ(root->right->value, 2);
+    // Sharing is structural: both edges land on the same bytes
+    EXPECT_EQ(root->left->left.get(), root->right->right.get());
+    EXPECT_EQ(root->left->left->value, 7);
+    EXPECT_TRUE(heap.contains(root->left.get(), sizeof(GraphNode)));
+}
+
+TEST_F(PersistentHeapTests, SharedPtrsNeedNoControlBlock) {
+    build_and_save();
+    auto heap = sptr::persistent_heap::open(path, 3);
+
+    auto root = heap.root_shared<GraphNode>();
+    ASSERT_TRUE(root);
+    EXPECT_EQ(sptr::detail::shared_access::control(root), nullptr);
+    {
+        auto child = heap.share(root->left.get());
+        auto copy = child;
+        EXPECT_EQ(copy->value, 1);
+        // Copies touch no count
+        EXPECT_EQ(copy.use_count(), 0);
+    }
+    root.reset();
+    EXPECT_EQ(heap.root<GraphNode>()->value, 0);
+    EXPECT_EQ(heap.root_shared<GraphNode>()->value, 0);
+}
+
+TEST_F(PersistentHeapTests, RejectsSchemaMismatch) {
+    build_and_save(3);
+    EXPECT_THROW(sptr::persistent_heap::open(path, 4), sptr::persistent_heap_error);
+}
+
+TEST_F(PersistentHeapTests, RejectsCorruption) {
+    build_and_save();
+    {
+        std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(100);
+        f.put('\x5a');
+    }
+    EXPECT_THROW(sptr::persistent_heap::open(path, 3), sptr::persistent_heap_error);
+    // Structural checks still run without the checksum
+    EXPECT_NO_THROW(sptr::persistent_heap::open(path, 3, false));
+}
+
+TEST_F(PersistentHeapTests, RejectsTruncation) {
+    build_and_save();
+    {
+        std::ofstream f(path, std::ios::binary | std::ios::trunc);
+        f << "short";
+    }
+    EXPECT_THROW(sptr::persistent_heap::open(path, 3), sptr::persistent_heap_error);
+}
+
+TEST_F(PersistentHeapTests, ReadOnlyAndBounds) {
+    build_and_save();
+    auto heap = sptr::persistent_heap::open(path, 3);
+    EXPECT_THROW(heap.construct<GraphNode>(1), sptr::persistent_heap_error);
+
+    GraphNode outside(5);
+    EXPECT_FALSE(heap.contains(&outside));
+    EXPECT_THROW(heap.share(&outside), sptr::persistent_heap_error);
+}
+
+TEST_F(PersistentHeapTests, CapacityIsEnforced) {
+    sptr::persistent_heap heap(64);
+    EXPECT_THROW({
+        for (int i = 0; i < 1000; ++i) heap.construct<GraphNode>(i);
+    }, std::bad_alloc);
+}
+
+namespace {
+
+// root_offset follows magic, versions, header size and used
+constexpr std::streamoff root_offset_field = 32;
+
+std::int64_t read_at(const std::string& path, std::streamoff at) {
+    std::int64_t value = 0;
+    std::ifstream f(path, std::ios::binary);
+    f.seekg(at);
+    f.read(reinterpret_cast<char*>(&value), sizeof(value));
+    return value;
+}
+
+// Overwrites bytes of a saved heap in place
+void patch(const std::string& path, std::streamoff at, std::int64_t value) {
+    std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+    f.seekp(at);
+    f.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+} // namespace
+
+TEST_F(PersistentHeapTests, RootMustFitInsideTheHeap) {
+    build_and_save();
+    std::int64_t used = read_at(path, 24);
+    // Inside the heap, but a GraphNode there would run past its end. The
+    // header is not checksummed, so only the bounds check catches this.
+    patch(path, root_offset_field, used - 8);
+    auto heap = sptr::persistent_heap::open(path, 3);
+    EXPECT_THROW(heap.root<GraphNode>(), sptr::persistent_heap_error);
+    EXPECT_THROW(heap.root_shared<GraphNode>(), sptr::persistent_heap_error);
+}
+
+TEST_F(PersistentHeapTests, CheckedRejectsWildOffsets) {
+    build_and_save();
+    {
+        auto heap = sptr::persistent_heap::open(path, 3);
+        const GraphNode* root = heap.root<GraphNode>();
+        EXPECT_EQ(heap.checked(root->left)->value, 1);
+        EXPECT_EQ(heap.checked(root->left->right), nullptr);
+    }
+    std::int64_t left = read_at(path, root_offset_field) + offsetof(GraphNode, left);
+    patch(path, left, std::int64_t(1) << 40);
+    auto heap = sptr::persistent_heap::open(path, 3, false);
+    EXPECT_THROW(heap.checked(heap.root<GraphNode>()->left), sptr::persistent_heap_error);
+}
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <thread>
+#include <vector>
+#include "pool_alloc.hpp"
+#include "weak_ptr.hpp"
+
+class Resource {
+public:
+    Resource() : m_id(next_id++) {}
+    Resource(int value) : m_id(next_id++), m_value(value) {}
+    ~Resource() { destroyed++; }
+
+    int id() const { return m_id; }
+    int value() const { return m_value; }
+
+    static void reset() { next_id = 0; destroyed = 0; }
+    static std::atomic<int> destroyed;
+
+private:
+    int m_id;
+    int m_value = 0;
+    static std::atomic<int> next_id;
+};
+
+std::atomic<int> Resource::next_id{0};
+std::atomic<int> Resource::destroyed{0};
+
+class PoolAllocTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Resource::reset();
+    }
+};
+
+TEST_F(PoolAllocTests, MakeSharedPooled) {
+    {
+        auto ptr = sptr::make_shared_pooled<Resource>(42);
+        EXPECT_EQ(ptr->value(), 42);
+        EXPECT_EQ(ptr.use_count(), 1);
+
+        sptr::weak_ptr<Resource> weak = ptr;
+        ptr.reset();
+        EXPECT_TRUE(weak.expired());
+    }
+    EXPECT_EQ(Resource::destroyed, 1);
+}
+
+TEST_F(PoolAllocTests, LocalFreeIsReused) {
+    auto before = sptr::pool_counters();
+    void* first = sptr::detail::pool_allocate(40, 8);
+    sptr::detail::pool_deallocate(first, 40, 8);
+    void* second = sptr::detail::pool_allocate(40, 8);
+    EXPECT_EQ(first, second);
+    sptr::detail::pool_deallocate(second, 40, 8);
+
+    auto after = sptr::pool_counters();
+    EXPECT_EQ(after.local_frees - before.local_frees, 2u);
+    EXPECT_EQ(after.remote_frees, before.remote_frees);
+}
+
+TEST_F(PoolAllocTests, RemoteFreesAreBatchedAndDrained) {
+    constexpr int count = 200;
+    std::vector<sptr::shared_ptr<Resource>> ptrs;
+    for (int i = 0; i < count; ++i) {
+        ptrs.push_back(sptr::make_shared_pooled<Resource>(i));
+    }
+    auto before = sptr::pool_counters();
+
+    std::thread consumer([&] {
+        ptrs.clear();
+        sptr::flush_remote_frees();
+    });
+    consumer.join();
+    EXPECT_EQ(Resource::destroyed, count);
+
+    auto after = sptr::pool_counters();
+    EXPECT_EQ(after.remote_frees - before.remote_frees, static_cast<std::size_t>(count));
+    // One CAS per batch of up to 64 blocks, not one per block
+    EXPECT_LE(after.remote_batches - before.remote_batches, 4u);
+
+    // The owner reclaims the returned blocks on its next allocations
+    std::vector<sptr::shared_ptr<Resource>> again;
+    for (int i = 0; i < count; ++i) {
+        again.push_back(sptr::make_shared_pooled<Resource>(i));
+    }
+    EXPECT_EQ(sptr::pool_counters().drained - before.drained, static_cast<std::size_t>(count));
+}
+
+TEST_F(PoolAllocTests, HeapOutlivesOwningThread) {
+    sptr::shared_ptr<Resource> ptr;
+    std::thread producer([&] {
+        ptr = sptr::make_shared_pooled<Resource>(7);
+    });
+    producer.join();
+
+    EXPECT_EQ(ptr->value(), 7);
+    ptr.reset();
+    EXPECT_EQ(Resource::destroyed, 1);
+}
+
+TEST_F(PoolAllocTests, LargeAndOverAlignedFallBack) {
+    void* big = sptr::detail::pool_allocate(4096, 8);
+    sptr::detail::pool_deallocate(big, 4096, 8);
+
+    void* aligned = sptr::detail::pool_allocate(64, 64);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(aligned) % 64, 0u);
+    sptr::detail::pool_deallocate(aligned, 64, 64);
+}
+
+TEST_F(PoolAllocTests, EmptyPagesGoBackToTheSystem) {
+    std::thread owner([] {
+        auto before = sptr::pool_counters();
+        std::vector<sptr::shared_ptr<Resource>> ptrs;
+        for (int i = 0; i < 20000; ++i) {
+            ptrs.push_back(sptr::make_shared_pooled<Resource>(i));
+        }
+        EXPECT_GT(sptr::pool_counters().pages - before.pages, 4u);
+        ptrs.clear();
+        // Only the page still being allocated from is kept
+        EXPECT_LE(sptr::pool_counters().pages - before.pages, 1u);
+    });
+    owner.join();
+}
+
+TEST_F(PoolAllocTests, RejectsOverflowingCounts) {
+    sptr::pool_allocator<std::uint64_t> alloc;
+    EXPECT_THROW(alloc.allocate(SIZE_MAX / 4), std::bad_alloc);
+}
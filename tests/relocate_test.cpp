@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+#include <new>
+#include <string>
+#include "persistent_heap.hpp"
+#include "relocate.hpp"
+#include "shared_ptr.hpp"
+#include "unique_array.hpp"
+#include "unique_ptr.hpp"
+#include "weak_ptr.hpp"
+
+namespace {
+
+class Resource {
+public:
+    explicit Resource(int v = 0) : value(v) {}
+    ~Resource() { destroyed++; }
+
+    int value;
+
+    static int destroyed;
+    static void reset() { destroyed = 0; }
+};
+
+int Resource::destroyed = 0;
+
+struct StatefulDeleter {
+    StatefulDeleter() = default;
+    StatefulDeleter(const StatefulDeleter&) {}
+    void operator()(Resource* p) const { delete p; }
+};
+
+} // namespace
+
+class RelocateTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Resource::reset();
+    }
+};
+
+TEST_F(RelocateTests, TraitCoversSmartPointers) {
+    static_assert(sptr::is_trivially_relocatable_v<sptr::shared_ptr<Resource>>, "");
+    static_assert(sptr::is_trivially_relocatable_v<sptr::weak_ptr<Resource>>, "");
+    static_assert(sptr::is_trivially_relocatable_v<sptr::unique_ptr<Resource>>, "");
+    static_assert(sptr::is_trivially_relocatable_v<sptr::unique_ptr<Resource[]>>, "");
+    static_assert(sptr::is_trivially_relocatable_v<sptr::unique_array<float>>, "");
+    static_assert(sptr::is_trivially_relocatable_v<int>, "");
+    static_assert(!sptr::is_trivially_relocatable_v<sptr::unique_ptr<Resource, StatefulDeleter>>, "");
+    static_assert(!sptr::is_trivially_relocatable_v<sptr::offset_ptr<int>>, "");
+    static_assert(!sptr::is_trivially_relocatable_v<std::string>, "");
+}
+
+TEST_F(RelocateTests, RelocateKeepsCountsUnchanged) {
+    auto p = sptr::make_shared<Resource>(7);
+    alignas(sptr::shared_ptr<Resource>) unsigned char src[2 * sizeof(sptr::shared_ptr<Resource>)];
+    alignas(sptr::shared_ptr<Resource>) unsigned char dst[2 * sizeof(sptr::shared_ptr<Resource>)];
+    auto* s = reinterpret_cast<sptr::shared_ptr<Resource>*>(src);
+    auto* d = reinterpret_cast<sptr::shared_ptr<Resource>*>(dst);
+    new(s) sptr::shared_ptr<Resource>(p);
+    new(s + 1) sptr::shared_ptr<Resource>(p);
+    EXPECT_EQ(p.use_count(), 3);
+
+    EXPECT_EQ(sptr::uninitialized_relocate(s, s + 2, d), d + 2);
+    EXPECT_EQ(p.use_count(), 3);
+    EXPECT_EQ(d[1]->value, 7);
+
+    d[0].~shared_ptr();
+    d[1].~shared_ptr();
+    EXPECT_EQ(p.use_count(), 1);
+}
+
+TEST_F(RelocateTests, RelocateNonTrivialType) {
+    alignas(std::string) unsigned char src[sizeof(std::string)];
+    alignas(std::string) unsigned char dst[sizeof(std::string)];
+    auto* s = new(src) std::string("a long string that is not stored inline");
+    auto* d = reinterpret_cast<std::string*>(dst);
+
+    EXPECT_EQ(sptr::relocate_at(s, d), d);
+    EXPECT_EQ(*d, "a long string that is not stored inline");
+    d->~basic_string();
+}
+
+TEST_F(RelocateTests, VectorGrowthPreservesElements) {
+    auto shared = sptr::make_shared<Resource>(1);
+    {
+        sptr::relocating_vector<sptr::shared_ptr<Resource>> v;
+        for (int i = 0; i < 1000; ++i) {
+            v.push_back(shared);
+        }
+        EXPECT_EQ(v.size(), 1000u);
+        EXPECT_GE(v.capacity(), 1000u);
+        EXPECT_EQ(shared.use_count(), 1001);
+        for (auto& p : v) {
+            EXPECT_EQ(p.get(), shared.get());
+        }
+    }
+    EXPECT_EQ(shared.use_count(), 1);
+}
+
+TEST_F(RelocateTests, VectorEraseDestroysAndCloses) {
+    sptr::relocating_vector<sptr::unique_ptr<Resource>> v;
+    for (int i = 0; i < 10; ++i) {
+        v.emplace_back(new Resource(i));
+    }
+    auto it = v.erase(v.begin() + 2, v.begin() + 5);
+    EXPECT_EQ(Resource::destroyed, 3);
+    EXPECT_EQ((*it)->value, 5);
+    ASSERT_EQ(v.size(), 7u);
+    int expected[] = {0, 1, 5, 6, 7, 8, 9};
+    for (std::size_t i = 0; i < v.size(); ++i) {
+        EXPECT_EQ(v[i]->value, expected[i]);
+    }
+
+    v.erase(v.begin());
+    v.pop_back();
+    EXPECT_EQ(Resource::destroyed, 5);
+    EXPECT_EQ(v.size(), 5u);
+    v.clear();
+    EXPECT_EQ(Resource::destroyed, 10);
+}
+
+TEST_F(RelocateTests, VectorOfNonTrivialType) {
+    sptr::relocating_vector<std::string> v;
+    for (int i = 0; i < 100; ++i) {
+        v.push_back(std::string(40, static_cast<char>('a' + i % 26)));
+    }
+    v.erase(v.begin());
+    EXPECT_EQ(v.size(), 99u);
+    EXPECT_EQ(v[0], std::string(40, 'b'));
+}
+
+TEST_F(RelocateTests, EmplaceBackFromOwnElementDuringGrowth) {
+    sptr::relocating_vector<sptr::shared_ptr<Resource>> v;
+    v.push_back(sptr::make_shared<Resource>(3));
+    while (v.size() < v.capacity()) {
+        v.push_back(v[0]);
+    }
+    v.push_back(v[0]);
+    EXPECT_EQ(v.back()->value, 3);
+    EXPECT_EQ(v[0].use_count(), static_cast<long>(v.size()));
+}
+
+TEST_F(RelocateTests, VectorRejectsOverflowingCapacity) {
+    sptr::relocating_vector<sptr::shared_ptr<int>> v;
+    v.push_back(sptr::make_shared<int>(1));
+    // capacity * sizeof(T) would wrap to a tiny realloc
+    EXPECT_THROW(v.reserve(v.max_size() + 1), std::bad_alloc);
+    EXPECT_EQ(v.size(), 1u);
+    EXPECT_EQ(*v[0], 1);
+}
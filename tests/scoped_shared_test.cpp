@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "scoped_shared.hpp"
+
+namespace {
+
+class Resource {
+public:
+    explicit Resource(int v = 0) : value(v) {}
+    ~Resource() { destroyed++; }
+
+    int value;
+
+    static std::atomic<int> destroyed;
+    static void reset() { destroyed = 0; }
+};
+
+std::atomic<int> Resource::destroyed{0};
+
+int read_value(sptr::shared_ptr<Resource> p) {
+    return p->value;
+}
+
+} // namespace
+
+class ScopedSharedTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Resource::reset();
+    }
+};
+
+TEST_F(ScopedSharedTests, HandsOutOrdinarySharedPtrs) {
+    {
+        sptr::scoped_shared<Resource> scope(42);
+        EXPECT_EQ(scope.use_count(), 1);
+        auto p = scope.share();
+        EXPECT_EQ(p.get(), scope.get());
+        EXPECT_EQ(scope.use_count(), 2);
+        EXPECT_EQ(read_value(p), 42);
+        // The object lives inside the scope object itself
+        auto* addr = reinterpret_cast<const char*>(p.get());
+        auto* base = reinterpret_cast<const char*>(&scope);
+        EXPECT_GE(addr, base);
+        EXPECT_LT(addr, base + sizeof(scope));
+    }
+    EXPECT_EQ(Resource::destroyed, 1);
+}
+
+TEST_F(ScopedSharedTests, ForkJoinWaitsForWorkers) {
+    std::atomic<int> sum{0};
+    std::vector<std::thread> workers;
+    {
+        sptr::scoped_shared<Resource> scope(3);
+        for (int i = 0; i < 4; ++i) {
+            workers.emplace_back([&sum, p = scope.share()]() mutable {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                sum += p->value;
+                p.reset();
+            });
+        }
+        // Leaving the scope blocks until every worker dropped its copy
+    }
+    EXPECT_EQ(sum, 12);
+    EXPECT_EQ(Resource::destroyed, 1);
+    for (auto& t : workers) t.join();
+}
+
+TEST_F(ScopedSharedTests, FrameMayEndWhileAWorkerIsStillReleasing) {
+    // The worker's wake-up can run after the scope saw the count drop and
+    // returned; it must not read the block inside the dead frame
+    std::vector<std::thread> workers;
+    for (int round = 0; round < 2000; ++round) {
+        {
+            sptr::scoped_shared<Resource> scope(round);
+            workers.emplace_back([p = scope.share()]() mutable { p.reset(); });
+        }
+        workers.back().join();
+    }
+    EXPECT_EQ(Resource::destroyed, 2000);
+}
+
+TEST_F(ScopedSharedTests, WaitsForWeakReferences) {
+    std::thread observer;
+    std::atomic<bool> saw_expired{false};
+    {
+        sptr::scoped_shared<Resource> scope(1);
+        observer = std::thread([&saw_expired, w = scope.weak()]() mutable {
+            while (!w.expired()) std::this_thread::yield();
+            saw_expired = true;
+            w.reset();
+        });
+    }
+    EXPECT_TRUE(saw_expired);
+    observer.join();
+}
+
+TEST_F(ScopedSharedTests, AbortPolicyCatchesLeakedReference) {
+    using strict_scope = sptr::scoped_shared<Resource, sptr::scope_exit::abort>;
+    EXPECT_DEATH({
+        // Never destroyed: the scope must abort before anything could
+        // touch its frame through the leaked reference
+        auto* leaked = new sptr::shared_ptr<Resource>();
+        strict_scope scope(1);
+        *leaked = scope.share();
+    }, "scoped_shared left its scope");
+}
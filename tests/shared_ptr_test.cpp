@@ -1,4 +1,10 @@
 #include <gtest/gtest.h>
+#include <chrono>
+#include <cstdint>
+#include <new>
+#include <thread>
+#include <vector>
+#include "oom_policy.hpp"
 #include "shared_ptr.hpp"
 #include "weak_ptr.hpp"
 
@@ -149,6 +155,43 @@ TEST_F(SharedPointerTests, MakeShared) {
     EXPECT_EQ(ptr.use_count(), 1);
 }
 
+TEST_F(SharedPointerTests, MakeSharedArray) {
+    {
+        auto arr = sptr::make_shared<Resource[]>(4);
+        EXPECT_TRUE(arr);
+        EXPECT_EQ(arr.use_count(), 1);
+        EXPECT_EQ(arr[0].id(), 0);
+        EXPECT_EQ(arr[3].id(), 3);
+        
+        auto copy = arr;
+        EXPECT_EQ(arr.use_count(), 2);
+        EXPECT_EQ(Resource::destroyed, 0);
+    }
+    EXPECT_EQ(Resource::destroyed, 4);
+    
+    auto ints = sptr::make_shared<int[]>(8);
+    EXPECT_EQ(ints[7], 0);
+}
+
+TEST_F(SharedPointerTests, AliasingConstructor) {
+    struct Pair {
+        Resource first;
+        Resource second;
+    };
+    
+    sptr::shared_ptr<Resource> second;
+    {
+        auto pair = sptr::make_shared<Pair>();
+        second = sptr::shared_ptr<Resource>(pair, &pair->second);
+        EXPECT_EQ(pair.use_count(), 2);
+        EXPECT_EQ(second->id(), 1);
+    }
+    // The alias keeps the whole Pair alive
+    EXPECT_EQ(Resource::destroyed, 0);
+    second.reset();
+    EXPECT_EQ(Resource::destroyed, 2);
+}
+
 // Test for circular references
 class Node {
 public:
@@ -279,6 +322,83 @@ TEST_F(SharedPointerTests, WeakPtrBreakingCircularReference) {
     // because weak_ptrs don't prevent destruction
 }
 
+TEST_F(SharedPointerTests, WaitUntilUnique) {
+    sptr::shared_ptr<Resource> ptr(new Resource(1));
+    EXPECT_TRUE(ptr.wait_until_unique(std::chrono::milliseconds(0)));
+
+    auto other = ptr;
+    EXPECT_FALSE(ptr.wait_until_unique(std::chrono::milliseconds(20)));
+
+    std::thread holder([copy = std::move(other)]() mutable {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        copy.reset();
+    });
+    EXPECT_TRUE(ptr.wait_until_unique(std::chrono::seconds(10)));
+    EXPECT_EQ(ptr.use_count(), 1);
+    holder.join();
+
+    // The waiters bit never leaks into the visible count
+    auto again = ptr;
+    EXPECT_EQ(ptr.use_count(), 2);
+}
+
+TEST_F(SharedPointerTests, WaitUntilUniqueManyHolders) {
+    sptr::shared_ptr<Resource> ptr(new Resource(1));
+    std::vector<std::thread> holders;
+    for (int i = 0; i < 8; ++i) {
+        holders.emplace_back([copy = ptr]() mutable {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            copy.reset();
+        });
+    }
+    EXPECT_TRUE(ptr.wait_until_unique());
+    EXPECT_EQ(ptr.use_count(), 1);
+    for (auto& t : holders) t.join();
+}
+
+TEST_F(SharedPointerTests, WaiterMayFreeTheBlockRightAfterTheLastDrop) {
+    // The dropping thread's wake-up must not touch the block: the waiter can
+    // see the count fall, release the last reference and free it first
+    for (int round = 0; round < 2000; ++round) {
+        auto ptr = sptr::make_shared<Resource>(round);
+        std::thread dropper([copy = ptr]() mutable { copy.reset(); });
+        EXPECT_TRUE(ptr.wait_until_unique());
+        ptr.reset();
+        dropper.join();
+    }
+}
+
+namespace {
+    std::size_t oom_bytes = 0;
+
+    void record_oom(std::size_t bytes) {
+        oom_bytes = bytes;
+    }
+}
+
+TEST_F(SharedPointerTests, AllocationFailureRunsHandlerThenThrows) {
+    oom_bytes = 0;
+    sptr::set_oom_handler(&record_oom);
+    EXPECT_THROW(sptr::make_shared<char[]>(SIZE_MAX / 4), std::bad_alloc);
+    EXPECT_GE(oom_bytes, SIZE_MAX / 4);
+    // Too large to even size up
+    EXPECT_THROW(sptr::make_shared<long[]>(SIZE_MAX / 2), std::bad_alloc);
+    EXPECT_EQ(oom_bytes, SIZE_MAX);
+    sptr::set_oom_handler(nullptr);
+}
+
+TEST_F(SharedPointerTests, TryMakeSharedReturnsEmpty) {
+    static_assert(noexcept(sptr::try_make_shared<int>(1)));
+    static_assert(!noexcept(sptr::try_make_shared<Resource>()));
+    EXPECT_FALSE(sptr::try_make_shared<char[]>(SIZE_MAX / 4));
+    auto ptr = sptr::try_make_shared<Resource>(7);
+    ASSERT_TRUE(ptr);
+    EXPECT_EQ(ptr->value(), 7);
+    auto arr = sptr::try_make_shared<int[]>(3);
+    ASSERT_TRUE(arr);
+    EXPECT_EQ(arr[2], 0);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
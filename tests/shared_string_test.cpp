@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "oom_policy.hpp"
+#include "relocate.hpp"
+#include "shared_string.hpp"
+
+namespace {
+
+const std::string long_text = "the quick brown fox jumps over the lazy dog";
+
+} // namespace
+
+TEST(SharedStringTests, ShortStringsStayInline) {
+    sptr::shared_string s("hello");
+    EXPECT_EQ(s.size(), 5u);
+    EXPECT_EQ(s.view(), "hello");
+    EXPECT_EQ(s.use_count(), 0);
+    auto* addr = reinterpret_cast<const char*>(s.data());
+    auto* base = reinterpret_cast<const char*>(&s);
+    EXPECT_GE(addr, base);
+    EXPECT_LT(addr, base + sizeof(s));
+
+    sptr::shared_string edge(std::string(sptr::shared_string::inline_capacity, 'x'));
+    EXPECT_EQ(edge.use_count(), 0);
+    sptr::shared_string empty;
+    EXPECT_TRUE(empty.empty());
+    EXPECT_EQ(empty.view(), "");
+}
+
+TEST(SharedStringTests, CopiesShareLongStorage) {
+    sptr::shared_string a(long_text);
+    EXPECT_EQ(a.use_count(), 1);
+    sptr::shared_string b = a;
+    EXPECT_EQ(a.use_count(), 2);
+    EXPECT_EQ(a.data(), b.data());
+    EXPECT_EQ(b.view(), long_text);
+    {
+        sptr::shared_string c(b);
+        EXPECT_EQ(a.use_count(), 3);
+    }
+    EXPECT_EQ(a.use_count(), 2);
+
+    sptr::shared_string moved(std::move(b));
+    EXPECT_EQ(a.use_count(), 2);
+    EXPECT_TRUE(b.empty());
+    EXPECT_EQ(moved, a);
+}
+
+TEST(SharedStringTests, FitsInThreeWords) {
+    EXPECT_EQ(sizeof(sptr::shared_string), 3 * sizeof(void*));
+    EXPECT_TRUE(sptr::is_trivially_relocatable_v<sptr::shared_string>);
+}
+
+TEST(SharedStringTests, SubstringsShareStorage) {
+    sptr::shared_string s(long_text);
+    sptr::shared_string tail = s.substr(4);
+    EXPECT_EQ(tail.view(), long_text.substr(4));
+    EXPECT_EQ(tail.data(), s.data() + 4);
+    EXPECT_EQ(s.use_count(), 2);
+
+    // Short pieces are copied inline instead
+    sptr::shared_string word = s.substr(4, 5);
+    EXPECT_EQ(word, "quick");
+    EXPECT_EQ(word.use_count(), 0);
+    EXPECT_EQ(s.use_count(), 2);
+
+    // The substring keeps the allocation alive on its own
+    s = sptr::shared_string();
+    EXPECT_EQ(tail.use_count(), 1);
+    EXPECT_EQ(tail.view(), long_text.substr(4));
+
+    EXPECT_THROW(tail.substr(tail.size() + 1), std::out_of_range);
+}
+
+TEST(SharedStringTests, HashMatchesStringView) {
+    sptr::shared_string s(long_text);
+    std::size_t expected = std::hash<std::string_view>()(long_text);
+    EXPECT_EQ(s.hash(), expected);
+    EXPECT_EQ(s.hash(), expected);
+    EXPECT_EQ(s.substr(4).hash(), std::hash<std::string_view>()(long_text.substr(4)));
+    EXPECT_EQ(sptr::shared_string("dog").hash(), std::hash<std::string_view>()("dog"));
+
+    std::unordered_set<sptr::shared_string> set;
+    set.insert(s);
+    set.insert(sptr::shared_string("dog"));
+    EXPECT_EQ(set.count(sptr::shared_string(long_text)), 1u);
+    EXPECT_EQ(set.count(s.substr(long_text.size() - 3)), 1u);
+}
+
+TEST(SharedStringTests, ComparesAndConverts) {
+    sptr::shared_string a("apple");
+    sptr::shared_string b(long_text);
+    EXPECT_TRUE(a < b);
+    EXPECT_NE(a, b);
+    EXPECT_EQ(b, sptr::shared_string(long_text));
+
+    std::string_view v = b;
+    EXPECT_EQ(v, long_text);
+    EXPECT_EQ(b.str(), long_text);
+    EXPECT_EQ(std::string(b.begin(), b.end()), long_text);
+    EXPECT_EQ(b[4], 'q');
+
+    std::ostringstream os;
+    os << a;
+    EXPECT_EQ(os.str(), "apple");
+}
+
+TEST(SharedStringTests, AssignmentReleasesOldStorage) {
+    sptr::shared_string a(long_text);
+    sptr::shared_string b(long_text + "!");
+    sptr::shared_string keep = b;
+    EXPECT_EQ(keep.use_count(), 2);
+    b = a;
+    EXPECT_EQ(keep.use_count(), 1);
+    EXPECT_EQ(a.use_count(), 2);
+    b = "short";
+    EXPECT_EQ(a.use_count(), 1);
+    EXPECT_EQ(b, "short");
+}
+
+namespace {
+
+int oom_calls = 0;
+
+void counting_handler(std::size_t) {
+    ++oom_calls;
+}
+
+} // namespace
+
+TEST(SharedStringTests, AllocationFailureFollowsTheOomPolicy) {
+    // Only the length is looked at before the allocation fails
+    static const char text[] = "x";
+    sptr::set_oom_handler(&counting_handler);
+    oom_calls = 0;
+    EXPECT_THROW(sptr::shared_string(std::string_view(text, SIZE_MAX / 2)), std::bad_alloc);
+    EXPECT_THROW(sptr::shared_string(std::string_view(text, SIZE_MAX - 8)), std::bad_alloc);
+    EXPECT_EQ(oom_calls, 2);
+    sptr::set_oom_handler(nullptr);
+}
+
+TEST(SharedStringTests, ConcurrentCopies) {
+    sptr::shared_string s(long_text);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([s] {
+            for (int i = 0; i < 10000; ++i) {
+                sptr::shared_string copy = s;
+                sptr::shared_string part = copy.substr(i % 8);
+                EXPECT_EQ(part.size(), long_text.size() - static_cast<std::size_t>(i % 8));
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(s.use_count(), 1);
+}
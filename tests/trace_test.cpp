@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "shared_ptr.hpp"
+#include "trace.hpp"
+#include "weak_ptr.hpp"
+
+namespace {
+
+std::string temp_path(const char* name) {
+    return ::testing::TempDir() + name;
+}
+
+void write_file(const std::string& path, const void* data, std::size_t size) {
+    FILE* f = std::fopen(path.c_str(), "wb");
+    ASSERT_NE(f, nullptr);
+    std::fwrite(data, 1, size, f);
+    std::fclose(f);
+}
+
+sptr::trace_record record(std::uint64_t ts, sptr::trace_op op, std::uint64_t block) {
+    sptr::trace_record r = {};
+    r.timestamp_ns = ts;
+    r.op = op;
+    r.block = block;
+    return r;
+}
+
+} // namespace
+
+TEST(TraceTests, LoadSortsBuffersByTimestamp) {
+    // Two thread buffers, written one after the other
+    std::vector<unsigned char> bytes(sizeof(sptr::trace_header));
+    sptr::trace_header header = {};
+    std::memcpy(header.magic, "SPTRTRC1", 8);
+    header.record_size = sizeof(sptr::trace_record);
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    sptr::trace_record records[] = {
+        record(10, sptr::trace_op::make, 1),
+        record(40, sptr::trace_op::release, 1),
+        record(20, sptr::trace_op::copy, 1),
+        record(30, sptr::trace_op::release, 1),
+    };
+    bytes.insert(bytes.end(), reinterpret_cast<unsigned char*>(records),
+                 reinterpret_cast<unsigned char*>(records) + sizeof(records));
+    std::string path = temp_path("sorted.trace");
+    write_file(path, bytes.data(), bytes.size());
+
+    auto loaded = sptr::load_trace(path);
+    ASSERT_EQ(loaded.size(), 4u);
+    EXPECT_EQ(loaded[0].op, sptr::trace_op::make);
+    EXPECT_EQ(loaded[1].op, sptr::trace_op::copy);
+    EXPECT_EQ(loaded[2].timestamp_ns, 30u);
+    EXPECT_EQ(loaded[3].timestamp_ns, 40u);
+    std::remove(path.c_str());
+}
+
+TEST(TraceTests, RejectsOtherFiles) {
+    std::string path = temp_path("garbage.trace");
+    write_file(path, "not a trace at all", 18);
+    EXPECT_THROW(sptr::load_trace(path), std::runtime_error);
+    std::remove(path.c_str());
+    EXPECT_THROW(sptr::load_trace(temp_path("missing.trace")), std::runtime_error);
+}
+
+#if defined(SMART_PTR_KIT_TRACE)
+
+namespace {
+
+// Records of one block, in order
+std::vector<sptr::trace_op> ops_of(const std::vector<sptr::trace_record>& records, const void* block) {
+    std::vector<sptr::trace_op> ops;
+    for (const auto& r : records) {
+        if (r.block == reinterpret_cast<std::uintptr_t>(block)) ops.push_back(r.op);
+    }
+    return ops;
+}
+
+} // namespace
+
+TEST(TraceTests, RecordsLifecycle) {
+    std::string path = temp_path("lifecycle.trace");
+    sptr::set_trace_file(path);
+    const void* block = nullptr;
+    {
+        auto p = sptr::make_shared<long>(1);
+        block = sptr::detail::shared_access::control(p);
+        auto copy = p;
+        auto moved = std::move(copy);
+        sptr::weak_ptr<long> w(p);
+        auto locked = w.lock();
+        locked.reset();
+        moved.reset();
+        p.reset();
+        EXPECT_FALSE(w.lock());
+    }
+    sptr::flush_trace();
+    sptr::set_trace_file(temp_path("rest.trace"));
+
+    auto records = sptr::load_trace(path);
+    using op = sptr::trace_op;
+    std::vector<op> expected = {op::make, op::copy, op::move, op::lock, op::release,
+                                op::release, op::release, op::dispose, op::lock_failed};
+    EXPECT_EQ(ops_of(records, block), expected);
+    for (const auto& r : records) {
+        if (r.block == reinterpret_cast<std::uintptr_t>(block) && r.op == op::make) {
+            EXPECT_EQ(r.size, sizeof(long));
+        }
+    }
+    std::remove(path.c_str());
+}
+
+TEST(TraceTests, ThreadsGetTheirOwnIds) {
+    std::string path = temp_path("threads.trace");
+    sptr::set_trace_file(path);
+    auto p = sptr::make_shared<int>(0);
+    std::thread t([p] { auto copy = p; });
+    t.join();
+    sptr::flush_trace();
+    sptr::set_trace_file(temp_path("rest.trace"));
+
+    auto records = sptr::load_trace(path);
+    std::vector<std::uint16_t> threads;
+    for (const auto& r : records) {
+        if (std::find(threads.begin(), threads.end(), r.thread) == threads.end()) threads.push_back(r.thread);
+    }
+    EXPECT_GE(threads.size(), 2u);
+    std::remove(path.c_str());
+}
+
+#endif // SMART_PTR_KIT_TRACE
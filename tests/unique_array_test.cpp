@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include "unique_array.hpp"
+
+namespace {
+
+class Resource {
+public:
+    Resource() { constructed++; }
+    ~Resource() { destroyed++; }
+
+    static int constructed;
+    static int destroyed;
+    static void reset() {
+        constructed = 0;
+        destroyed = 0;
+    }
+};
+
+int Resource::constructed = 0;
+int Resource::destroyed = 0;
+
+bool aligned_to(const void* p, std::size_t alignment) {
+    return reinterpret_cast<std::uintptr_t>(p) % alignment == 0;
+}
+
+} // namespace
+
+class UniqueArrayTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Resource::reset();
+    }
+};
+
+TEST_F(UniqueArrayTests, IsPointerAndLength) {
+    static_assert(sizeof(sptr::unique_array<float>) == 2 * sizeof(void*), "pointer + size only");
+    static_assert(sizeof(sptr::unique_array<Resource>) == 2 * sizeof(void*), "pointer + size only");
+}
+
+TEST_F(UniqueArrayTests, SizedAndValueInitialized) {
+    auto a = sptr::make_unique_aligned<float[]>(37);
+    ASSERT_TRUE(a);
+    EXPECT_EQ(a.size(), 37u);
+    EXPECT_EQ(static_cast<std::size_t>(a.end() - a.begin()), 37u);
+    for (float f : a) {
+        EXPECT_EQ(f, 0.0f);
+    }
+    EXPECT_TRUE(aligned_to(a.data(), sptr::simd_width));
+}
+
+TEST_F(UniqueArrayTests, PaddedToVectorWidth) {
+    auto a = sptr::make_unique_aligned<double[]>(3);
+    EXPECT_EQ(a.padded_size(), sptr::simd_width / sizeof(double));
+    for (std::size_t i = a.size(); i < a.padded_size(); ++i) {
+        EXPECT_EQ(a[i], 0.0);
+    }
+
+    auto exact = sptr::make_unique_aligned<float[]>(32);
+    EXPECT_EQ(exact.padded_size(), 32u);
+}
+
+TEST_F(UniqueArrayTests, HonoursLargeAlignment) {
+    auto a = sptr::make_unique_aligned<std::uint8_t[]>(10, 4096);
+    EXPECT_TRUE(aligned_to(a.data(), 4096));
+    EXPECT_EQ(a.size(), 10u);
+}
+
+TEST_F(UniqueArrayTests, RejectsNonPowerOfTwoAlignment) {
+    EXPECT_THROW(sptr::make_unique_aligned<float[]>(8, 48), std::invalid_argument);
+}
+
+TEST_F(UniqueArrayTests, RejectsOverflowingLength) {
+    // n * 4 fits, but not once padded to a whole vector
+    EXPECT_THROW(sptr::make_unique_aligned<float[]>(SIZE_MAX / 4, sptr::simd_width, true), std::bad_alloc);
+    EXPECT_THROW(sptr::make_unique_aligned<float[]>(SIZE_MAX / 2, sptr::simd_width, true), std::bad_alloc);
+}
+
+TEST_F(UniqueArrayTests, DefaultInitLeavesBufferWritable) {
+    auto a = sptr::make_unique_aligned<int[]>(1000, sptr::simd_width, true);
+    std::iota(a.begin(), a.end(), 0);
+    EXPECT_EQ(a[999], 999);
+}
+
+TEST_F(UniqueArrayTests, DestroysEveryConstructedElement) {
+    {
+        auto a = sptr::make_unique_aligned<Resource[]>(5);
+        EXPECT_EQ(static_cast<std::size_t>(Resource::constructed), a.padded_size());
+    }
+    EXPECT_EQ(Resource::destroyed, Resource::constructed);
+}
+
+TEST_F(UniqueArrayTests, MoveTransfersOwnership) {
+    auto a = sptr::make_unique_aligned<int[]>(4);
+    int* data = a.data();
+    sptr::unique_array<int> b(std::move(a));
+    EXPECT_FALSE(a);
+    EXPECT_EQ(a.size(), 0u);
+    EXPECT_EQ(b.data(), data);
+
+    sptr::unique_array<int> c;
+    c = std::move(b);
+    EXPECT_EQ(c.data(), data);
+    EXPECT_EQ(c.size(), 4u);
+}
+
+TEST_F(UniqueArrayTests, EmptyArrayOwnsBuffer) {
+    auto a = sptr::make_unique_aligned<float[]>(0);
+    EXPECT_TRUE(a);
+    EXPECT_TRUE(a.empty());
+    EXPECT_EQ(a.begin(), a.end());
+}
@@ -1,4 +1,7 @@
 #include <gtest/gtest.h>
+#include <memory>
+#include "memory_domain.hpp"
+#include "pool_alloc.hpp"
 #include "unique_ptr.hpp"
 
 class Resource {
@@ -119,6 +122,117 @@ TEST_F(UniquePointerTests, MakeUnique) {
     EXPECT_EQ(ptr->value(), 42);
 }
 
+// Deleter with state, to check it travels with the pointer
+struct CountingDeleter {
+    int* calls = nullptr;
+    
+    void operator()(Resource* p) const {
+        ++*calls;
+        delete p;
+    }
+};
+
+TEST_F(UniquePointerTests, StatefulDeleterIsMoved) {
+    int calls = 0;
+    sptr::unique_ptr<Resource, CountingDeleter> ptr1(new Resource(1), CountingDeleter{&calls});
+    sptr::unique_ptr<Resource, CountingDeleter> ptr2(std::move(ptr1));
+    EXPECT_EQ(ptr2.get_deleter().calls, &calls);
+    
+    sptr::unique_ptr<Resource, CountingDeleter> ptr3;
+    ptr3 = std::move(ptr2);
+    ptr3.reset();
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(Resource::destroyed, 1);
+}
+
+struct AllocationCounters {
+    long allocated = 0;
+    long live = 0;
+};
+
+// Stateful allocator that counts what it hands out and gets back
+template <typename T>
+struct TrackingAllocator {
+    using value_type = T;
+    
+    explicit TrackingAllocator(AllocationCounters* c) noexcept : stats(c) {}
+    template <typename U>
+    TrackingAllocator(const TrackingAllocator<U>& other) noexcept : stats(other.stats) {}
+    
+    T* allocate(std::size_t n) {
+        stats->allocated += static_cast<long>(n);
+        stats->live += static_cast<long>(n);
+        return std::allocator<T>().allocate(n);
+    }
+    
+    void deallocate(T* p, std::size_t n) noexcept {
+        stats->live -= static_cast<long>(n);
+        std::allocator<T>().deallocate(p, n);
+    }
+    
+    AllocationCounters* stats;
+};
+
+TEST_F(UniquePointerTests, AllocateUniqueUsesTheAllocator) {
+    AllocationCounters stats;
+    {
+        // Rebound from char to Resource
+        auto ptr = sptr::allocate_unique<Resource>(TrackingAllocator<char>(&stats), 7);
+        EXPECT_EQ(ptr->value(), 7);
+        EXPECT_EQ(stats.allocated, 1);
+        EXPECT_EQ(stats.live, 1);
+        EXPECT_EQ(ptr.get_deleter().get_allocator().stats, &stats);
+        
+        auto moved = std::move(ptr);
+        EXPECT_FALSE(ptr);
+        EXPECT_EQ(Resource::destroyed, 0);
+    }
+    EXPECT_EQ(Resource::destroyed, 1);
+    EXPECT_EQ(stats.live, 0);
+}
+
+TEST_F(UniquePointerTests, AllocateUniqueArray) {
+    AllocationCounters stats;
+    {
+        auto arr = sptr::allocate_unique<Resource[]>(TrackingAllocator<Resource>(&stats), 5);
+        EXPECT_EQ(stats.live, 5);
+        EXPECT_EQ(arr.get_deleter().size(), 5u);
+        EXPECT_EQ(arr[4].id(), 4);
+        
+        auto ints = sptr::allocate_unique<int[]>(std::allocator<int>(), 3);
+        EXPECT_EQ(ints[0] + ints[1] + ints[2], 0);
+        
+        auto empty = sptr::allocate_unique<int[]>(TrackingAllocator<int>(&stats), 0);
+        EXPECT_EQ(empty.get_deleter().size(), 0u);
+    }
+    EXPECT_EQ(Resource::destroyed, 5);
+    EXPECT_EQ(stats.live, 0);
+}
+
+TEST_F(UniquePointerTests, AllocateUniqueFromPoolAndDomain) {
+    auto pooled = sptr::allocate_unique<Resource>(sptr::pool_allocator<Resource>(), 3);
+    EXPECT_EQ(pooled->value(), 3);
+    
+    sptr::memory_domain domain("unique");
+    {
+        auto charged = sptr::allocate_unique<Resource>(sptr::domain_allocator<Resource>(domain), 4);
+        EXPECT_EQ(domain.live_bytes_exact(), sizeof(Resource));
+    }
+    EXPECT_EQ(domain.live_bytes_exact(), 0u);
+}
+
+TEST_F(UniquePointerTests, AllocatorDeleterSizes) {
+    constexpr std::size_t word = sizeof(void*);
+    // Stateless allocators add nothing
+    EXPECT_EQ(sizeof(sptr::unique_ptr<int, sptr::allocator_delete<std::allocator<int>>>), word);
+    EXPECT_EQ(sizeof(sptr::unique_ptr<int, sptr::allocator_delete<sptr::pool_allocator<int>>>), word);
+    // Stateful ones are stored as they are
+    EXPECT_EQ(sizeof(sptr::unique_ptr<int, sptr::allocator_delete<sptr::domain_allocator<int>>>), 2 * word);
+    // Arrays also carry their length
+    EXPECT_EQ(sizeof(sptr::unique_ptr<int[], sptr::allocator_array_delete<std::allocator<int>>>), 2 * word);
+    EXPECT_EQ(sizeof(sptr::unique_ptr<int[], sptr::allocator_array_delete<sptr::domain_allocator<int>>>), 3 * word);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
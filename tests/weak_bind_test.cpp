@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "weak_bind.hpp"
+
+namespace {
+
+class Connection {
+public:
+    explicit Connection(int id = 0) : id(id) {}
+    virtual ~Connection() { destroyed++; }
+
+    void on_read(int bytes) {
+        received += bytes;
+    }
+
+    int id_plus(int n) const {
+        return id + n;
+    }
+
+    void fail() {
+        throw std::runtime_error("read failed");
+    }
+
+    virtual void on_close() {
+        closed = 1;
+    }
+
+    int id;
+    std::atomic<int> received{0};
+    int closed = 0;
+
+    static std::atomic<int> destroyed;
+    static void reset() { destroyed = 0; }
+};
+
+std::atomic<int> Connection::destroyed{0};
+
+class TlsConnection : public Connection {
+public:
+    void on_close() override {
+        closed = 2;
+    }
+};
+
+} // namespace
+
+class WeakBindTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Connection::reset();
+    }
+};
+
+TEST_F(WeakBindTests, CallsMemberWhileAlive) {
+    auto conn = sptr::make_shared<Connection>(7);
+    auto handler = sptr::weak_bind(&Connection::on_read, conn);
+    EXPECT_TRUE(handler(10));
+    EXPECT_TRUE(handler(5));
+    EXPECT_EQ(conn->received, 15);
+    // The binder does not own the connection
+    EXPECT_EQ(conn.use_count(), 1);
+}
+
+TEST_F(WeakBindTests, DoesNothingOnceExpired) {
+    auto conn = sptr::make_shared<Connection>(7);
+    auto handler = sptr::weak_bind(&Connection::on_read, conn);
+    conn.reset();
+    EXPECT_EQ(Connection::destroyed, 1);
+    EXPECT_TRUE(handler.expired());
+    EXPECT_FALSE(handler(10));
+}
+
+TEST_F(WeakBindTests, ReturnsOptionalResults) {
+    auto conn = sptr::make_shared<Connection>(40);
+    auto query = sptr::weak_bind(&Connection::id_plus, conn);
+    std::optional<int> r = query(2);
+    ASSERT_TRUE(r);
+    EXPECT_EQ(*r, 42);
+    conn.reset();
+    EXPECT_FALSE(query(2));
+}
+
+TEST_F(WeakBindTests, DispatchesVirtualMembers) {
+    sptr::shared_ptr<Connection> conn = sptr::make_shared<TlsConnection>();
+    auto close = sptr::weak_bind(&Connection::on_close, conn);
+    EXPECT_TRUE(close());
+    EXPECT_EQ(conn->closed, 2);
+}
+
+TEST_F(WeakBindTests, FitsInFourWords) {
+    auto conn = sptr::make_shared<Connection>();
+    auto handler = sptr::weak_bind(&Connection::on_close, conn);
+    EXPECT_LE(sizeof(handler), 32u);
+    EXPECT_TRUE(std::is_nothrow_copy_constructible_v<decltype(handler)>);
+}
+
+TEST_F(WeakBindTests, ReleasesReferenceWhenMemberThrows) {
+    auto conn = sptr::make_shared<Connection>();
+    auto handler = sptr::weak_bind(&Connection::fail, conn);
+    EXPECT_THROW(handler(), std::runtime_error);
+    EXPECT_EQ(conn.use_count(), 1);
+}
+
+TEST_F(WeakBindTests, BindsFromWeakPtrAndStoresInFunction) {
+    auto conn = sptr::make_shared<Connection>();
+    sptr::weak_ptr<Connection> weak(conn);
+    std::function<void(int)> callback = sptr::weak_bind(&Connection::on_read, weak);
+    callback(3);
+    EXPECT_EQ(conn->received, 3);
+    conn.reset();
+    callback(3);
+    EXPECT_EQ(Connection::destroyed, 1);
+}
+
+TEST_F(WeakBindTests, RacesWithLastRelease) {
+    for (int round = 0; round < 200; ++round) {
+        auto conn = sptr::make_shared<Connection>();
+        auto handler = sptr::weak_bind(&Connection::on_read, conn);
+        std::thread caller([handler] {
+            for (int i = 0; i < 100; ++i) {
+                handler(1);
+            }
+        });
+        conn.reset();
+        caller.join();
+    }
+    EXPECT_EQ(Connection::destroyed, 200);
+}
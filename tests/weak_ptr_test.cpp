@@ -1,4 +1,6 @@
 #include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
 #include "weak_ptr.hpp"
 
 class Resource {
@@ -159,6 +161,45 @@ TEST_F(WeakPointerTests, MoveAssignment) {
     EXPECT_EQ(locked->value(), 123);
 }
 
+// An object holding a weak_ptr to itself releases it from inside dispose()
+struct SelfObserver {
+    sptr::weak_ptr<SelfObserver> self;
+};
+
+TEST_F(WeakPointerTests, WeakSelfReferenceReleasedDuringDispose) {
+    sptr::weak_ptr<SelfObserver> outside;
+    {
+        auto shared = sptr::make_shared<SelfObserver>();
+        shared->self = shared;
+        outside = shared;
+    }
+    EXPECT_TRUE(outside.expired());
+    
+    {
+        auto shared = sptr::make_shared<SelfObserver>();
+        shared->self = shared;
+    }
+}
+
+TEST_F(WeakPointerTests, WaitUntilExpired) {
+    sptr::shared_ptr<Resource> shared(new Resource(1));
+    sptr::weak_ptr<Resource> weak(shared);
+    EXPECT_FALSE(weak.wait_until_expired(std::chrono::milliseconds(20)));
+
+    std::thread owner([held = std::move(shared)]() mutable {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        held.reset();
+    });
+    EXPECT_TRUE(weak.wait_until_expired(std::chrono::seconds(10)));
+    EXPECT_TRUE(weak.expired());
+    EXPECT_FALSE(weak.lock());
+    owner.join();
+    EXPECT_EQ(Resource::destroyed, 1);
+
+    sptr::weak_ptr<Resource> empty;
+    EXPECT_TRUE(empty.wait_until_expired(std::chrono::milliseconds(0)));
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
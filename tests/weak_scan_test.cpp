@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <iterator>
+#include <thread>
+#include <vector>
+#include "relocate.hpp"
+#include "weak_scan.hpp"
+
+namespace {
+
+class Resource {
+public:
+    explicit Resource(int v = 0) : value(v) {}
+    ~Resource() { destroyed++; }
+
+    int value;
+
+    static std::atomic<int> destroyed;
+    static void reset() { destroyed = 0; }
+};
+
+std::atomic<int> Resource::destroyed{0};
+
+} // namespace
+
+class WeakScanTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Resource::reset();
+        for (int i = 0; i < 100; ++i) {
+            owners.push_back(sptr::make_shared<Resource>(i));
+            weak.push_back(owners.back());
+        }
+        // Expire every third entry and add a few empty ones
+        for (int i = 0; i < 100; i += 3) {
+            owners[static_cast<std::size_t>(i)].reset();
+        }
+        weak.insert(weak.begin() + 10, sptr::weak_ptr<Resource>());
+        weak.push_back(sptr::weak_ptr<Resource>());
+    }
+
+    static bool alive(int i) {
+        return i % 3 != 0;
+    }
+
+    std::vector<sptr::shared_ptr<Resource>> owners;
+    std::vector<sptr::weak_ptr<Resource>> weak;
+};
+
+TEST_F(WeakScanTests, LockAllSkipsExpired) {
+    std::vector<sptr::shared_ptr<Resource>> locked;
+    sptr::lock_all(weak, std::back_inserter(locked));
+    ASSERT_EQ(locked.size(), 66u);
+    for (auto& p : locked) {
+        EXPECT_TRUE(alive(p->value));
+        EXPECT_EQ(p.use_count(), 2);
+    }
+    EXPECT_EQ(weak.size(), 102u);
+}
+
+TEST_F(WeakScanTests, LockAllCompactsInSamePass) {
+    std::vector<sptr::shared_ptr<Resource>> locked;
+    sptr::lock_all(weak, std::back_inserter(locked), sptr::compact_expired);
+    ASSERT_EQ(weak.size(), 66u);
+    ASSERT_EQ(locked.size(), 66u);
+    for (std::size_t i = 0; i < weak.size(); ++i) {
+        // Order of the survivors is preserved
+        EXPECT_EQ(weak[i].lock().get(), locked[i].get());
+    }
+}
+
+TEST_F(WeakScanTests, ForEachAliveCountsAndVisits) {
+    int sum = 0;
+    std::size_t n = sptr::for_each_alive(weak, [&](Resource& r) { sum += r.value; });
+    int expected = 0;
+    for (int i = 0; i < 100; ++i) {
+        if (alive(i)) expected += i;
+    }
+    EXPECT_EQ(n, 66u);
+    EXPECT_EQ(sum, expected);
+}
+
+TEST_F(WeakScanTests, ForEachAliveCompactsRelocatingVector) {
+    sptr::relocating_vector<sptr::weak_ptr<Resource>> v;
+    for (auto& w : weak) v.push_back(w);
+    std::size_t n = sptr::for_each_alive(v, [](Resource&) {}, sptr::compact_expired);
+    EXPECT_EQ(n, 66u);
+    EXPECT_EQ(v.size(), 66u);
+    for (auto& w : v) {
+        EXPECT_FALSE(w.expired());
+    }
+}
+
+TEST_F(WeakScanTests, ObjectKeptAliveDuringCallback) {
+    std::size_t n = sptr::for_each_alive(weak, [&](Resource& r) {
+        if (r.value == 1) {
+            owners[1].reset();
+            EXPECT_EQ(r.value, 1);
+        }
+    });
+    EXPECT_EQ(n, 66u);
+    EXPECT_TRUE(weak[1].expired());
+}
+
+TEST_F(WeakScanTests, LockRacesWithLastRelease) {
+    int before = Resource::destroyed;
+    for (int round = 0; round < 200; ++round) {
+        auto owner = sptr::make_shared<Resource>(round);
+        sptr::weak_ptr<Resource> w(owner);
+        std::atomic<bool> go{false};
+        std::thread releaser([&] {
+            while (!go) {}
+            owner.reset();
+        });
+        go = true;
+        while (auto p = w.lock()) {
+            // A successful lock must never see a destroyed object
+            EXPECT_EQ(p->value, round);
+        }
+        releaser.join();
+        EXPECT_TRUE(w.expired());
+    }
+    EXPECT_EQ(Resource::destroyed - before, 200);
+}